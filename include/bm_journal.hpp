@@ -0,0 +1,108 @@
+// bm_journal.hpp
+#pragma once
+
+#include "common.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
+#include <json.hpp>
+
+namespace halfMesh {
+    class triMesh;
+
+    struct JournalOptions {
+        // Compact in the background once the appended records outgrow this
+        // multiple of the base document; 0 turns automatic compaction off
+        double compact_ratio = 1.0;
+    };
+
+    //
+    // Journaled .bm saving for meshes that are saved after every edit.
+    //
+    // The first save writes a plain .bm document. Every later save appends
+    // one BSON record holding only what changed since the previous save:
+    // added, moved and deleted vertices, added and deleted faces, and JSON
+    // patches of the property stores. triMesh::read replays the records
+    // after the base document; a torn last record (interrupted save) is
+    // ignored.
+    //
+    // Compaction folds the records back into a single document. It is
+    // written to a temporary file on io_thread_pool() and swapped in by the
+    // next save (or flush), so saves never wait for it.
+    //
+    // Every write is synced to the disk before it counts: each save's base
+    // or record, the compacted temporary with the records appended to it,
+    // and the directory after the file is created or swapped. So the file
+    // on disk holds the full history at every point, also after a crash.
+    // (Platforms without fsync or _commit fall back to a stream flush.)
+    //
+    // Vertices and faces are matched by handle. Changes to edge and
+    // half-edge properties rely on the replayed faces producing the same
+    // edge handles, i.e. on faces being added in handle order.
+    //
+    class bm_journal {
+    public:
+        explicit bm_journal(std::string filename, JournalOptions options = JournalOptions());
+
+        // Waits for a running compaction and swaps it in
+        ~bm_journal();
+
+        bm_journal(const bm_journal &) = delete;
+
+        bm_journal &operator=(const bm_journal &) = delete;
+
+        // Write the base document on the first call, then a delta record.
+        // Returns the number of bytes written (0 if nothing changed).
+        // Throws std::runtime_error if the file cannot be written.
+        std::uintmax_t save(const triMesh &mesh);
+
+        // Start compacting now unless a compaction is already running
+        void compact();
+
+        // Wait for a running compaction and swap it in
+        void flush();
+
+        const std::string &filename() const { return filename_; }
+
+        std::size_t records() const { return records_; } // delta records after the base document
+        std::uintmax_t base_bytes() const { return base_bytes_; }
+        std::uintmax_t journal_bytes() const { return journal_bytes_; }
+
+    private:
+        // The mesh as of a save, indexed by handle
+        struct Snapshot {
+            std::vector<std::array<double, 3> > positions;
+            std::vector<char> has_vertex;
+            std::vector<std::array<unsigned, 3> > faces;
+            std::vector<char> has_face;
+            nlohmann::json properties[4]; // vertex, edge, face, half-edge stores
+        };
+
+        static std::shared_ptr<const Snapshot> take_snapshot(const triMesh &mesh);
+
+        // The whole snapshot as one .bm document
+        static std::string base_document(const Snapshot &s);
+
+        // Record turning before into after; empty if they are equal
+        static std::string delta_record(const Snapshot &before, const Snapshot &after);
+
+        void append(const std::string &bytes, const std::string &path);
+
+        void finish_compaction(bool wait);
+
+        std::string filename_;
+        JournalOptions options_;
+        std::shared_ptr<const Snapshot> last_;
+        std::size_t records_ = 0;
+        std::uintmax_t base_bytes_ = 0;
+        std::uintmax_t journal_bytes_ = 0;
+
+        // Running compaction and the records saved since it started
+        std::future<IoResult> compaction_;
+        std::vector<std::string> pending_records_;
+    };
+} // namespace halfMesh
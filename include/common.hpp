@@ -1,5 +1,11 @@
 #pragma once
 
+#include <algorithm>
+#include <cctype>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
 #include <vector>
 #include <Eigen/Dense>
 
@@ -23,7 +29,11 @@ namespace halfMesh {
         Gmsh = 100,
         Stl = 200,
         Binary = 300,
+        Obj = 400,
         Vtk = 500,
+        Ply = 600,
+        Glb = 700,
+        Compressed = 800,
         Unknown = 999
     };
 
@@ -45,6 +55,105 @@ namespace halfMesh {
         CouldNotAdd
     };
 
+    // --- Async I/O results ---
+    enum class IoStatus {
+        Ok,
+        UnknownFormat,
+        Failed
+    };
+
+    struct IoResult {
+        IoStatus status = IoStatus::Ok;
+        std::uintmax_t bytes = 0; // bytes written by a save / read by a read
+        std::string message; // error description when status != Ok
+    };
+
+    // --- Mass properties ---
+    // Solid properties of a closed mesh at unit density. volume is signed
+    // (negative for inward facing triangles); centroid and inertia do not
+    // depend on the orientation. Open meshes get the area weighted surface
+    // centroid and zero inertia.
+    struct MassProperties {
+        double area = 0.0;
+        double volume = 0.0;
+        Eigen::Vector3d centroid = Eigen::Vector3d::Zero();
+        Eigen::Matrix3d inertia = Eigen::Matrix3d::Zero(); // about the centroid
+    };
+
+    // --- Manifold validation ---
+    // Result of triMesh::check_manifold(), offending handles in mesh order.
+    // The endpoints of a non-manifold or inconsistently oriented edge are
+    // reported through that edge only; their fans cannot be walked.
+    struct ManifoldReport {
+        bool edge_manifold = true; // no edge has more than two faces
+        bool vertex_manifold = true; // the faces around each vertex form a single fan
+        bool oriented = true; // faces sharing an edge run it in opposite directions
+        std::size_t edges = 0; // edges used by at least one face
+        std::size_t boundary_edges = 0;
+        std::vector<unsigned> non_manifold_edges;
+        std::vector<unsigned> inconsistent_edges;
+        std::vector<unsigned> non_manifold_vertices;
+
+        bool manifold() const { return edge_manifold && vertex_manifold; }
+
+        bool watertight() const { return edge_manifold && boundary_edges == 0; }
+    };
+
+    // --- Topology summary ---
+    // Result of triMesh::topology_summary(). edges counts the edges used by
+    // a face; components without faces (lone vertices) do not add to genus.
+    struct TopologySummary {
+        std::size_t vertices = 0;
+        std::size_t edges = 0;
+        std::size_t faces = 0;
+        std::size_t boundary_edges = 0;
+        std::size_t boundary_loops = 0;
+        std::size_t components = 0;
+        int euler_characteristic = 0; // V - E + F
+        int genus = 0; // summed over the components
+        bool edge_manifold = true;
+        bool manifold = true;
+        bool oriented = true;
+
+        bool has_boundary() const { return boundary_edges > 0; }
+
+        bool watertight() const { return edge_manifold && boundary_edges == 0; }
+    };
+
+    // --- Connected components ---
+    // Result of triMesh::connected_components(). Labels are indexed by
+    // handle, numbered from 0 in order of each component's lowest vertex
+    // handle, and max() where a handle is unused. A vertex without faces
+    // is a component of its own.
+    struct ComponentLabels {
+        std::size_t count = 0;
+        std::vector<unsigned> vertex_labels;
+        std::vector<unsigned> face_labels;
+        std::vector<std::size_t> vertex_counts; // per component
+        std::vector<std::size_t> face_counts;
+    };
+
+    // --- Boundary loops ---
+    // Result of triMesh::boundary_loops(): the half-edges without an
+    // opposite, loop by loop in walking order, and the vertex each one
+    // leaves. Loop i is [offsets[i], offsets[i + 1]).
+    struct BoundaryLoops {
+        std::vector<unsigned> half_edges;
+        std::vector<unsigned> vertices;
+        std::vector<std::size_t> offsets{0};
+
+        std::size_t size() const { return offsets.size() - 1; }
+    };
+
+    // --- Vertex normal weighting ---
+    // How the normals of the faces around a vertex are blended: by face
+    // area, by the corner angle at the vertex, or equally
+    enum class NormalWeighting {
+        Area,
+        Angle,
+        Uniform
+    };
+
     // Some string related utilities
     // Convert a copy of s to lowercase
     inline std::string to_lower(std::string s) {
@@ -83,6 +192,51 @@ namespace halfMesh {
         if (ends_with(s, ".stl")) return MeshType::Stl;
         if (ends_with(s, ".bm")) return MeshType::Binary;
         if (ends_with(s, ".vtk")) return MeshType::Vtk;
+        if (ends_with(s, ".obj")) return MeshType::Obj;
+        if (ends_with(s, ".ply")) return MeshType::Ply;
+        if (ends_with(s, ".glb")) return MeshType::Glb;
+        if (ends_with(s, ".hmc")) return MeshType::Compressed;
+        return MeshType::Unknown;
+    }
+
+    // Detect the format from the first bytes of a file or buffer
+    inline MeshType detect_mesh_format(const std::byte *data, std::size_t size) {
+        const auto *c = reinterpret_cast<const char *>(data);
+        const auto read_u32 = [c](std::size_t at) {
+            std::uint32_t v = 0;
+            for (int i = 3; i >= 0; --i) v = (v << 8) | static_cast<unsigned char>(c[at + i]);
+            return v;
+        };
+        const auto has_prefix = [c, size](std::size_t at, const char *magic) {
+            const std::size_t n = std::char_traits<char>::length(magic);
+            return at + n <= size && std::equal(magic, magic + n, c + at);
+        };
+        std::size_t text = 0; // first non-blank byte
+        while (text < size && std::isspace(static_cast<unsigned char>(c[text]))) ++text;
+
+        if (has_prefix(0, "ply\n") || has_prefix(0, "ply\r\n")) return MeshType::Ply;
+        if (has_prefix(text, "$MeshFormat")) return MeshType::Gmsh;
+        if (has_prefix(0, "glTF")) return MeshType::Glb;
+        if (has_prefix(0, "HMC") && size > 3 && c[3] == 1) return MeshType::Compressed;
+        if (has_prefix(text, "# vtk DataFile")) return MeshType::Vtk;
+        // binary STL: 80 byte header, triangle count, 50 bytes per triangle.
+        // Checked before "solid" since many binary headers start with it.
+        if (size >= 84 && 84 + 50 * static_cast<std::uint64_t>(read_u32(80)) == size) return MeshType::Stl;
+        if (has_prefix(text, "solid")) return MeshType::Stl;
+        // .bm: a BSON document, length prefixed and null terminated
+        if (size >= 5) {
+            const std::uint32_t len = read_u32(0);
+            if (len >= 5 && len <= size && c[len - 1] == 0 && (len == 5 || (c[4] >= 0x01 && c[4] <= 0x13)))
+                return MeshType::Binary;
+        }
+        // OBJ: first statement (skipping comments) is an OBJ keyword
+        std::size_t p = text;
+        while (p < size && c[p] == '#') {
+            while (p < size && c[p] != '\n') ++p;
+            while (p < size && std::isspace(static_cast<unsigned char>(c[p]))) ++p;
+        }
+        for (const char *kw: {"v ", "vt ", "vn ", "f ", "o ", "g ", "s ", "mtllib ", "usemtl "})
+            if (has_prefix(p, kw)) return MeshType::Obj;
         return MeshType::Unknown;
     }
 
@@ -19,11 +19,13 @@ namespace halfMesh {
         std::shared_ptr<vertex> get_vertex_two() const { return v2_.lock(); }
         unsigned int get_handle() const { return handle_; }
         bool is_boundary() const { return boundary_; }
+        unsigned int get_face_count() const { return face_count_; } // faces using this edge
         std::shared_ptr<halfedge> get_one_half_edge() const { return one_half_edge_.lock(); }
 
         //— Mutators ——
         void set_handle(const unsigned int h) { handle_ = h; }
         void set_boundary(const bool b) { boundary_ = b; }
+        void set_face_count(const unsigned int n) { face_count_ = n; }
         void set_one_half_edge(const std::shared_ptr<halfedge>& he) { one_half_edge_ = he; }
 
     private:
@@ -31,5 +33,6 @@ namespace halfMesh {
         unsigned int handle_ = std::numeric_limits<unsigned>::max();
         std::weak_ptr<halfedge> one_half_edge_;
         bool boundary_ = false;
+        unsigned int face_count_ = 0;
     };
 } // namespace HalfMesh
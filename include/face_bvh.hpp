@@ -0,0 +1,127 @@
+// face_bvh.hpp
+#pragma once
+
+#include "common.hpp"
+#include "geometry_kernels.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace halfMesh {
+    class triMesh;
+
+    // A ray for face_bvh queries; hits count for t in [t_min, t_max], in
+    // units of direction (which need not be unit length)
+    struct Ray {
+        Eigen::Vector3d origin = Eigen::Vector3d::Zero();
+        Eigen::Vector3d direction = Eigen::Vector3d::UnitZ();
+        double t_min = 0.0;
+        double t_max = std::numeric_limits<double>::infinity();
+    };
+
+    struct RayHit {
+        unsigned face = std::numeric_limits<unsigned>::max(); // handle, max() for a miss
+        double t = std::numeric_limits<double>::infinity();
+        double u = 0.0, v = 0.0; // hit = (1 - u - v) a + u b + v c over the face corners
+
+        bool hit() const { return face != std::numeric_limits<unsigned>::max(); }
+    };
+
+    struct ClosestPoint {
+        unsigned face = std::numeric_limits<unsigned>::max(); // max() if nothing within reach
+        Eigen::Vector3d point = Eigen::Vector3d::Zero();
+        double distance = std::numeric_limits<double>::infinity();
+    };
+
+    //
+    // Bounding volume hierarchy over the faces of a triMesh.
+    //
+    // The build bins face centroids along each axis and splits where the
+    // surface area heuristic is lowest; large ranges bin and recurse in
+    // parallel on the library scheduler. Nodes live in one depth-first
+    // array of 32-byte entries (float bounds rounded outwards), the left
+    // child of an inner node right after it. Triangles are copied in leaf
+    // order, one array per coordinate, so queries do not touch the mesh and
+    // leaves are tested four triangles at a time by the AVX2 kernel. The
+    // batch queries trace coherent packets of rays, testing a node's box
+    // against four rays at a time.
+    //
+    // refit() pulls moved vertex positions from the same mesh and
+    // recomputes the bounds bottom-up; the tree shape is kept, so queries
+    // slow down if the geometry moves a lot. Any topology change needs a
+    // new build.
+    //
+    class face_bvh {
+    public:
+        face_bvh() = default;
+
+        explicit face_bvh(const triMesh &mesh, unsigned max_leaf_size = 4);
+
+        void build(const triMesh &mesh, unsigned max_leaf_size = 4);
+
+        // Throws std::runtime_error if the mesh topology changed since the build
+        void refit(const triMesh &mesh);
+
+        // Nearest hit along the ray; of faces hit at the same distance the
+        // first in leaf order wins
+        RayHit intersect(const Ray &ray) const;
+
+        // Any hit along the ray, stopping at the first one found
+        bool occluded(const Ray &ray) const;
+
+        // Batches, result i for rays[i], equal to the single ray queries.
+        // Rays are taken in the given order, detail::kPacketLanes at a
+        // time; a packet whose directions share an octant traverses the
+        // tree as one, testing each node's box against all its active
+        // rays, and falls back to single rays where only a few remain.
+        // Neighbouring rays should be coherent (e.g. camera rays in scan
+        // order) to gain anything. Packets go in parallel on the scheduler.
+        void intersect(const Ray *rays, std::size_t count, RayHit *hits) const;
+        std::vector<RayHit> intersect(const std::vector<Ray> &rays) const;
+        void occluded(const Ray *rays, std::size_t count, std::uint8_t *result) const;
+        std::vector<std::uint8_t> occluded(const std::vector<Ray> &rays) const;
+
+        // Closest point on the surface, or nothing farther than max_distance
+        ClosestPoint closest_point(const Eigen::Vector3d &p,
+                                   double max_distance = std::numeric_limits<double>::infinity()) const;
+
+        //— Accessors ——
+        bool empty() const { return faces_.empty(); }
+        std::size_t size() const { return faces_.size(); }
+        std::size_t node_count() const { return nodes_.size(); }
+        Eigen::AlignedBox3d bounds() const;
+
+    private:
+        struct Node {
+            float lo[3], hi[3];
+            std::uint32_t index; // leaf: first triangle, inner: right child
+            std::uint32_t count; // triangles in a leaf, 0 for an inner node
+        };
+
+        static_assert(sizeof(Node) == 32, "face_bvh nodes are 32 bytes");
+
+        // Recompute the bounds of every node from the triangles
+        void update_bounds();
+
+        // Nearest hit in the subtree at root that is closer than t_max, or
+        // as close and first in leaf order; updates all three
+        void trace(const Ray &ray, std::uint32_t root, double &t_max, std::size_t &nearest, RayHit &hit) const;
+
+        // Any hit in the subtree at root
+        bool any_hit(const Ray &ray, std::uint32_t root) const;
+
+        // Trace rays[0, count) (count up to detail::kPacketLanes) through
+        // the tree together
+        void intersect_packet(const Ray *rays, std::size_t count, RayHit *hits) const;
+
+        void occluded_packet(const Ray *rays, std::size_t count, std::uint8_t *result) const;
+
+        std::vector<Node> nodes_;
+        detail::TriangleBatch triangles_; // corners in leaf order
+        std::vector<unsigned> faces_; // face handles in leaf order
+        std::vector<std::array<unsigned, 3> > corners_; // vertex handles in leaf order
+        std::uint64_t topology_version_ = 0;
+    };
+} // namespace halfMesh
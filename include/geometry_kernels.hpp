@@ -0,0 +1,110 @@
+// geometry_kernels.hpp
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace halfMesh::detail {
+    //
+    // Batched per-triangle moments over flat coordinate arrays.
+    //
+    // Every sum is kept in 4 lanes (triangle i goes to lane i % 4) with a
+    // TwoSum error term per lane. The AVX2 kernel and the scalar fallback
+    // do the same operations in the same order, so they agree bit for bit,
+    // and merging batches in a fixed order makes a parallel reduction
+    // independent of the thread count.
+    //
+    struct TriangleMoments {
+        // Term layout, per triangle a, b, c with s = a + b + c,
+        // n = (b - a) x (c - a) and d = a . (b x c):
+        enum Term {
+            Area2 = 0, // |n|
+            Det = 1, // d
+            DetS = 2, // d * s (x, y, z)
+            DetCov = 5, // d * (aa' + bb' + cc' + ss') (xx, yy, zz, xy, xz, yz)
+            Area2S = 11, // |n| * s (x, y, z)
+            Count = 14
+        };
+
+        static constexpr int kLanes = 4;
+
+        double sum[Count][kLanes] = {};
+        double error[Count][kLanes] = {};
+
+        // Add another batch lane by lane
+        void merge(const TriangleMoments &other);
+
+        // Lanes combined in a fixed order, errors folded in last
+        double total(int term) const;
+    };
+
+    // Corner coordinates of up to capacity triangles, one array per component
+    struct TriangleBatch {
+        std::vector<double> ax, ay, az, bx, by, bz, cx, cy, cz;
+
+        void resize(std::size_t n);
+    };
+
+    // Accumulate triangles [0, n) of batch; first is the index of triangle 0
+    // in the whole stream and picks the lanes
+    void accumulate_moments(const TriangleBatch &batch, std::size_t n, std::size_t first,
+                            TriangleMoments &moments);
+
+    // Unit normal and area of triangles [0, n) of batch; degenerate
+    // triangles get a zero normal
+    void triangle_normals(const TriangleBatch &batch, std::size_t n,
+                          double *nx, double *ny, double *nz, double *area);
+
+    // Component-wise min / max of n points, folded into lo / hi
+    void extend_bounds(const double *x, const double *y, const double *z, std::size_t n,
+                       double lo[3], double hi[3]);
+
+    // Nearest of triangles [begin, end) of batch crossed by the ray
+    // origin + t direction with t in [t_min, t_max] (Moller-Trumbore, either
+    // side). On a hit t_max, u and v take its values and its index is
+    // returned, otherwise end. Equal distances keep the first triangle; the
+    // AVX2 kernel tests four triangles at a time and agrees with the scalar
+    // one bit for bit. Arrays holding three more triangles than end let a
+    // short range run in the AVX2 kernel as well.
+    std::size_t nearest_hit(const TriangleBatch &batch, std::size_t begin, std::size_t end,
+                            const double origin[3], const double direction[3],
+                            double t_min, double &t_max, double &u, double &v);
+
+    // Rays traced through a tree together, one array per component and
+    // lane i for ray i of the packet
+    constexpr std::size_t kPacketLanes = 16;
+
+    struct RayLanes {
+        alignas(32) double origin[3][kPacketLanes];
+        alignas(32) double direction[3][kPacketLanes];
+        alignas(32) double inverse[3][kPacketLanes]; // 1 / direction
+        alignas(32) double t_min[kPacketLanes];
+        alignas(32) double t_max[kPacketLanes];
+    };
+
+    // Lanes of active (bit i for lane i) whose [t_min, t_max] reaches into
+    // the box [lo, hi] (slab test; NaNs from 0 * inf are skipped). The AVX2
+    // kernel tests four lanes at a time and agrees with the scalar one.
+    std::uint32_t lanes_entering_box(const RayLanes &rays, std::uint32_t active,
+                                     const float lo[3], const float hi[3]);
+
+    // nearest_hit for the active lanes over triangles [begin, end) of
+    // batch. A lane takes triangle i when it is crossed at t in
+    // [t_min, t_max] with t < t_max, or t == t_max and i < nearest[lane];
+    // its t_max, nearest, u and v then follow. Returns the lanes that took
+    // a triangle. The AVX2 kernel tests four lanes at a time and agrees
+    // with nearest_hit bit for bit.
+    std::uint32_t nearest_hits(const TriangleBatch &batch, std::size_t begin, std::size_t end,
+                               RayLanes &rays, std::uint32_t active, std::size_t *nearest,
+                               double *u, double *v);
+
+    // True when the AVX2 kernels are compiled in, the CPU supports them and
+    // they are enabled
+    bool simd_kernels_active();
+
+    // Switch the AVX2 kernels off (or back on) for the whole process, e.g.
+    // to check them against the scalar path a -DHALFMESH_SIMD=OFF build
+    // runs. Not to be called while a kernel is running.
+    void enable_simd_kernels(bool enabled);
+} // namespace halfMesh::detail
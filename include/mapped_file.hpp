@@ -0,0 +1,36 @@
+// mapped_file.hpp
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace halfMesh {
+    //
+    // Read-only view of a whole file. On POSIX systems the file is memory
+    // mapped; elsewhere it falls back to reading the file into a buffer.
+    //
+    class mapped_file {
+    public:
+        explicit mapped_file(const std::string &filename);
+
+        ~mapped_file();
+
+        mapped_file(const mapped_file &) = delete;
+
+        mapped_file &operator=(const mapped_file &) = delete;
+
+        //— Accessors ——
+        const char *data() const { return data_; }
+        std::size_t size() const { return size_; }
+        bool empty() const { return size_ == 0; }
+
+    private:
+        const char *data_ = nullptr;
+        std::size_t size_ = 0;
+        bool mapped_ = false;
+
+        // fallback storage when mapping is unavailable
+        std::vector<char> buffer_;
+    };
+} // namespace halfMesh
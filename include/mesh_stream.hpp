@@ -0,0 +1,98 @@
+// mesh_stream.hpp
+#pragma once
+
+#include "common.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace halfMesh {
+    //
+    // Streaming triangle soup I/O. Files are read and written in bounded
+    // chunks of triangles without ever building the half-edge structure,
+    // so format conversion runs with flat memory on arbitrarily large files.
+    //
+
+    // A batch of triangles: three corner positions per triangle, and the
+    // zero based vertex indices of those corners as numbered in the file.
+    // Formats without shared vertices (STL) number every corner on its own.
+    struct TriangleChunk {
+        std::vector<std::array<double, 3> > positions;
+        std::vector<std::array<std::uint64_t, 3> > indices;
+        std::uint64_t first_triangle = 0; // index of the first triangle in the whole stream
+
+        std::size_t size() const { return indices.size(); }
+
+        // Summed area of the chunk's triangles
+        double surface_area() const;
+
+        // Axis aligned bounds of the corners as {min, max}; min > max when empty
+        std::pair<std::array<double, 3>, std::array<double, 3> > bounding_box() const;
+    };
+
+    // Pulls triangles out of a file one chunk at a time
+    class triangle_source {
+    public:
+        virtual ~triangle_source() = default;
+
+        // Fill chunk with up to max_triangles triangles; false once the file is exhausted
+        virtual bool next(TriangleChunk &chunk, std::size_t max_triangles) = 0;
+
+        // true if the file stores coordinates in single precision
+        virtual bool single_precision() const { return false; }
+
+        // true if chunk indices point into a vertex table shared between
+        // triangles (every format but STL)
+        virtual bool shared_vertices() const { return false; }
+
+        virtual std::uintmax_t bytes_read() const = 0;
+    };
+
+    //
+    // Open a streaming reader for STL, OBJ, PLY or GMSH; the format comes from
+    // the extension, or the file content. STL is streamed as is. The indexed
+    // formats keep a flat table of vertex positions (24 bytes per vertex) and
+    // stream faces; polygons are fan triangulated.
+    //
+    std::unique_ptr<triangle_source> open_triangle_source(const std::string &filename);
+
+    // Push every triangle of a file through callback, at most chunk_triangles
+    // at a time. Returns the number of triangles read.
+    std::uint64_t for_each_triangle_chunk(const std::string &filename,
+                                          const std::function<void(const TriangleChunk &)> &callback,
+                                          std::size_t chunk_triangles = 1u << 16);
+
+    struct ConvertOptions {
+        std::size_t chunk_triangles = 1u << 16;
+        // Merge corners with identical coordinates into one vertex. The lookup
+        // table grows with the number of distinct vertices, everything else
+        // stays bounded by the chunk size.
+        bool weld = false;
+        bool binary_stl = true; // STL output: binary, or ASCII like triMesh::save
+    };
+
+    struct ConvertStats {
+        std::uint64_t triangles = 0;
+        std::uint64_t vertices = 0;
+        std::uintmax_t bytes_read = 0;
+        std::uintmax_t bytes_written = 0;
+    };
+
+    //
+    // Convert a triangle soup between formats: reader -> optional weld -> writer.
+    // Reads STL, OBJ, PLY or GMSH; writes STL, OBJ, VTK, GMSH or PLY. Without
+    // weld, indexed inputs keep their shared vertices (each written once, in
+    // order of first use, so unreferenced ones are dropped) and STL corners
+    // stay separate. The output is written as output + ".tmp" and renamed
+    // over output when complete; on failure it is removed and any earlier
+    // output is left as it was. Throws std::runtime_error on I/O failure
+    // and std::invalid_argument for unsupported formats.
+    //
+    ConvertStats convert_mesh(const std::string &input, const std::string &output,
+                              const ConvertOptions &options = ConvertOptions());
+} // namespace halfMesh
@@ -0,0 +1,124 @@
+// parse_utilities.hpp
+#pragma once
+
+#include <charconv>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <streambuf>
+#include <string>
+#include <type_traits>
+
+namespace halfMesh {
+    namespace detail {
+        //
+        // Small helpers for parsing numbers straight out of a character
+        // buffer (which need not be null terminated, e.g. a mapped file),
+        // and for formatting them back into one.
+        //
+
+        inline bool is_blank(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+
+        inline bool is_space(char c) { return is_blank(c) || c == '\n'; }
+
+        inline void skip_blanks(const char *&p, const char *end) {
+            while (p < end && is_blank(*p)) ++p;
+        }
+
+        inline void skip_spaces(const char *&p, const char *end) {
+            while (p < end && is_space(*p)) ++p;
+        }
+
+        // Parse one floating point number after optional blanks, leaving p after it
+        inline bool parse_double(const char *&p, const char *end, double &out) {
+            skip_blanks(p, end);
+            if (p < end && *p == '+') ++p;
+            if (p >= end) return false;
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+            const auto [ptr, ec] = std::from_chars(p, end, out);
+            if (ec != std::errc()) return false;
+            p = ptr;
+            return true;
+#else
+            // strtod needs a terminated string, the buffer may not be one
+            char tmp[64];
+            size_t n = 0;
+            while (p + n < end && n < sizeof(tmp) - 1 && !is_space(p[n])) {
+                tmp[n] = p[n];
+                ++n;
+            }
+            tmp[n] = '\0';
+            char *stop = nullptr;
+            out = std::strtod(tmp, &stop);
+            if (stop == tmp) return false;
+            p += stop - tmp;
+            return true;
+#endif
+        }
+
+        // Parse one integer at p (no leading blanks), leaving p after it
+        template<typename T>
+        inline bool parse_integer(const char *&p, const char *end, T &out) {
+            if (p < end && *p == '+') ++p;
+            const auto [ptr, ec] = std::from_chars(p, end, out);
+            if (ec != std::errc()) return false;
+            p = ptr;
+            return true;
+        }
+
+        // Append the shortest text that reads back as exactly v
+        template<typename Real>
+        inline void append_number(std::string &out, Real v) {
+            static_assert(std::is_floating_point_v<Real>);
+            char tmp[32];
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+            const auto [ptr, ec] = std::to_chars(tmp, tmp + sizeof(tmp), v);
+            out.append(tmp, ec == std::errc() ? ptr : tmp);
+#else
+            const int digits = std::numeric_limits<Real>::max_digits10;
+            const int n = std::snprintf(tmp, sizeof(tmp), "%.*g", digits, static_cast<double>(v));
+            out.append(tmp, n > 0 ? static_cast<std::size_t>(n) : 0);
+#endif
+        }
+
+        inline void append_integer(std::string &out, unsigned long long v) {
+            char tmp[24];
+            const auto [ptr, ec] = std::to_chars(tmp, tmp + sizeof(tmp), v);
+            out.append(tmp, ec == std::errc() ? ptr : tmp);
+        }
+
+        //
+        // Read-only streambuf over a byte range, so stream based parsers can
+        // run on memory without copying it. Supports seeking.
+        //
+        class memory_buffer : public std::streambuf {
+        public:
+            memory_buffer(const char *data, std::size_t size) {
+                char *p = const_cast<char *>(data);
+                setg(p, p, p + size);
+            }
+
+        protected:
+            pos_type seekoff(off_type off, std::ios_base::seekdir dir,
+                             std::ios_base::openmode which) override {
+                if (!(which & std::ios_base::in)) return pos_type(off_type(-1));
+                char *base = dir == std::ios_base::beg ? eback() : dir == std::ios_base::cur ? gptr() : egptr();
+                char *target = base + off;
+                if (target < eback() || target > egptr()) return pos_type(off_type(-1));
+                setg(eback(), target, egptr());
+                return pos_type(target - eback());
+            }
+
+            pos_type seekpos(pos_type pos, std::ios_base::openmode which) override {
+                return seekoff(off_type(pos), std::ios_base::beg, which);
+            }
+        };
+
+        // Find the next '\n' in [p, end), or end
+        inline const char *find_eol(const char *p, const char *end) {
+            const auto *eol = static_cast<const char *>(std::memchr(p, '\n', end - p));
+            return eol ? eol : end;
+        }
+    } // namespace detail
+} // namespace halfMesh
@@ -0,0 +1,211 @@
+// ply_utilities.hpp
+#pragma once
+
+#include "parse_utilities.hpp"
+#include <cstdint>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace halfMesh {
+    namespace detail {
+        //
+        // PLY header model and binary scalar access, shared by the PLY
+        // reader/writer and the streaming PLY source.
+        //
+
+        enum class ply_type { Int8, UInt8, Int16, UInt16, Int32, UInt32, Float32, Float64, Invalid };
+
+        enum class ply_format { Ascii, BinaryLittleEndian, BinaryBigEndian };
+
+        inline ply_type parse_ply_type(const std::string &s) {
+            if (s == "char" || s == "int8") return ply_type::Int8;
+            if (s == "uchar" || s == "uint8") return ply_type::UInt8;
+            if (s == "short" || s == "int16") return ply_type::Int16;
+            if (s == "ushort" || s == "uint16") return ply_type::UInt16;
+            if (s == "int" || s == "int32") return ply_type::Int32;
+            if (s == "uint" || s == "uint32") return ply_type::UInt32;
+            if (s == "float" || s == "float32") return ply_type::Float32;
+            if (s == "double" || s == "float64") return ply_type::Float64;
+            return ply_type::Invalid;
+        }
+
+        inline const char *ply_type_name(ply_type t) {
+            switch (t) {
+                case ply_type::Int8: return "char";
+                case ply_type::UInt8: return "uchar";
+                case ply_type::Int16: return "short";
+                case ply_type::UInt16: return "ushort";
+                case ply_type::Int32: return "int";
+                case ply_type::UInt32: return "uint";
+                case ply_type::Float32: return "float";
+                default: return "double";
+            }
+        }
+
+        inline size_t ply_type_size(ply_type t) {
+            switch (t) {
+                case ply_type::Int8:
+                case ply_type::UInt8: return 1;
+                case ply_type::Int16:
+                case ply_type::UInt16: return 2;
+                case ply_type::Int32:
+                case ply_type::UInt32:
+                case ply_type::Float32: return 4;
+                default: return 8;
+            }
+        }
+
+        inline bool is_float_type(ply_type t) { return t == ply_type::Float32 || t == ply_type::Float64; }
+
+        inline bool is_signed_type(ply_type t) {
+            return t == ply_type::Int8 || t == ply_type::Int16 || t == ply_type::Int32;
+        }
+
+        struct ply_property {
+            std::string name;
+            ply_type type = ply_type::Invalid;
+            bool is_list = false;
+            ply_type count_type = ply_type::Invalid;
+        };
+
+        struct ply_element {
+            std::string name;
+            size_t count = 0;
+            std::vector<ply_property> properties;
+
+            // byte size of one binary record, 0 if the record holds a list
+            size_t fixed_stride() const {
+                size_t s = 0;
+                for (auto &p: properties) {
+                    if (p.is_list) return 0;
+                    s += ply_type_size(p.type);
+                }
+                return s;
+            }
+
+            int find(const std::string &n) const {
+                for (size_t i = 0; i < properties.size(); ++i)
+                    if (properties[i].name == n) return static_cast<int>(i);
+                return -1;
+            }
+        };
+
+        struct ply_header {
+            ply_format format = ply_format::Ascii;
+            std::vector<ply_element> elements;
+            size_t data_offset = 0;
+        };
+
+        inline ply_header parse_ply_header(const char *data, size_t size) {
+            const char *p = data, *end = data + size;
+            if (size < 4 || std::string(p, 3) != "ply")
+                throw std::runtime_error("Not a PLY file");
+
+            ply_header h;
+            bool have_format = false;
+            while (p < end) {
+                const char *eol = find_eol(p, end);
+                std::istringstream iss(std::string(p, eol));
+                p = eol < end ? eol + 1 : end;
+
+                std::string keyword;
+                iss >> keyword;
+                if (keyword == "format") {
+                    std::string f;
+                    iss >> f;
+                    if (f == "ascii") h.format = ply_format::Ascii;
+                    else if (f == "binary_little_endian") h.format = ply_format::BinaryLittleEndian;
+                    else if (f == "binary_big_endian") h.format = ply_format::BinaryBigEndian;
+                    else throw std::runtime_error("Unknown PLY format " + f);
+                    have_format = true;
+                } else if (keyword == "element") {
+                    ply_element e;
+                    iss >> e.name >> e.count;
+                    h.elements.push_back(e);
+                } else if (keyword == "property") {
+                    if (h.elements.empty())
+                        throw std::runtime_error("PLY property outside of an element");
+                    ply_property prop;
+                    std::string t;
+                    iss >> t;
+                    if (t == "list") {
+                        std::string ct, it;
+                        iss >> ct >> it;
+                        prop.is_list = true;
+                        prop.count_type = parse_ply_type(ct);
+                        prop.type = parse_ply_type(it);
+                    } else {
+                        prop.type = parse_ply_type(t);
+                    }
+                    iss >> prop.name;
+                    if (prop.type == ply_type::Invalid || (prop.is_list && prop.count_type == ply_type::Invalid))
+                        throw std::runtime_error("Unknown PLY property type in " + prop.name);
+                    h.elements.back().properties.push_back(prop);
+                } else if (keyword == "end_header") {
+                    if (!have_format)
+                        throw std::runtime_error("PLY header has no format line");
+                    h.data_offset = static_cast<size_t>(p - data);
+                    return h;
+                }
+                // "ply", comment and obj_info lines carry nothing we need
+            }
+            throw std::runtime_error("PLY header is not terminated");
+        }
+
+        inline bool host_is_little_endian() {
+            const std::uint16_t one = 1;
+            unsigned char b;
+            std::memcpy(&b, &one, 1);
+            return b == 1;
+        }
+
+        template<typename T>
+        inline T load(const char *p, bool swap) {
+            T v;
+            if (!swap) {
+                std::memcpy(&v, p, sizeof(T));
+            } else {
+                char tmp[sizeof(T)];
+                for (size_t i = 0; i < sizeof(T); ++i) tmp[i] = p[sizeof(T) - 1 - i];
+                std::memcpy(&v, tmp, sizeof(T));
+            }
+            return v;
+        }
+
+        template<typename T>
+        inline void store(char *p, T v, bool swap) {
+            char tmp[sizeof(T)];
+            std::memcpy(tmp, &v, sizeof(T));
+            for (size_t i = 0; i < sizeof(T); ++i) p[i] = swap ? tmp[sizeof(T) - 1 - i] : tmp[i];
+        }
+
+        inline double load_scalar(ply_type t, const char *p, bool swap) {
+            switch (t) {
+                case ply_type::Int8: return load<std::int8_t>(p, swap);
+                case ply_type::UInt8: return load<std::uint8_t>(p, swap);
+                case ply_type::Int16: return load<std::int16_t>(p, swap);
+                case ply_type::UInt16: return load<std::uint16_t>(p, swap);
+                case ply_type::Int32: return load<std::int32_t>(p, swap);
+                case ply_type::UInt32: return load<std::uint32_t>(p, swap);
+                case ply_type::Float32: return load<float>(p, swap);
+                default: return load<double>(p, swap);
+            }
+        }
+
+        inline void store_scalar(ply_type t, char *p, double v, bool swap) {
+            switch (t) {
+                case ply_type::Int8: store(p, static_cast<std::int8_t>(v), swap); break;
+                case ply_type::UInt8: store(p, static_cast<std::uint8_t>(v), swap); break;
+                case ply_type::Int16: store(p, static_cast<std::int16_t>(v), swap); break;
+                case ply_type::UInt16: store(p, static_cast<std::uint16_t>(v), swap); break;
+                case ply_type::Int32: store(p, static_cast<std::int32_t>(v), swap); break;
+                case ply_type::UInt32: store(p, static_cast<std::uint32_t>(v), swap); break;
+                case ply_type::Float32: store(p, static_cast<float>(v), swap); break;
+                default: store(p, v, swap); break;
+            }
+        }
+    } // namespace detail
+} // namespace halfMesh
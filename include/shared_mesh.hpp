@@ -0,0 +1,103 @@
+// shared_mesh.hpp
+#pragma once
+
+#include "common.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace halfMesh {
+    class triMesh;
+
+    //
+    // A mesh placed in a named POSIX shared-memory segment (shm_open + mmap)
+    // so another process can pick it up without a file round trip.
+    //
+    // The segment holds a layout/version header followed by flat arrays:
+    // positions (#V x 3 doubles), faces (#F x 3 int32 vertex rows), the
+    // vertex and face handles, and every property column whose entries are
+    // all floating point (NaN where a handle has no value). Other
+    // properties travel as one BSON document. attach() maps the segment
+    // read-only and only validates the header, so positions(), faces() and
+    // column() are views into the shared pages. to_mesh() builds a full
+    // triMesh when connectivity is needed.
+    //
+    // On systems without POSIX shared memory publish and attach throw
+    // std::runtime_error.
+    //
+    class shared_mesh {
+    public:
+        using PositionsView = Eigen::Map<const Eigen::Matrix<double, Eigen::Dynamic, 3, Eigen::RowMajor> >;
+        using FacesView = Eigen::Map<const Eigen::Matrix<std::int32_t, Eigen::Dynamic, 3, Eigen::RowMajor> >;
+        using ColumnView = Eigen::Map<const Eigen::VectorXd>;
+
+        // Create the segment and copy the mesh into it. The segment is
+        // removed when the returned object goes away unless persist() is
+        // called. Throws std::runtime_error if the name is taken.
+        static shared_mesh publish(const std::string &name, const triMesh &mesh);
+
+        // Map an existing segment read-only. Throws std::runtime_error if it
+        // does not exist or its header does not match this build.
+        static shared_mesh attach(const std::string &name);
+
+        // Remove a segment by name; false if there was none
+        static bool remove(const std::string &name);
+
+        ~shared_mesh();
+
+        shared_mesh(shared_mesh &&other) noexcept;
+
+        shared_mesh &operator=(shared_mesh &&other) noexcept;
+
+        shared_mesh(const shared_mesh &) = delete;
+
+        shared_mesh &operator=(const shared_mesh &) = delete;
+
+        // Keep the segment after this object is destroyed (the consumer
+        // calls remove() when done)
+        void persist() { owner_ = false; }
+
+        //— Accessors ——
+        const std::string &name() const { return name_; }
+        std::size_t size() const { return size_; }
+        std::size_t vertex_count() const;
+        std::size_t face_count() const;
+
+        // Rows follow the publishing mesh's get_vertices() / get_faces()
+        PositionsView positions() const;
+        FacesView faces() const;
+
+        const std::uint32_t *vertex_handles() const;
+        const std::uint32_t *face_handles() const;
+
+        // Floating point property column, indexed by handle
+        bool has_column(EntityType type, const std::string &name) const;
+        ColumnView column(EntityType type, const std::string &name) const;
+
+        // Rebuild a mesh with the same handles and properties
+        triMesh to_mesh() const;
+
+    private:
+        struct Column {
+            EntityType type;
+            std::string name;
+            std::uint64_t offset; // bytes from the start of the segment
+            std::uint64_t count;
+        };
+
+        shared_mesh(std::string name, char *base, std::size_t size, bool owner);
+
+        const Column *find_column(EntityType type, const std::string &name) const;
+
+        void read_directory();
+
+        void release();
+
+        std::string name_;
+        char *base_ = nullptr;
+        std::size_t size_ = 0;
+        bool owner_ = false;
+        std::vector<Column> columns_;
+    };
+} // namespace halfMesh
@@ -0,0 +1,85 @@
+// spatial_grid.hpp
+#pragma once
+
+#include "common.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace halfMesh {
+    class triMesh;
+
+    // What a spatial_grid holds: vertices as points, or faces by their boxes
+    enum class GridItems { Vertices, Faces };
+
+    //
+    // Uniform grid over the vertices or faces of a triMesh.
+    //
+    // The cell size comes from axis_aligned_bounding_box() (a few items per
+    // cell, and for faces at least their mean extent) unless one is given.
+    // Cells are addressed directly when the grid over the box is small
+    // enough and through a spatial hash otherwise, so a fine cell size
+    // costs no memory for empty space. Items are placed in every cell
+    // their box touches by a parallel counting sort into one flat array
+    // with per-cell offsets, each cell sorted.
+    //
+    // Results hold vertex or face handles, sorted and without repeats.
+    // Face queries are broad phase: they test the face boxes, not the
+    // triangles.
+    //
+    class spatial_grid {
+    public:
+        spatial_grid() = default;
+
+        spatial_grid(const triMesh &mesh, GridItems items, double cell_size = 0.0);
+
+        // cell_size <= 0 picks one from the mesh bounds
+        void build(const triMesh &mesh, GridItems items, double cell_size = 0.0);
+
+        // Items in the cell containing p
+        std::vector<unsigned> cell_items(const Eigen::Vector3d &p) const;
+
+        // Items whose box overlaps box
+        std::vector<unsigned> overlapping(const Eigen::AlignedBox3d &box) const;
+
+        // Vertices within epsilon of p, or faces whose box is
+        std::vector<unsigned> neighbours(const Eigen::Vector3d &p, double epsilon) const;
+
+        // Every pair of items within epsilon of each other (boxes for
+        // faces), lower handle first, in order; found in parallel. Faces
+        // sharing a vertex are pairs too.
+        std::vector<std::pair<unsigned, unsigned> > close_pairs(double epsilon) const;
+
+        //— Accessors ——
+        GridItems items() const { return items_; }
+        std::size_t size() const { return handles_.size(); }
+        double cell_size() const { return cell_size_; }
+        std::size_t cell_count() const { return offsets_.empty() ? 0 : offsets_.size() - 1; }
+        bool hashed() const { return !dense_; }
+
+    private:
+        using Cell = std::array<std::int64_t, 3>;
+
+        Cell cell_of(const Eigen::Vector3d &p) const;
+
+        // Slot of a cell in offsets_, or cell_count() for a cell outside a
+        // directly addressed grid
+        std::size_t slot(const Cell &cell) const;
+
+        // Item indices whose box is within epsilon of box (a grown box
+        // test); candidates come from the cells it covers
+        std::vector<unsigned> gather(const Eigen::AlignedBox3d &box, double epsilon) const;
+
+        GridItems items_ = GridItems::Vertices;
+        double cell_size_ = 0.0;
+        Eigen::Vector3d origin_ = Eigen::Vector3d::Zero();
+        Cell dims_{0, 0, 0};
+        bool dense_ = true;
+        std::vector<std::size_t> offsets_; // per slot, into entries_
+        std::vector<unsigned> entries_; // item indices, per slot
+        std::vector<Eigen::AlignedBox3d> boxes_; // per item
+        std::vector<unsigned> handles_; // per item
+    };
+} // namespace halfMesh
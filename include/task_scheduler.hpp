@@ -0,0 +1,141 @@
+// task_scheduler.hpp
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace halfMesh {
+    //
+    // Work-stealing scheduler for data parallel loops inside the library.
+    //
+    // A loop is cut into fixed size chunks. The calling thread pushes the
+    // whole chunk range to a deque; whoever picks a range up keeps halving
+    // it, pushing the upper half back to its own deque, until one chunk is
+    // left to run. Idle workers steal the oldest (largest) ranges from
+    // other deques. The caller works on its own loop while it waits, so
+    // loops may nest. With one thread everything runs inline on the caller.
+    //
+    class task_scheduler {
+    public:
+        // num_threads counts the caller; 0 means hardware_concurrency()
+        explicit task_scheduler(unsigned num_threads = 0);
+
+        ~task_scheduler();
+
+        task_scheduler(const task_scheduler &) = delete;
+
+        task_scheduler &operator=(const task_scheduler &) = delete;
+
+        unsigned size() const { return static_cast<unsigned>(workers_.size()) + 1; }
+
+        // Call chunk(c) for every c in [0, chunks) and wait. The first
+        // exception thrown by a chunk is rethrown here once all chunks ran.
+        void run_chunks(std::size_t chunks, const std::function<void(std::size_t)> &chunk);
+
+    private:
+        struct Job {
+            const std::function<void(std::size_t)> *chunk;
+            std::atomic<std::size_t> remaining;
+            std::mutex error_mutex;
+            std::exception_ptr error;
+        };
+
+        struct Task {
+            Job *job;
+            std::size_t first, last; // chunk indices
+        };
+
+        struct Queue {
+            std::mutex mutex;
+            std::deque<Task> tasks;
+        };
+
+        void worker_loop(std::size_t self);
+
+        void push(std::size_t queue, const Task &task);
+
+        bool pop(std::size_t queue, Task &task);
+
+        bool steal(std::size_t self, Task &task);
+
+        void execute(std::size_t self, Task task);
+
+        // Queue of the calling thread: its own for a worker, else the shared one
+        std::size_t queue_of_caller() const;
+
+        std::vector<std::thread> workers_;
+        std::vector<std::unique_ptr<Queue> > queues_; // one per worker, then the shared one
+        std::atomic<std::size_t> queued_{0};
+        std::mutex sleep_mutex_;
+        std::condition_variable wake_;
+        bool stopping_ = false;
+    };
+
+    // — Library-wide scheduler —
+
+    // Scheduler used by parallel_for / parallel_reduce, created on first use
+    task_scheduler &default_scheduler();
+
+    // Resize the library-wide scheduler; 1 runs everything serially and 0
+    // means hardware_concurrency(). Not to be called while a loop is running.
+    void set_num_threads(unsigned num_threads);
+
+    unsigned num_threads();
+
+    // Loops shorter than this many items per chunk run as a single chunk
+    constexpr std::size_t kDefaultGrain = 2048;
+
+    // body(i) for every i in [begin, end), in chunks of grain items
+    template<typename Body>
+    void parallel_for(std::size_t begin, std::size_t end, Body &&body, std::size_t grain = kDefaultGrain) {
+        if (end <= begin) return;
+        grain = std::max<std::size_t>(grain, 1);
+        const std::size_t chunks = (end - begin + grain - 1) / grain;
+        if (chunks == 1) {
+            for (std::size_t i = begin; i < end; ++i) body(i);
+            return;
+        }
+        default_scheduler().run_chunks(chunks, [&](std::size_t c) {
+            const std::size_t first = begin + c * grain;
+            const std::size_t last = std::min(end, first + grain);
+            for (std::size_t i = first; i < last; ++i) body(i);
+        });
+    }
+
+    //
+    // Reduce [begin, end): every chunk folds its items with
+    // accumulate(value, i) starting from identity, then the chunk results
+    // are combined in chunk order. The chunks only depend on grain, so the
+    // result is the same for any thread count.
+    //
+    template<typename T, typename Accumulate, typename Combine>
+    T parallel_reduce(std::size_t begin, std::size_t end, const T &identity,
+                      Accumulate &&accumulate, Combine &&combine, std::size_t grain = kDefaultGrain) {
+        if (end <= begin) return identity;
+        grain = std::max<std::size_t>(grain, 1);
+        const std::size_t chunks = (end - begin + grain - 1) / grain;
+        std::vector<T> partial(chunks, identity);
+        const auto run = [&](std::size_t c) {
+            const std::size_t first = begin + c * grain;
+            const std::size_t last = std::min(end, first + grain);
+            T value = identity;
+            for (std::size_t i = first; i < last; ++i) value = accumulate(std::move(value), i);
+            partial[c] = std::move(value);
+        };
+        if (chunks == 1) run(0);
+        else default_scheduler().run_chunks(chunks, run);
+
+        T result = std::move(partial[0]);
+        for (std::size_t c = 1; c < chunks; ++c) result = combine(std::move(result), partial[c]);
+        return result;
+    }
+} // namespace halfMesh
@@ -0,0 +1,85 @@
+// thread_pool.hpp
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace halfMesh {
+    //
+    // Fixed size FIFO thread pool. Jobs are run in submission order by
+    // whichever worker is free; submit() hands back a future for the result.
+    // The destructor finishes every queued job before joining.
+    //
+    class thread_pool {
+    public:
+        explicit thread_pool(unsigned num_threads) {
+            if (num_threads == 0) num_threads = 1;
+            workers_.reserve(num_threads);
+            for (unsigned i = 0; i < num_threads; ++i)
+                workers_.emplace_back([this] { worker_loop(); });
+        }
+
+        ~thread_pool() {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                stopping_ = true;
+            }
+            wake_.notify_all();
+            for (auto &w: workers_) w.join();
+        }
+
+        thread_pool(const thread_pool &) = delete;
+
+        thread_pool &operator=(const thread_pool &) = delete;
+
+        template<typename F>
+        std::future<std::invoke_result_t<std::decay_t<F> > > submit(F &&job) {
+            using R = std::invoke_result_t<std::decay_t<F> >;
+            auto task = std::make_shared<std::packaged_task<R()> >(std::forward<F>(job));
+            auto result = task->get_future();
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                jobs_.emplace([task] { (*task)(); });
+            }
+            wake_.notify_one();
+            return result;
+        }
+
+        unsigned size() const { return static_cast<unsigned>(workers_.size()); }
+
+    private:
+        void worker_loop() {
+            while (true) {
+                std::function<void()> job;
+                {
+                    std::unique_lock<std::mutex> lock(mutex_);
+                    wake_.wait(lock, [this] { return stopping_ || !jobs_.empty(); });
+                    if (jobs_.empty()) return;
+                    job = std::move(jobs_.front());
+                    jobs_.pop();
+                }
+                job();
+            }
+        }
+
+        std::vector<std::thread> workers_;
+        std::queue<std::function<void()> > jobs_;
+        std::mutex mutex_;
+        std::condition_variable wake_;
+        bool stopping_ = false;
+    };
+
+    // Shared pool for background file I/O (save_async / read_async)
+    inline thread_pool &io_thread_pool() {
+        static thread_pool pool(std::max(2u, std::thread::hardware_concurrency() / 2));
+        return pool;
+    }
+} // namespace halfMesh
@@ -1,6 +1,9 @@
 #pragma once
 
 #include <algorithm>
+#include <array>
+#include <cstddef>
+#include <future>
 #include <string>
 #include <vector>
 #include <unordered_map>
@@ -17,12 +20,25 @@
 #include "stream_utilities.hpp"
 
 namespace halfMesh {
+    class bm_journal;
+    class shared_mesh;
+
     class triMesh {
     public:
         triMesh();
 
         ~triMesh();
 
+        // Copies are deep: the new mesh owns its own vertices, edges, faces
+        // and half-edges, with the same handles and properties.
+        triMesh(const triMesh &other);
+
+        triMesh &operator=(const triMesh &other);
+
+        triMesh(triMesh &&other) noexcept;
+
+        triMesh &operator=(triMesh &&other) noexcept;
+
         // Core mutators
         vertexPtr add_vertex(double x, double y, double z);
 
@@ -40,11 +56,59 @@ namespace halfMesh {
 
         void complete_mesh();
 
+        // Bulk builder: replaces the current contents with the given vertices
+        // and triangles (indices into positions), then completes the mesh.
+        // Degenerate triangles are skipped.
+        void build_from_arrays(const std::vector<std::array<double, 3> > &positions,
+                               const std::vector<std::array<unsigned, 3> > &triangles);
+
+        // Eigen export for libigl-style code: V is #V x 3 with rows in
+        // get_vertices() order, F is #F x 3 with indices into the rows of V.
+        // Vertices are separate objects, so these are one-pass copies.
+        Eigen::MatrixXd positions_matrix() const;
+
+        Eigen::MatrixXi faces_matrix() const;
+
+        // Write every vertex position back from a #V x 3 matrix laid out as
+        // positions_matrix(). Throws std::runtime_error on a size mismatch.
+        void set_positions(const Eigen::Ref<const Eigen::MatrixXd> &V);
+
         // I/O
         void save(const std::string &filename) const;
 
         void read(const std::string &filename);
 
+        // In-memory I/O. With MeshType::Unknown the format is detected from
+        // the content (see detect_mesh_format); formats that cannot be read
+        // (VTK, glTF, undetected) throw std::runtime_error.
+        void read_from_memory(const std::byte *data, std::size_t size, MeshType type = MeshType::Unknown);
+
+        void read_from_memory(const std::vector<std::byte> &buffer, MeshType type = MeshType::Unknown);
+
+        std::vector<std::byte> save_to_memory(MeshType type) const;
+
+        // Background I/O on the shared io_thread_pool(). save_async encodes
+        // a snapshot taken at call time (or the moved-in mesh), so the
+        // caller may keep editing; the result is Failed on any stream error.
+        // read_async hands back the loaded mesh, with Failed for unreadable
+        // formats and malformed files.
+        std::future<IoResult> save_async(const std::string &filename) const;
+
+        static std::future<IoResult> save_async(triMesh &&mesh, const std::string &filename);
+
+        static std::future<std::pair<triMesh, IoResult> > read_async(const std::string &filename);
+
+        // glTF 2.0 binary export (float32 positions and vertex normals,
+        // uint32 indices). With reorder_for_gpu_cache the triangles are
+        // sorted for vertex cache reuse and vertices renumbered by first use.
+        void save_glb(const std::string &fn, bool reorder_for_gpu_cache = true) const;
+
+        // Compressed .hmc export: Edgebreaker connectivity (about 2 bits per
+        // triangle) and positions quantised to position_bits (1-30) per axis
+        // over the bounding box. Stores geometry and connectivity only;
+        // vertices and faces come back in traversal order.
+        void save_compressed(const std::string &fn, int position_bits = 16) const;
+
         // Traversals & topology
         halfEdgePtr get_next_half_edge(const halfEdgePtr &he, const facePtr &f) const;
 
@@ -63,6 +127,26 @@ namespace halfMesh {
 
         unsigned compute_number_of_holes() const;
 
+        // Boundary loops, found by rotating around each boundary vertex.
+        // The result is cached until the topology version changes, so
+        // holes, genus and hole filling share one walk.
+        BoundaryLoops boundary_loops() const;
+
+        // Mutation counters: the topology version is bumped by every change
+        // to the vertices, edges, half-edges or faces, the geometry version
+        // whenever positions change through the mesh. Code that moves
+        // vertices through their own setters calls mark_geometry_changed().
+        std::uint64_t topology_version() const { return topology_version_; }
+
+        std::uint64_t geometry_version() const { return geometry_version_; }
+
+        void mark_geometry_changed() { ++geometry_version_; }
+
+        // Counts, Euler characteristic, genus, components, boundary and
+        // manifold flags from one set of parallel passes, memoised until the
+        // topology version changes. The single queries above read it.
+        TopologySummary topology_summary() const;
+
         bool has_boundary() const;
 
         int euler_characteristic() const;
@@ -71,31 +155,45 @@ namespace halfMesh {
 
         double surface_area() const;
 
+        // Volume integrals over the faces, all from the same compensated
+        // kernel (see MassProperties); mass_properties() does one pass
+        double volume() const;
+
+        Eigen::Vector3d centroid() const;
+
+        Eigen::Matrix3d inertia_tensor() const;
+
+        MassProperties mass_properties() const;
+
         bool is_edge_manifold() const;
 
         bool is_manifold() const;
 
         bool is_oriented() const;
 
+        // One parallel pass over edges and one over vertices: edges are
+        // classified by their face count, and each vertex walks its fan by
+        // rotating around half-edges. is_manifold() reads its result through
+        // topology_summary().
+        ManifoldReport check_manifold() const;
+
         bool is_triangular() const;
 
         size_t num_connected_components() const;
 
-        Eigen::AlignedBox3d axis_aligned_bounding_box() const {
-            Eigen::AlignedBox3d box;
-            box.setEmpty();
+        // Components by a parallel union-find over the face corners. Given
+        // a property name, writes the labels to that vertex and face column
+        // (-1 where a handle is unused) and returns the count.
+        ComponentLabels connected_components() const;
 
-            // extend to include every vertex
-            for (auto& v : vertices_) {
-                box.extend(Eigen::Vector3d{
-                  v->get_x(),
-                  v->get_y(),
-                  v->get_z()
-                });
-            }
+        std::size_t connected_components(const std::string &property);
 
-            return box;
-        }
+        // One mesh per connected component, in label order, built
+        // concurrently with build_from_arrays. Vertices and faces keep
+        // their handle order and every property column is carried over.
+        std::vector<triMesh> split_components() const;
+
+        Eigen::AlignedBox3d axis_aligned_bounding_box() const;
 
         // Geometry queries
         double get_area(unsigned face_handle) const;
@@ -104,6 +202,38 @@ namespace halfMesh {
 
         double get_face_angle(unsigned f1, unsigned f2) const;
 
+        // Batch versions of the queries above: one parallel pass over all
+        // faces (or edges) with results indexed by handle, NaN where a
+        // handle is unused. Given a property name they fill that column.
+        std::vector<double> compute_face_areas() const;
+
+        std::vector<Eigen::Vector3d> compute_face_normals() const; // unit length
+
+        // Angle between the normals of the two faces at each edge, in
+        // radians (0 where flat); NaN on boundary edges
+        std::vector<double> compute_dihedral_angles() const;
+
+        void compute_face_areas(const std::string &property);
+
+        void compute_face_normals(const std::string &property); // [x, y, z] per face
+
+        void compute_dihedral_angles(const std::string &property);
+
+        // Maintained normals: unit face normals and blended vertex normals
+        // ([x, y, z] per handle) written to property columns. With normal
+        // tracking on, the mesh keeps the last results and a snapshot of the
+        // positions, and an update only recomputes the faces around moved
+        // vertices and the vertices of those faces. Topology edits fall back
+        // to a full pass. Both columns are refreshed by either update.
+        void update_face_normals(const std::string &property = "normal");
+
+        void update_vertex_normals(NormalWeighting weighting = NormalWeighting::Area,
+                                   const std::string &property = "normal");
+
+        void set_normal_tracking(bool enabled);
+
+        bool normal_tracking() const { return normal_cache_.tracking; }
+
         // Property API
         template<typename T>
         PropertyStatus add_vertex_property(const std::string &name, T init) {
@@ -132,13 +262,24 @@ namespace halfMesh {
             return PropertyStatus::Added;
         }
 
+        template<typename T>
+        PropertyStatus add_half_edge_property(const std::string &name, T init) {
+            if (half_edge_data_store.contains(name))
+                return PropertyStatus::Exists;
+            for (auto &he: half_edges_)
+                half_edge_data_store[name][he->get_handle()] = init;
+            return PropertyStatus::Added;
+        }
+
         // Inline remove‐property implementation
         PropertyStatus delete_property(const std::string &name, EntityType type) {
             auto &store = (type == EntityType::Vertex
                                ? vertex_data_store
                                : type == EntityType::Edge
                                      ? edge_data_store
-                                     : face_data_store);
+                                     : type == EntityType::HalfEdge
+                                           ? half_edge_data_store
+                                           : face_data_store);
             if (!store.contains(name))
                 return PropertyStatus::DoesNotExist;
             store.erase(name);
@@ -160,6 +301,11 @@ namespace halfMesh {
             face_data_store[name][h] = val;
         }
 
+        template<typename T>
+        void set_half_edge_property(const std::string &name, unsigned h, T val) {
+            half_edge_data_store[name][h] = val;
+        }
+
         template<typename T>
         T get_vertex_property(const std::string &name, unsigned h) const {
             return vertex_data_store.at(name).at(h).get<T>();
@@ -175,6 +321,53 @@ namespace halfMesh {
             return face_data_store.at(name).at(h).get<T>();
         }
 
+        template<typename T>
+        T get_half_edge_property(const std::string &name, unsigned h) const {
+            return half_edge_data_store.at(name).at(h).get<T>();
+        }
+
+        // Column access: a whole property as one array indexed by handle.
+        // Setting a column replaces the property in a single bulk copy.
+        template<typename T>
+        void set_vertex_property_column(const std::string &name, const std::vector<T> &values) {
+            vertex_data_store[name] = values;
+        }
+
+        template<typename T>
+        void set_edge_property_column(const std::string &name, const std::vector<T> &values) {
+            edge_data_store[name] = values;
+        }
+
+        template<typename T>
+        void set_face_property_column(const std::string &name, const std::vector<T> &values) {
+            face_data_store[name] = values;
+        }
+
+        template<typename T>
+        void set_half_edge_property_column(const std::string &name, const std::vector<T> &values) {
+            half_edge_data_store[name] = values;
+        }
+
+        template<typename T>
+        std::vector<T> get_vertex_property_column(const std::string &name) const {
+            return vertex_data_store.at(name).get<std::vector<T> >();
+        }
+
+        template<typename T>
+        std::vector<T> get_edge_property_column(const std::string &name) const {
+            return edge_data_store.at(name).get<std::vector<T> >();
+        }
+
+        template<typename T>
+        std::vector<T> get_face_property_column(const std::string &name) const {
+            return face_data_store.at(name).get<std::vector<T> >();
+        }
+
+        template<typename T>
+        std::vector<T> get_half_edge_property_column(const std::string &name) const {
+            return half_edge_data_store.at(name).get<std::vector<T> >();
+        }
+
         // Deletors
         bool delete_face(const facePtr &f);
 
@@ -218,33 +411,60 @@ namespace halfMesh {
         }
 
     private:
-        // I/O routines
-        void read_gmsh(const std::string &fn);
+        // Snapshots the stores and handles for its delta records
+        friend class bm_journal;
+
+        // Copies the arrays and stores into a segment and rebuilds from one
+        friend class shared_mesh;
+
+        // I/O routines: readers parse a byte range, writers fill a stream
+        void read_gmsh(const char *data, std::size_t size);
 
-        void read_obj(const std::string &fn);
+        void read_obj(const char *data, std::size_t size);
 
-        void read_binary(const std::string &fn);
+        void read_binary(const char *data, std::size_t size);
 
-        void write_gmsh(const std::string &fn) const;
+        void read_ply(const char *data, std::size_t size);
 
-        void write_obj(const std::string &fn) const;
+        void read_stl(const char *data, std::size_t size);
 
-        void write_binary(const std::string &fn) const;
+        void read_compressed(const char *data, std::size_t size);
 
-        void write_vtk(const std::string &fn) const;
+        void write(std::ostream &out, MeshType type) const;
 
-        // STL I/O
-        void write_stl_ascii(const std::string &filename) const;
+        void write_gmsh(std::ostream &out) const;
 
-        void read_stl(const std::string &filename);
+        void write_obj(std::ostream &out) const;
 
+        void write_binary(std::ostream &out) const;
+
+        void write_vtk(std::ostream &out) const;
+
+        void write_ply(std::ostream &out) const;
+
+        void write_stl_ascii(std::ostream &out) const;
+
+        void write_glb(std::ostream &out, bool reorder_for_gpu_cache) const;
+
+        void write_compressed(std::ostream &out, int position_bits) const;
+
+        // Legacy file based STL readers
         void read_stl_ascii(const std::string &filename);
 
         void read_stl_binary(const std::string &filename);
 
+        // Handle of the face on these three vertices, or max() if none
+        unsigned find_face_handle(unsigned a, unsigned b, unsigned c) const;
+
+        // Bring the cached normals up to date and write the tracked columns
+        void refresh_normals();
+
         // Cleanup
         void clear_data();
 
+        // Deep copy of other into this (empty) mesh
+        void copy_from(const triMesh &other);
+
         // Ownership
         std::vector<vertexPtr> vertices_;
         std::vector<halfEdgePtr> half_edges_;
@@ -269,12 +489,48 @@ namespace halfMesh {
         nlohmann::json vertex_data_store;
         nlohmann::json edge_data_store;
         nlohmann::json face_data_store;
+        nlohmann::json half_edge_data_store;
 
         // Next‐free handles
         unsigned next_vertex_handle_ = 0;
         unsigned next_half_edge_handle_ = 0;
         unsigned next_edge_handle_ = 0;
         unsigned next_face_handle_ = 0;
+
+        // State behind update_face_normals / update_vertex_normals
+        struct NormalCache {
+            bool tracking = false;
+            bool valid = false;
+            std::uint64_t topology_version = 0; // at the last update
+            std::vector<Eigen::Vector3d> positions; // by vertex handle, at the last update
+            std::vector<std::array<unsigned, 3> > corners; // vertex handles by face handle
+            std::vector<unsigned> ring_offsets, ring_faces; // faces around each vertex handle
+            std::vector<Eigen::Vector3d> face_normals;
+            std::vector<double> face_areas;
+            std::vector<Eigen::Vector3d> vertex_normals; // empty until asked for
+            NormalWeighting weighting = NormalWeighting::Area;
+            std::string face_property, vertex_property; // columns kept in sync
+        };
+
+        NormalCache normal_cache_;
+
+        std::uint64_t topology_version_ = 0;
+        std::uint64_t geometry_version_ = 0;
+
+        // Results of one topology version; swapped atomically so const
+        // callers may race
+        struct LoopCache {
+            std::uint64_t version;
+            BoundaryLoops loops;
+        };
+
+        struct SummaryCache {
+            std::uint64_t version;
+            TopologySummary summary;
+        };
+
+        mutable std::shared_ptr<const LoopCache> loop_cache_;
+        mutable std::shared_ptr<const SummaryCache> summary_cache_;
     };
 
     inline std::ostream &operator<<(std::ostream &os, triMesh const &m) {
@@ -0,0 +1,99 @@
+// vertex_kdtree.hpp
+#pragma once
+
+#include "common.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace halfMesh {
+    class triMesh;
+
+    // k nearest vertices per query point, row-major: entries [q k, (q + 1) k)
+    // belong to query q, nearest first. Rows are padded with max() handles
+    // and infinite distances when the tree holds fewer than k vertices.
+    struct NearestVertices {
+        std::size_t k = 0;
+        std::vector<unsigned> vertices;
+        std::vector<double> distances;
+
+        std::size_t size() const { return k == 0 ? 0 : vertices.size() / k; }
+    };
+
+    // Vertices within a radius of each query point: query q owns
+    // [offsets[q], offsets[q + 1]) of vertices / distances, nearest first
+    struct VerticesInRadius {
+        std::vector<unsigned> vertices;
+        std::vector<double> distances;
+        std::vector<std::size_t> offsets{0};
+
+        std::size_t size() const { return offsets.size() - 1; }
+    };
+
+    //
+    // k-d tree over the vertex positions of a triMesh.
+    //
+    // The layout is implicit: points are stored once, in tree order, and
+    // the node of a range is its middle element, split along the widest
+    // axis of the range, with the halves on either side. Only the split
+    // axis is stored per node; ranges of a few points are leaves and are
+    // scanned. Large ranges are partitioned and recurse in parallel.
+    //
+    // Ties in distance go to the lower vertex handle, so results do not
+    // depend on the layout or on how the tree was grown.
+    //
+    // update() follows the mesh: vertices added since the last build or
+    // update are kept in a tail that queries scan, and the tree is rebuilt
+    // once the tail outgrows an eighth of it. Removed or moved vertices
+    // (seen through geometry_version()) trigger a full build.
+    //
+    class vertex_kdtree {
+    public:
+        vertex_kdtree() = default;
+
+        explicit vertex_kdtree(const triMesh &mesh);
+
+        void build(const triMesh &mesh);
+
+        void update(const triMesh &mesh);
+
+        // Nearest vertex handle, max() for an empty tree
+        unsigned nearest(const Eigen::Vector3d &p, double *distance = nullptr) const;
+
+        // Batches over the rows of a #Q x 3 matrix, in parallel
+        NearestVertices knn(const Eigen::Ref<const Eigen::MatrixXd> &points, std::size_t k) const;
+
+        VerticesInRadius radius_search(const Eigen::Ref<const Eigen::MatrixXd> &points, double radius) const;
+
+        //— Accessors ——
+        bool empty() const { return points_.empty(); }
+        std::size_t size() const { return points_.size(); }
+        std::size_t pending() const { return points_.size() - tree_size_; }
+
+    private:
+        struct Point {
+            double p[3];
+            unsigned vertex;
+        };
+
+        // Build the tree over every stored point
+        void rebuild();
+
+        void build_range(std::size_t begin, std::size_t end);
+
+        // Offer visitor every point of the tree range and the tail that
+        // could lie within its current bound
+        template<typename Visitor>
+        void search(std::size_t begin, std::size_t end, const double *p, Visitor &visitor) const;
+
+        template<typename Visitor>
+        void search(const double *p, Visitor &visitor) const;
+
+        std::vector<Point> points_; // tree order, then the tail
+        std::vector<std::uint8_t> axes_; // split axis of each node
+        std::size_t tree_size_ = 0;
+        unsigned last_vertex_ = 0; // handle of the last mesh vertex seen
+        std::uint64_t geometry_version_ = 0;
+    };
+} // namespace halfMesh
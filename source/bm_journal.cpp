@@ -0,0 +1,296 @@
+#include "bm_journal.hpp"
+#include "thread_pool.hpp"
+#include "triMesh.hpp"
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#define HALFMESH_HAS_FSYNC 1
+#elif defined(_WIN32)
+#include <fcntl.h>
+#include <io.h>
+#include <sys/stat.h>
+#endif
+
+namespace halfMesh {
+    namespace {
+        const char *const kStoreKeys[4] = {
+            "VERTEX_PROPERTIES", "EDGE_PROPERTIES", "FACE_PROPERTIES", "HALF_EDGE_PROPERTIES"
+        };
+
+        std::string to_bytes(const nlohmann::json &js) {
+            const auto buf = nlohmann::json::to_bson(js);
+            return std::string(reinterpret_cast<const char *>(buf.data()), buf.size());
+        }
+
+        // Write (or append) bytes and return once they are on the disk
+        void write_file(const std::string &path, const std::string &bytes, bool append) {
+#if defined(HALFMESH_HAS_FSYNC)
+            const int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | (append ? O_APPEND : O_TRUNC), 0644);
+            if (fd < 0) throw std::runtime_error("Can't open " + path);
+            const char *p = bytes.data();
+            std::size_t left = bytes.size();
+            bool ok = true;
+            while (ok && left > 0) {
+                const ssize_t n = ::write(fd, p, left);
+                if (n < 0 && errno == EINTR) continue;
+                ok = n > 0;
+                if (ok) {
+                    p += n;
+                    left -= static_cast<std::size_t>(n);
+                }
+            }
+            ok = ok && ::fsync(fd) == 0;
+            ok = ::close(fd) == 0 && ok;
+            if (!ok) throw std::runtime_error("Could not write " + path);
+#elif defined(_WIN32)
+            const int fd = ::_open(path.c_str(), _O_WRONLY | _O_CREAT | _O_BINARY | (append ? _O_APPEND : _O_TRUNC),
+                                   _S_IREAD | _S_IWRITE);
+            if (fd < 0) throw std::runtime_error("Can't open " + path);
+            const char *p = bytes.data();
+            std::size_t left = bytes.size();
+            bool ok = true;
+            while (ok && left > 0) {
+                const unsigned chunk = static_cast<unsigned>(std::min<std::size_t>(left, 1u << 30));
+                const int n = ::_write(fd, p, chunk);
+                ok = n > 0;
+                if (ok) {
+                    p += n;
+                    left -= static_cast<std::size_t>(n);
+                }
+            }
+            ok = ok && ::_commit(fd) == 0;
+            ok = ::_close(fd) == 0 && ok;
+            if (!ok) throw std::runtime_error("Could not write " + path);
+#else
+            std::ofstream out(path, std::ios::binary | (append ? std::ios::app : std::ios::trunc));
+            if (!out) throw std::runtime_error("Can't open " + path);
+            out.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+            out.flush();
+            if (!out) throw std::runtime_error("Could not write " + path);
+#endif
+        }
+
+        // Make a new name in the directory of path durable (file creation,
+        // rename). Best effort: some file systems cannot sync directories.
+        void sync_directory(const std::string &path) {
+#if defined(HALFMESH_HAS_FSYNC)
+            std::filesystem::path dir = std::filesystem::path(path).parent_path();
+            if (dir.empty()) dir = ".";
+            const int fd = ::open(dir.c_str(), O_RDONLY);
+            if (fd < 0) return;
+            ::fsync(fd);
+            ::close(fd);
+#else
+            (void) path;
+#endif
+        }
+    }
+
+    bm_journal::bm_journal(std::string filename, JournalOptions options)
+        : filename_(std::move(filename)), options_(options) {
+    }
+
+    bm_journal::~bm_journal() {
+        try {
+            finish_compaction(true);
+        } catch (...) {
+            // the journal on disk is complete without the compacted copy
+        }
+    }
+
+    // — Snapshots —
+    std::shared_ptr<const bm_journal::Snapshot> bm_journal::take_snapshot(const triMesh &mesh) {
+        auto s = std::make_shared<Snapshot>();
+        for (auto &v: mesh.vertices_) {
+            const unsigned h = v->get_handle();
+            if (h >= s->positions.size()) {
+                s->positions.resize(h + 1);
+                s->has_vertex.resize(h + 1, 0);
+            }
+            s->positions[h] = {v->get_x(), v->get_y(), v->get_z()};
+            s->has_vertex[h] = 1;
+        }
+        for (auto &f: mesh.faces_) {
+            const unsigned h = f->get_handle();
+            if (h >= s->faces.size()) {
+                s->faces.resize(h + 1);
+                s->has_face.resize(h + 1, 0);
+            }
+            auto [a,b,c] = f->get_vertices();
+            s->faces[h] = {a->get_handle(), b->get_handle(), c->get_handle()};
+            s->has_face[h] = 1;
+        }
+        s->properties[0] = mesh.vertex_data_store;
+        s->properties[1] = mesh.edge_data_store;
+        s->properties[2] = mesh.face_data_store;
+        s->properties[3] = mesh.half_edge_data_store;
+        return s;
+    }
+
+    // Same layout as triMesh::write_binary
+    std::string bm_journal::base_document(const Snapshot &s) {
+        nlohmann::json js;
+        js["VERTICES"] = nlohmann::json::array();
+        js["FACES"] = nlohmann::json::array();
+        nlohmann::json vertex_handles = nlohmann::json::array(), face_handles = nlohmann::json::array();
+        bool dense = true;
+        for (unsigned h = 0; h < s.positions.size(); ++h) {
+            if (!s.has_vertex[h]) continue;
+            dense = dense && h == vertex_handles.size();
+            js["VERTICES"].push_back({s.positions[h][0], s.positions[h][1], s.positions[h][2]});
+            vertex_handles.push_back(h);
+        }
+        if (!dense) js["VERTEX_HANDLES"] = std::move(vertex_handles);
+        dense = true;
+        for (unsigned h = 0; h < s.faces.size(); ++h) {
+            if (!s.has_face[h]) continue;
+            dense = dense && h == face_handles.size();
+            js["FACES"].push_back({s.faces[h][0], s.faces[h][1], s.faces[h][2]});
+            face_handles.push_back(h);
+        }
+        if (!dense) js["FACE_HANDLES"] = std::move(face_handles);
+        for (int k = 0; k < 4; ++k) js[kStoreKeys[k]] = s.properties[k];
+        return to_bytes(js);
+    }
+
+    //
+    // A record lists deleted faces and vertices, then vertices to create or
+    // move and faces to create ([handle, ...] each), then a JSON patch per
+    // property store. Replay applies them in that order.
+    //
+    std::string bm_journal::delta_record(const Snapshot &before, const Snapshot &after) {
+        nlohmann::json record = nlohmann::json::object();
+        const auto had = [](const std::vector<char> &flags, unsigned h) { return h < flags.size() && flags[h]; };
+
+        nlohmann::json deleted_faces = nlohmann::json::array(), faces = nlohmann::json::array();
+        for (unsigned h = 0; h < before.faces.size(); ++h)
+            if (before.has_face[h] && (!had(after.has_face, h) || after.faces[h] != before.faces[h]))
+                deleted_faces.push_back(h);
+        for (unsigned h = 0; h < after.faces.size(); ++h)
+            if (after.has_face[h] && (!had(before.has_face, h) || after.faces[h] != before.faces[h]))
+                faces.push_back({h, after.faces[h][0], after.faces[h][1], after.faces[h][2]});
+
+        nlohmann::json deleted_vertices = nlohmann::json::array(), vertices = nlohmann::json::array();
+        for (unsigned h = 0; h < before.positions.size(); ++h)
+            if (before.has_vertex[h] && !had(after.has_vertex, h))
+                deleted_vertices.push_back(h);
+        for (unsigned h = 0; h < after.positions.size(); ++h)
+            if (after.has_vertex[h] && (!had(before.has_vertex, h) || after.positions[h] != before.positions[h]))
+                vertices.push_back({h, after.positions[h][0], after.positions[h][1], after.positions[h][2]});
+
+        if (!deleted_faces.empty()) record["DELETED_FACES"] = std::move(deleted_faces);
+        if (!deleted_vertices.empty()) record["DELETED_VERTICES"] = std::move(deleted_vertices);
+        if (!vertices.empty()) record["VERTICES"] = std::move(vertices);
+        if (!faces.empty()) record["FACES"] = std::move(faces);
+        for (int k = 0; k < 4; ++k) {
+            if (before.properties[k] == after.properties[k]) continue;
+            record[kStoreKeys[k]] = nlohmann::json::diff(before.properties[k], after.properties[k]);
+        }
+        if (record.empty()) return {};
+        return to_bytes(record);
+    }
+
+    // — Saving —
+    std::uintmax_t bm_journal::save(const triMesh &mesh) {
+        auto now = take_snapshot(mesh);
+        finish_compaction(false);
+
+        if (!last_) {
+            const std::string base = base_document(*now);
+            write_file(filename_, base, false);
+            sync_directory(filename_);
+            last_ = std::move(now);
+            base_bytes_ = base.size();
+            journal_bytes_ = 0;
+            records_ = 0;
+            return base.size();
+        }
+
+        const std::string record = delta_record(*last_, *now);
+        if (record.empty()) return 0;
+        append(record, filename_);
+        last_ = std::move(now);
+        if (compaction_.valid()) pending_records_.push_back(record);
+        journal_bytes_ += record.size();
+        ++records_;
+
+        if (options_.compact_ratio > 0 &&
+            static_cast<double>(journal_bytes_) > options_.compact_ratio * static_cast<double>(base_bytes_))
+            compact();
+        return record.size();
+    }
+
+    void bm_journal::append(const std::string &bytes, const std::string &path) {
+        write_file(path, bytes, true);
+    }
+
+    // — Compaction —
+    void bm_journal::compact() {
+        if (!last_ || compaction_.valid() || records_ == 0) return;
+        const auto snapshot = last_;
+        const std::string temporary = filename_ + ".compact.tmp";
+        compaction_ = io_thread_pool().submit([snapshot, temporary] {
+            IoResult result;
+            try {
+                const std::string base = base_document(*snapshot);
+                write_file(temporary, base, false);
+                result.bytes = base.size();
+            } catch (const std::exception &e) {
+                result.status = IoStatus::Failed;
+                result.message = e.what();
+            }
+            return result;
+        });
+    }
+
+    void bm_journal::flush() {
+        finish_compaction(true);
+    }
+
+    //
+    // The compacted file holds the state at compaction start. The records
+    // saved since then are appended to it before it replaces the journal,
+    // so the swap loses nothing.
+    //
+    void bm_journal::finish_compaction(bool wait) {
+        if (!compaction_.valid()) return;
+        if (!wait && compaction_.wait_for(std::chrono::seconds(0)) != std::future_status::ready) return;
+        const IoResult result = compaction_.get();
+        std::vector<std::string> records;
+        records.swap(pending_records_);
+        const std::string temporary = filename_ + ".compact.tmp";
+        std::error_code ec;
+        if (result.status != IoStatus::Ok) {
+            std::filesystem::remove(temporary, ec);
+            return;
+        }
+        std::uintmax_t journal = 0;
+        try {
+            for (auto &r: records) {
+                append(r, temporary);
+                journal += r.size();
+            }
+        } catch (const std::exception &) {
+            std::filesystem::remove(temporary, ec);
+            return;
+        }
+        // the temporary is already synced, record by record
+        std::filesystem::rename(temporary, filename_, ec);
+        if (ec) {
+            std::filesystem::remove(temporary, ec);
+            return;
+        }
+        sync_directory(filename_);
+        base_bytes_ = result.bytes;
+        journal_bytes_ = journal;
+        records_ = records.size();
+    }
+} // namespace halfMesh
@@ -0,0 +1,645 @@
+#include "face_bvh.hpp"
+#include "task_scheduler.hpp"
+#include "triMesh.hpp"
+#include <algorithm>
+#include <bitset>
+#include <cmath>
+#include <numeric>
+#include <stdexcept>
+#include <utility>
+
+namespace halfMesh {
+    namespace {
+        constexpr double kInf = std::numeric_limits<double>::infinity();
+
+        // Centroid bins per axis for the SAH sweep
+        constexpr int kBins = 16;
+
+        // Ranges at least this long bin and recurse in parallel
+        constexpr std::size_t kParallelRange = 4096;
+
+        // Deeper than this the build splits at the median, which bounds the
+        // depth (and the traversal stacks) for any input
+        constexpr int kMaxSahDepth = 48;
+        constexpr int kStackSize = 128;
+
+        // Rays per task in the batch queries; each task sorts its rays
+        // into packets
+        constexpr std::size_t kRayGrain = 256;
+        constexpr std::size_t kPacketSize = detail::kPacketLanes;
+
+        // A packet with this few rays left in a subtree traces them one at
+        // a time instead: incoherent rays then cost no more than single
+        // ray queries
+        constexpr std::size_t kMinActiveLanes = 2;
+
+        constexpr std::size_t kNoHit = std::numeric_limits<std::size_t>::max();
+
+        float round_down(double x) {
+            const float f = static_cast<float>(x);
+            return f > x ? std::nextafter(f, -std::numeric_limits<float>::infinity()) : f;
+        }
+
+        float round_up(double x) {
+            const float f = static_cast<float>(x);
+            return f < x ? std::nextafter(f, std::numeric_limits<float>::infinity()) : f;
+        }
+
+        double half_area(const Eigen::AlignedBox3d &box) {
+            if (box.isEmpty()) return 0.0;
+            const Eigen::Vector3d d = box.sizes();
+            return d.x() * d.y() + d.y() * d.z() + d.z() * d.x();
+        }
+
+        struct Bins {
+            Eigen::AlignedBox3d box[3][kBins];
+            std::size_t count[3][kBins] = {};
+
+            void merge(const Bins &other) {
+                for (int k = 0; k < 3; ++k)
+                    for (int b = 0; b < kBins; ++b) {
+                        box[k][b].extend(other.box[k][b]);
+                        count[k][b] += other.count[k][b];
+                    }
+            }
+        };
+
+        // Fold [begin, end) into a T, in parallel for long ranges
+        template<typename T, typename Accumulate, typename Combine>
+        T reduce_range(std::size_t begin, std::size_t end, const T &identity, Accumulate &&accumulate, Combine &&combine) {
+            if (end - begin >= kParallelRange)
+                return parallel_reduce(begin, end, identity, accumulate, combine);
+            T value = identity;
+            for (std::size_t i = begin; i < end; ++i) value = accumulate(std::move(value), i);
+            return value;
+        }
+
+        struct Builder {
+            const std::vector<Eigen::AlignedBox3d> &boxes;
+            const std::vector<Eigen::Vector3d> &centroids;
+            std::vector<unsigned> &order;
+            unsigned max_leaf;
+
+            // Split [begin, end) of order; returns the middle
+            std::size_t split(std::size_t begin, std::size_t end, int depth) const {
+                const std::size_t n = end - begin;
+                const std::size_t middle = begin + n / 2;
+                const Eigen::AlignedBox3d extent = reduce_range(
+                    begin, end, Eigen::AlignedBox3d(),
+                    [this](Eigen::AlignedBox3d box, std::size_t i) { return box.extend(centroids[order[i]]); },
+                    [](Eigen::AlignedBox3d a, const Eigen::AlignedBox3d &b) { return a.extend(b); });
+                const Eigen::Vector3d size = extent.sizes();
+                int axis = 0;
+                size.maxCoeff(&axis);
+                if (!(size[axis] > 0.0)) return middle; // all centroids coincide
+
+                if (depth >= kMaxSahDepth) {
+                    std::nth_element(order.begin() + begin, order.begin() + middle, order.begin() + end,
+                                     [this, axis](unsigned a, unsigned b) { return centroids[a][axis] < centroids[b][axis]; });
+                    return middle;
+                }
+
+                Eigen::Vector3d scale;
+                for (int k = 0; k < 3; ++k) scale[k] = size[k] > 0.0 ? kBins / size[k] : 0.0;
+                const auto bin = [&](unsigned p, int k) {
+                    const int b = static_cast<int>((centroids[p][k] - extent.min()[k]) * scale[k]);
+                    return std::clamp(b, 0, kBins - 1);
+                };
+                const Bins bins = reduce_range(
+                    begin, end, Bins{},
+                    [&](Bins acc, std::size_t i) {
+                        const unsigned p = order[i];
+                        for (int k = 0; k < 3; ++k) {
+                            const int b = bin(p, k);
+                            acc.box[k][b].extend(boxes[p]);
+                            ++acc.count[k][b];
+                        }
+                        return acc;
+                    },
+                    [](Bins a, const Bins &b) {
+                        a.merge(b);
+                        return a;
+                    });
+
+                // sweep: cost of cutting after bin b is A_left N_left + A_right N_right
+                double best_cost = kInf;
+                int best_axis = -1, best_bin = 0;
+                for (int k = 0; k < 3; ++k) {
+                    if (scale[k] == 0.0) continue;
+                    double right_cost[kBins];
+                    Eigen::AlignedBox3d box;
+                    std::size_t count = 0;
+                    for (int b = kBins - 1; b > 0; --b) {
+                        box.extend(bins.box[k][b]);
+                        count += bins.count[k][b];
+                        right_cost[b] = half_area(box) * static_cast<double>(count);
+                    }
+                    box.setEmpty();
+                    count = 0;
+                    for (int b = 0; b < kBins - 1; ++b) {
+                        box.extend(bins.box[k][b]);
+                        count += bins.count[k][b];
+                        const double cost = half_area(box) * static_cast<double>(count) + right_cost[b + 1];
+                        if (count > 0 && count < n && cost < best_cost) {
+                            best_cost = cost;
+                            best_axis = k;
+                            best_bin = b;
+                        }
+                    }
+                }
+                if (best_axis < 0) return middle;
+                const auto it = std::partition(order.begin() + begin, order.begin() + end,
+                                               [&](unsigned p) { return bin(p, best_axis) <= best_bin; });
+                const std::size_t mid = static_cast<std::size_t>(it - order.begin());
+                return mid == begin || mid == end ? middle : mid;
+            }
+
+            // Append the subtree over [begin, end) to out; child indices
+            // are positions in out
+            template<typename Node>
+            void build(std::vector<Node> &out, std::size_t begin, std::size_t end, int depth) const {
+                const std::size_t node = out.size();
+                out.push_back(Node{});
+                const std::size_t n = end - begin;
+                if (n <= max_leaf) {
+                    out[node].index = static_cast<std::uint32_t>(begin);
+                    out[node].count = static_cast<std::uint32_t>(n);
+                    return;
+                }
+                const std::size_t mid = split(begin, end, depth);
+                if (n < kParallelRange) {
+                    build(out, begin, mid, depth + 1);
+                    out[node].index = static_cast<std::uint32_t>(out.size());
+                    build(out, mid, end, depth + 1);
+                    return;
+                }
+                // both halves at once into their own arrays, then appended
+                std::vector<Node> halves[2];
+                parallel_for(0, 2, [&](std::size_t k) {
+                    build(halves[k], k == 0 ? begin : mid, k == 0 ? mid : end, depth + 1);
+                }, 1);
+                for (int k = 0; k < 2; ++k) {
+                    const auto base = static_cast<std::uint32_t>(out.size());
+                    if (k == 1) out[node].index = base;
+                    for (Node child: halves[k]) {
+                        if (child.count == 0) child.index += base;
+                        out.push_back(child);
+                    }
+                }
+            }
+        };
+
+        // Entry distance of the ray into the box, infinity on a miss. NaNs
+        // from 0 * inf (origin on a slab, axis-parallel ray) are skipped.
+        double enter_box(const float *lo, const float *hi, const Eigen::Vector3d &origin,
+                         const Eigen::Vector3d &inverse, double t_min, double t_max) {
+            for (int k = 0; k < 3; ++k) {
+                double t0 = (lo[k] - origin[k]) * inverse[k];
+                double t1 = (hi[k] - origin[k]) * inverse[k];
+                if (t0 > t1) std::swap(t0, t1);
+                if (t0 > t_min) t_min = t0;
+                if (t1 < t_max) t_max = t1;
+            }
+            return t_min <= t_max ? t_min : kInf;
+        }
+
+        // Split the batch into tasks of kRayGrain rays and hand each task's
+        // rays to trace kPacketSize at a time, as the index of the first
+        template<typename Trace>
+        void for_each_packet(std::size_t count, Trace &&trace) {
+            const std::size_t tasks = (count + kRayGrain - 1) / kRayGrain;
+            parallel_for(0, tasks, [&](std::size_t task) {
+                const std::size_t end = std::min(count, (task + 1) * kRayGrain);
+                for (std::size_t p = task * kRayGrain; p < end; p += kPacketSize)
+                    trace(p, std::min(kPacketSize, end - p));
+            }, 1);
+        }
+
+        // Whether all rays head into the same octant; rays that do not
+        // share few nodes and are traced one at a time
+        bool same_octant(const Ray *rays, std::size_t count) {
+            const auto octant = [](const Ray &ray) {
+                return (ray.direction.x() < 0.0) | (ray.direction.y() < 0.0) << 1 | (ray.direction.z() < 0.0) << 2;
+            };
+            for (std::size_t l = 1; l < count; ++l)
+                if (octant(rays[l]) != octant(rays[0])) return false;
+            return count > kMinActiveLanes;
+        }
+
+        // Lane l from rays[l] for l < count; the other lanes never enter a
+        // box. Returns the mask of the filled lanes.
+        std::uint32_t load_packet(const Ray *rays, std::size_t count, detail::RayLanes &packet) {
+            for (std::size_t l = 0; l < kPacketSize; ++l) {
+                const Ray *ray = l < count ? &rays[l] : nullptr;
+                for (int k = 0; k < 3; ++k) {
+                    packet.origin[k][l] = ray ? ray->origin[k] : 0.0;
+                    packet.direction[k][l] = ray ? ray->direction[k] : 0.0;
+                    packet.inverse[k][l] = ray ? 1.0 / ray->direction[k] : 0.0;
+                }
+                packet.t_min[l] = ray ? ray->t_min : kInf;
+                packet.t_max[l] = ray ? ray->t_max : -kInf;
+            }
+            return static_cast<std::uint32_t>((std::uint64_t(1) << count) - 1);
+        }
+
+        Eigen::Vector3d corner(const detail::TriangleBatch &b, std::size_t i, int c) {
+            switch (c) {
+                case 0: return {b.ax[i], b.ay[i], b.az[i]};
+                case 1: return {b.bx[i], b.by[i], b.bz[i]};
+                default: return {b.cx[i], b.cy[i], b.cz[i]};
+            }
+        }
+
+        void set_corners(detail::TriangleBatch &b, std::size_t i, const Eigen::Vector3d &a,
+                         const Eigen::Vector3d &v, const Eigen::Vector3d &c) {
+            b.ax[i] = a.x(), b.ay[i] = a.y(), b.az[i] = a.z();
+            b.bx[i] = v.x(), b.by[i] = v.y(), b.bz[i] = v.z();
+            b.cx[i] = c.x(), b.cy[i] = c.y(), b.cz[i] = c.z();
+        }
+
+        double box_distance2(const float *lo, const float *hi, const Eigen::Vector3d &p) {
+            double d2 = 0.0;
+            for (int k = 0; k < 3; ++k) {
+                const double d = std::max({lo[k] - p[k], 0.0, p[k] - hi[k]});
+                d2 += d * d;
+            }
+            return d2;
+        }
+
+        // Closest point on triangle abc (Ericson, Real-Time Collision Detection 5.1.5)
+        Eigen::Vector3d closest_on_triangle(const Eigen::Vector3d &p, const Eigen::Vector3d &a,
+                                            const Eigen::Vector3d &b, const Eigen::Vector3d &c) {
+            const Eigen::Vector3d ab = b - a, ac = c - a, ap = p - a;
+            const double d1 = ab.dot(ap), d2 = ac.dot(ap);
+            if (d1 <= 0.0 && d2 <= 0.0) return a;
+            const Eigen::Vector3d bp = p - b;
+            const double d3 = ab.dot(bp), d4 = ac.dot(bp);
+            if (d3 >= 0.0 && d4 <= d3) return b;
+            const double vc = d1 * d4 - d3 * d2;
+            if (vc <= 0.0 && d1 >= 0.0 && d3 <= 0.0) return a + d1 / (d1 - d3) * ab;
+            const Eigen::Vector3d cp = p - c;
+            const double d5 = ab.dot(cp), d6 = ac.dot(cp);
+            if (d6 >= 0.0 && d5 <= d6) return c;
+            const double vb = d5 * d2 - d1 * d6;
+            if (vb <= 0.0 && d2 >= 0.0 && d6 <= 0.0) return a + d2 / (d2 - d6) * ac;
+            const double va = d3 * d6 - d5 * d4;
+            if (va <= 0.0 && d4 - d3 >= 0.0 && d5 - d6 >= 0.0)
+                return b + (d4 - d3) / ((d4 - d3) + (d5 - d6)) * (c - b);
+            const double denom = 1.0 / (va + vb + vc);
+            return a + ab * (vb * denom) + ac * (vc * denom);
+        }
+    }
+
+    face_bvh::face_bvh(const triMesh &mesh, unsigned max_leaf_size) {
+        build(mesh, max_leaf_size);
+    }
+
+    // — Build —
+    void face_bvh::build(const triMesh &mesh, unsigned max_leaf_size) {
+        const auto &faces = mesh.get_faces();
+        const std::size_t n = faces.size();
+        topology_version_ = mesh.topology_version();
+
+        std::vector<Eigen::AlignedBox3d> boxes(n);
+        std::vector<Eigen::Vector3d> centroids(n);
+        parallel_for(0, n, [&](std::size_t i) {
+            auto [a,b,c] = faces[i]->get_vertices();
+            const Eigen::Vector3d pa = a->get_position(), pb = b->get_position(), pc = c->get_position();
+            boxes[i] = Eigen::AlignedBox3d(pa);
+            boxes[i].extend(pb).extend(pc);
+            centroids[i] = (pa + pb + pc) / 3.0;
+        });
+
+        std::vector<unsigned> order(n);
+        std::iota(order.begin(), order.end(), 0u);
+        nodes_.clear();
+        if (n > 0) {
+            const Builder builder{boxes, centroids, order, std::max(max_leaf_size, 1u)};
+            builder.build(nodes_, 0, n, 0);
+        }
+
+        // triangles in leaf order, and three spare ones so leaves of any
+        // size run in the four-wide kernel
+        triangles_.resize(n + 3);
+        faces_.resize(n);
+        corners_.resize(n);
+        parallel_for(0, n, [&](std::size_t i) {
+            const auto &face = faces[order[i]];
+            auto [a,b,c] = face->get_vertices();
+            set_corners(triangles_, i, a->get_position(), b->get_position(), c->get_position());
+            faces_[i] = face->get_handle();
+            corners_[i] = {a->get_handle(), b->get_handle(), c->get_handle()};
+        });
+        update_bounds();
+    }
+
+    void face_bvh::refit(const triMesh &mesh) {
+        if (mesh.topology_version() != topology_version_ || mesh.get_faces().size() != faces_.size())
+            throw std::runtime_error("face_bvh::refit: the mesh topology changed, build again");
+        parallel_for(0, faces_.size(), [&](std::size_t i) {
+            const auto &c = corners_[i];
+            set_corners(triangles_, i, mesh.get_vertex(c[0])->get_position(),
+                        mesh.get_vertex(c[1])->get_position(), mesh.get_vertex(c[2])->get_position());
+        });
+        update_bounds();
+    }
+
+    // Leaves from their triangles in parallel, then inner nodes from the
+    // back: children always sit after their parent
+    void face_bvh::update_bounds() {
+        const auto set = [](Node &node, const Eigen::AlignedBox3d &box) {
+            for (int k = 0; k < 3; ++k) {
+                node.lo[k] = round_down(box.min()[k]);
+                node.hi[k] = round_up(box.max()[k]);
+            }
+        };
+        parallel_for(0, nodes_.size(), [&](std::size_t i) {
+            Node &node = nodes_[i];
+            if (node.count == 0) return;
+            Eigen::AlignedBox3d box;
+            for (std::size_t t = node.index; t < node.index + node.count; ++t)
+                for (int c = 0; c < 3; ++c)
+                    box.extend(corner(triangles_, t, c));
+            set(node, box);
+        });
+        for (std::size_t i = nodes_.size(); i-- > 0;) {
+            Node &node = nodes_[i];
+            if (node.count != 0) continue;
+            const Node &left = nodes_[i + 1], &right = nodes_[node.index];
+            for (int k = 0; k < 3; ++k) {
+                node.lo[k] = std::min(left.lo[k], right.lo[k]);
+                node.hi[k] = std::max(left.hi[k], right.hi[k]);
+            }
+        }
+    }
+
+    Eigen::AlignedBox3d face_bvh::bounds() const {
+        Eigen::AlignedBox3d box;
+        if (!nodes_.empty()) {
+            const Node &root = nodes_[0];
+            box.min() = Eigen::Vector3d(root.lo[0], root.lo[1], root.lo[2]);
+            box.max() = Eigen::Vector3d(root.hi[0], root.hi[1], root.hi[2]);
+        }
+        return box;
+    }
+
+    // — Queries —
+    RayHit face_bvh::intersect(const Ray &ray) const {
+        RayHit hit;
+        if (nodes_.empty()) return hit;
+        double t_max = ray.t_max;
+        std::size_t nearest = kNoHit;
+        trace(ray, 0, t_max, nearest, hit);
+        return hit;
+    }
+
+    bool face_bvh::occluded(const Ray &ray) const {
+        return !nodes_.empty() && any_hit(ray, 0);
+    }
+
+    void face_bvh::trace(const Ray &ray, std::uint32_t root, double &t_max, std::size_t &nearest, RayHit &hit) const {
+        const Eigen::Vector3d inverse = ray.direction.cwiseInverse();
+
+        // nodes still to visit with their entry distance, nearest on top
+        std::uint32_t stack[kStackSize];
+        double entry[kStackSize];
+        int top = 0;
+        if (enter_box(nodes_[root].lo, nodes_[root].hi, ray.origin, inverse, ray.t_min, t_max) == kInf) return;
+        stack[top] = root;
+        entry[top++] = ray.t_min;
+        while (top > 0) {
+            --top;
+            if (entry[top] > t_max) continue;
+            std::uint32_t index = stack[top];
+            while (true) {
+                const Node &node = nodes_[index];
+                if (node.count > 0) {
+                    const std::size_t end = node.index + node.count;
+                    double t = t_max, u, v;
+                    const std::size_t i = detail::nearest_hit(triangles_, node.index, end, ray.origin.data(),
+                                                              ray.direction.data(), ray.t_min, t, u, v);
+                    // ties go to the first face in leaf order, whatever the visiting order
+                    if (i != end && (t < t_max || i < nearest)) {
+                        nearest = i;
+                        t_max = t;
+                        hit = RayHit{faces_[i], t, u, v};
+                    }
+                    break;
+                }
+                const std::uint32_t left = index + 1, right = node.index;
+                const double t_left = enter_box(nodes_[left].lo, nodes_[left].hi, ray.origin, inverse, ray.t_min, t_max);
+                const double t_right = enter_box(nodes_[right].lo, nodes_[right].hi, ray.origin, inverse, ray.t_min, t_max);
+                if (t_left == kInf && t_right == kInf) break;
+                if (t_right == kInf) index = left;
+                else if (t_left == kInf) index = right;
+                else {
+                    const bool left_first = t_left <= t_right;
+                    stack[top] = left_first ? right : left;
+                    entry[top++] = left_first ? t_right : t_left;
+                    index = left_first ? left : right;
+                }
+            }
+        }
+    }
+
+    bool face_bvh::any_hit(const Ray &ray, std::uint32_t root) const {
+        const Eigen::Vector3d inverse = ray.direction.cwiseInverse();
+        std::uint32_t stack[kStackSize];
+        int top = 0;
+        stack[top++] = root;
+        while (top > 0) {
+            const Node &node = nodes_[stack[--top]];
+            if (enter_box(node.lo, node.hi, ray.origin, inverse, ray.t_min, ray.t_max) == kInf) continue;
+            if (node.count > 0) {
+                const std::size_t end = node.index + node.count;
+                double t_max = ray.t_max, u, v;
+                if (detail::nearest_hit(triangles_, node.index, end, ray.origin.data(), ray.direction.data(),
+                                        ray.t_min, t_max, u, v) != end)
+                    return true;
+                continue;
+            }
+            stack[top++] = node.index;
+            stack[top++] = static_cast<std::uint32_t>(&node - nodes_.data()) + 1;
+        }
+        return false;
+    }
+
+    void face_bvh::intersect(const Ray *rays, std::size_t count, RayHit *hits) const {
+        if (nodes_.empty()) {
+            std::fill(hits, hits + count, RayHit());
+            return;
+        }
+        for_each_packet(count, [&](std::size_t first, std::size_t n) {
+            intersect_packet(rays + first, n, hits + first);
+        });
+    }
+
+    std::vector<RayHit> face_bvh::intersect(const std::vector<Ray> &rays) const {
+        std::vector<RayHit> hits(rays.size());
+        intersect(rays.data(), rays.size(), hits.data());
+        return hits;
+    }
+
+    void face_bvh::occluded(const Ray *rays, std::size_t count, std::uint8_t *result) const {
+        if (nodes_.empty()) {
+            std::fill(result, result + count, std::uint8_t(0));
+            return;
+        }
+        for_each_packet(count, [&](std::size_t first, std::size_t n) {
+            occluded_packet(rays + first, n, result + first);
+        });
+    }
+
+    // The packet goes down the tree as one: each node is fetched once and
+    // its box tested against all rays still active, children are visited
+    // in the order the first active ray meets them, and leaves run the
+    // triangle kernel for each ray that reached them. A ray drops out of a
+    // subtree once its nearest hit so far is closer than the box.
+    void face_bvh::intersect_packet(const Ray *rays, std::size_t count, RayHit *hits) const {
+        if (!same_octant(rays, count)) {
+            for (std::size_t l = 0; l < count; ++l) hits[l] = intersect(rays[l]);
+            return;
+        }
+        detail::RayLanes packet;
+        const std::uint32_t all = load_packet(rays, count, packet);
+        std::size_t nearest[kPacketSize];
+        double u[kPacketSize], v[kPacketSize];
+        for (std::size_t l = 0; l < count; ++l) {
+            hits[l] = RayHit();
+            nearest[l] = kNoHit;
+        }
+
+        struct Visit {
+            std::uint32_t node, active;
+        };
+        Visit stack[kStackSize];
+        int top = 0;
+        stack[top++] = {0, all};
+        while (top > 0) {
+            const Visit visit = stack[--top];
+            const Node &node = nodes_[visit.node];
+            const std::uint32_t active = detail::lanes_entering_box(packet, visit.active, node.lo, node.hi);
+            if (active == 0) continue;
+            if (std::bitset<kPacketSize>(active).count() <= kMinActiveLanes) {
+                for (std::size_t l = 0; l < count; ++l)
+                    if (active >> l & 1u) trace(rays[l], visit.node, packet.t_max[l], nearest[l], hits[l]);
+                continue;
+            }
+            if (node.count > 0) {
+                const std::uint32_t took = detail::nearest_hits(triangles_, node.index, node.index + node.count,
+                                                                packet, active, nearest, u, v);
+                for (std::size_t l = 0; l < count; ++l)
+                    if (took >> l & 1u) hits[l] = RayHit{faces_[nearest[l]], packet.t_max[l], u[l], v[l]};
+                continue;
+            }
+            // near child by the centres on the axis the children are farthest apart
+            const std::uint32_t left = visit.node + 1, right = node.index;
+            const Node &a = nodes_[left], &b = nodes_[right];
+            int axis = 0;
+            float apart = -1.0f;
+            for (int k = 0; k < 3; ++k) {
+                const float d = std::abs((b.lo[k] + b.hi[k]) - (a.lo[k] + a.hi[k]));
+                if (d > apart) {
+                    apart = d;
+                    axis = k;
+                }
+            }
+            std::size_t lead = 0;
+            while (!(active >> lead & 1u)) ++lead;
+            const bool left_first = (a.lo[axis] + a.hi[axis] <= b.lo[axis] + b.hi[axis]) ==
+                                    (rays[lead].direction[axis] >= 0.0);
+            stack[top++] = {left_first ? right : left, active};
+            stack[top++] = {left_first ? left : right, active};
+        }
+    }
+
+    void face_bvh::occluded_packet(const Ray *rays, std::size_t count, std::uint8_t *result) const {
+        if (!same_octant(rays, count)) {
+            for (std::size_t l = 0; l < count; ++l) result[l] = occluded(rays[l]);
+            return;
+        }
+        detail::RayLanes packet;
+        const std::uint32_t all = load_packet(rays, count, packet);
+        std::uint32_t blocked = 0;
+        struct Visit {
+            std::uint32_t node, active;
+        };
+        Visit stack[kStackSize];
+        int top = 0;
+        stack[top++] = {0, all};
+        while (top > 0 && blocked != all) {
+            const Visit visit = stack[--top];
+            const Node &node = nodes_[visit.node];
+            const std::uint32_t active = detail::lanes_entering_box(packet, visit.active & ~blocked, node.lo, node.hi);
+            if (active == 0) continue;
+            if (std::bitset<kPacketSize>(active).count() <= kMinActiveLanes) {
+                for (std::size_t l = 0; l < count; ++l)
+                    if (active >> l & 1u && any_hit(rays[l], visit.node)) blocked |= 1u << l;
+                continue;
+            }
+            if (node.count > 0) {
+                const std::size_t end = node.index + node.count;
+                for (std::size_t l = 0; l < count; ++l) {
+                    if (!(active >> l & 1u)) continue;
+                    const Ray &ray = rays[l];
+                    double t = ray.t_max, u, v;
+                    if (detail::nearest_hit(triangles_, node.index, end, ray.origin.data(), ray.direction.data(),
+                                            ray.t_min, t, u, v) != end)
+                        blocked |= 1u << l;
+                }
+                continue;
+            }
+            stack[top++] = {node.index, active};
+            stack[top++] = {visit.node + 1, active};
+        }
+        for (std::size_t l = 0; l < count; ++l) result[l] = static_cast<std::uint8_t>(blocked >> l & 1u);
+    }
+
+    std::vector<std::uint8_t> face_bvh::occluded(const std::vector<Ray> &rays) const {
+        std::vector<std::uint8_t> result(rays.size());
+        occluded(rays.data(), rays.size(), result.data());
+        return result;
+    }
+
+    ClosestPoint face_bvh::closest_point(const Eigen::Vector3d &p, double max_distance) const {
+        ClosestPoint best;
+        if (nodes_.empty()) return best;
+        double best_d2 = max_distance * max_distance;
+
+        std::uint32_t stack[kStackSize];
+        double distance2[kStackSize];
+        int top = 0;
+        stack[top] = 0;
+        distance2[top++] = box_distance2(nodes_[0].lo, nodes_[0].hi, p);
+        while (top > 0) {
+            --top;
+            if (distance2[top] > best_d2) continue;
+            const std::uint32_t index = stack[top];
+            const Node &node = nodes_[index];
+            if (node.count > 0) {
+                for (std::uint32_t i = node.index; i < node.index + node.count; ++i) {
+                    const Eigen::Vector3d q = closest_on_triangle(p, corner(triangles_, i, 0), corner(triangles_, i, 1),
+                                                                  corner(triangles_, i, 2));
+                    const double d2 = (q - p).squaredNorm();
+                    if (d2 <= best_d2) {
+                        best_d2 = d2;
+                        best.face = faces_[i];
+                        best.point = q;
+                    }
+                }
+                continue;
+            }
+            // farther child below the nearer one
+            const std::uint32_t left = index + 1, right = node.index;
+            const double d_left = box_distance2(nodes_[left].lo, nodes_[left].hi, p);
+            const double d_right = box_distance2(nodes_[right].lo, nodes_[right].hi, p);
+            const bool left_first = d_left <= d_right;
+            stack[top] = left_first ? right : left;
+            distance2[top++] = left_first ? d_right : d_left;
+            stack[top] = left_first ? left : right;
+            distance2[top++] = left_first ? d_left : d_right;
+        }
+        if (best.face != std::numeric_limits<unsigned>::max()) best.distance = std::sqrt(best_d2);
+        return best;
+    }
+} // namespace halfMesh
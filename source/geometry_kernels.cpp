@@ -0,0 +1,512 @@
+#include "geometry_kernels.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <utility>
+
+#if !defined(HALFMESH_NO_SIMD) && (defined(__GNUC__) || defined(__clang__)) && \
+    (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define HALFMESH_AVX2_KERNELS 1
+#endif
+
+namespace halfMesh::detail {
+    namespace {
+        // s + x with the rounding error carried into e (Knuth's TwoSum)
+        inline void two_sum(double &s, double &e, double x) {
+            const double t = s + x;
+            const double z = t - s;
+            e += (s - (t - z)) + (x - z);
+            s = t;
+        }
+
+        inline void add_triangle(const TriangleBatch &b, std::size_t i, int lane, TriangleMoments &m) {
+            const double ax = b.ax[i], ay = b.ay[i], az = b.az[i];
+            const double bx = b.bx[i], by = b.by[i], bz = b.bz[i];
+            const double cx = b.cx[i], cy = b.cy[i], cz = b.cz[i];
+
+            const double e1x = bx - ax, e1y = by - ay, e1z = bz - az;
+            const double e2x = cx - ax, e2y = cy - ay, e2z = cz - az;
+            const double nx = e1y * e2z - e1z * e2y;
+            const double ny = e1z * e2x - e1x * e2z;
+            const double nz = e1x * e2y - e1y * e2x;
+            const double area2 = std::sqrt(nx * nx + ny * ny + nz * nz);
+
+            const double det = ax * (by * cz - bz * cy) + ay * (bz * cx - bx * cz) + az * (bx * cy - by * cx);
+            const double sx = ax + bx + cx, sy = ay + by + cy, sz = az + bz + cz;
+
+            const double terms[TriangleMoments::Count] = {
+                area2,
+                det,
+                det * sx, det * sy, det * sz,
+                det * (ax * ax + bx * bx + cx * cx + sx * sx),
+                det * (ay * ay + by * by + cy * cy + sy * sy),
+                det * (az * az + bz * bz + cz * cz + sz * sz),
+                det * (ax * ay + bx * by + cx * cy + sx * sy),
+                det * (ax * az + bx * bz + cx * cz + sx * sz),
+                det * (ay * az + by * bz + cy * cz + sy * sz),
+                area2 * sx, area2 * sy, area2 * sz
+            };
+            for (int t = 0; t < TriangleMoments::Count; ++t)
+                two_sum(m.sum[t][lane], m.error[t][lane], terms[t]);
+        }
+
+        inline bool enter_lane(const RayLanes &r, std::size_t lane, const float lo[3], const float hi[3]) {
+            double t_min = r.t_min[lane], t_max = r.t_max[lane];
+            for (int k = 0; k < 3; ++k) {
+                double t0 = (lo[k] - r.origin[k][lane]) * r.inverse[k][lane];
+                double t1 = (hi[k] - r.origin[k][lane]) * r.inverse[k][lane];
+                if (t0 > t1) std::swap(t0, t1);
+                if (t0 > t_min) t_min = t0;
+                if (t1 < t_max) t_max = t1;
+            }
+            return t_min <= t_max;
+        }
+
+        inline void normal_of(const TriangleBatch &b, std::size_t i,
+                              double *nx, double *ny, double *nz, double *area) {
+            const double e1x = b.bx[i] - b.ax[i], e1y = b.by[i] - b.ay[i], e1z = b.bz[i] - b.az[i];
+            const double e2x = b.cx[i] - b.ax[i], e2y = b.cy[i] - b.ay[i], e2z = b.cz[i] - b.az[i];
+            const double x = e1y * e2z - e1z * e2y;
+            const double y = e1z * e2x - e1x * e2z;
+            const double z = e1x * e2y - e1y * e2x;
+            const double length = std::sqrt(x * x + y * y + z * z);
+            const double inverse = length > 0 ? 1.0 / length : 0.0;
+            nx[i] = x * inverse;
+            ny[i] = y * inverse;
+            nz[i] = z * inverse;
+            area[i] = 0.5 * length;
+        }
+
+        // Moller-Trumbore for triangle i; NaNs (degenerate triangles) fail every test
+        inline bool hit_one(const TriangleBatch &b, std::size_t i, const double o[3], const double d[3],
+                            double &t, double &u, double &v) {
+            const double e1x = b.bx[i] - b.ax[i], e1y = b.by[i] - b.ay[i], e1z = b.bz[i] - b.az[i];
+            const double e2x = b.cx[i] - b.ax[i], e2y = b.cy[i] - b.ay[i], e2z = b.cz[i] - b.az[i];
+            const double px = d[1] * e2z - d[2] * e2y;
+            const double py = d[2] * e2x - d[0] * e2z;
+            const double pz = d[0] * e2y - d[1] * e2x;
+            const double det = e1x * px + e1y * py + e1z * pz;
+            const double inverse = 1.0 / det;
+            const double sx = o[0] - b.ax[i], sy = o[1] - b.ay[i], sz = o[2] - b.az[i];
+            const double qx = sy * e1z - sz * e1y;
+            const double qy = sz * e1x - sx * e1z;
+            const double qz = sx * e1y - sy * e1x;
+            u = (sx * px + sy * py + sz * pz) * inverse;
+            v = (d[0] * qx + d[1] * qy + d[2] * qz) * inverse;
+            t = (e2x * qx + e2y * qy + e2z * qz) * inverse;
+            return det != 0.0 && u >= 0.0 && u <= 1.0 && v >= 0.0 && u + v <= 1.0;
+        }
+
+#ifdef HALFMESH_AVX2_KERNELS
+#define HALFMESH_AVX2 __attribute__((target("avx2")))
+        HALFMESH_AVX2 inline __m256d mul(__m256d x, __m256d y) { return _mm256_mul_pd(x, y); }
+        HALFMESH_AVX2 inline __m256d add(__m256d x, __m256d y) { return _mm256_add_pd(x, y); }
+        HALFMESH_AVX2 inline __m256d sub(__m256d x, __m256d y) { return _mm256_sub_pd(x, y); }
+
+        // d * (a1 a2 + b1 b2 + c1 c2 + s1 s2), one entry of the DetCov term
+        HALFMESH_AVX2 inline __m256d cov(__m256d det, __m256d a1, __m256d a2, __m256d b1, __m256d b2,
+                                         __m256d c1, __m256d c2, __m256d s1, __m256d s2) {
+            return mul(det, add(add(add(mul(a1, a2), mul(b1, b2)), mul(c1, c2)), mul(s1, s2)));
+        }
+
+        // Same operations as add_triangle, four triangles (one per lane) at a time.
+        // No FMA: contracting would change the rounding against the scalar path.
+        HALFMESH_AVX2 void accumulate_avx2(const TriangleBatch &b, std::size_t begin, std::size_t end, TriangleMoments &m) {
+            __m256d sum[TriangleMoments::Count], err[TriangleMoments::Count];
+            for (int t = 0; t < TriangleMoments::Count; ++t) {
+                sum[t] = _mm256_loadu_pd(m.sum[t]);
+                err[t] = _mm256_loadu_pd(m.error[t]);
+            }
+            for (std::size_t i = begin; i + 4 <= end; i += 4) {
+                const __m256d ax = _mm256_loadu_pd(&b.ax[i]), ay = _mm256_loadu_pd(&b.ay[i]), az = _mm256_loadu_pd(&b.az[i]);
+                const __m256d bx = _mm256_loadu_pd(&b.bx[i]), by = _mm256_loadu_pd(&b.by[i]), bz = _mm256_loadu_pd(&b.bz[i]);
+                const __m256d cx = _mm256_loadu_pd(&b.cx[i]), cy = _mm256_loadu_pd(&b.cy[i]), cz = _mm256_loadu_pd(&b.cz[i]);
+
+                const __m256d e1x = sub(bx, ax), e1y = sub(by, ay), e1z = sub(bz, az);
+                const __m256d e2x = sub(cx, ax), e2y = sub(cy, ay), e2z = sub(cz, az);
+                const __m256d nx = sub(mul(e1y, e2z), mul(e1z, e2y));
+                const __m256d ny = sub(mul(e1z, e2x), mul(e1x, e2z));
+                const __m256d nz = sub(mul(e1x, e2y), mul(e1y, e2x));
+                const __m256d area2 = _mm256_sqrt_pd(add(add(mul(nx, nx), mul(ny, ny)), mul(nz, nz)));
+
+                const __m256d det = add(add(mul(ax, sub(mul(by, cz), mul(bz, cy))),
+                                            mul(ay, sub(mul(bz, cx), mul(bx, cz)))),
+                                        mul(az, sub(mul(bx, cy), mul(by, cx))));
+                const __m256d sx = add(add(ax, bx), cx), sy = add(add(ay, by), cy), sz = add(add(az, bz), cz);
+
+                const __m256d terms[TriangleMoments::Count] = {
+                    area2,
+                    det,
+                    mul(det, sx), mul(det, sy), mul(det, sz),
+                    cov(det, ax, ax, bx, bx, cx, cx, sx, sx),
+                    cov(det, ay, ay, by, by, cy, cy, sy, sy),
+                    cov(det, az, az, bz, bz, cz, cz, sz, sz),
+                    cov(det, ax, ay, bx, by, cx, cy, sx, sy),
+                    cov(det, ax, az, bx, bz, cx, cz, sx, sz),
+                    cov(det, ay, az, by, bz, cy, cz, sy, sz),
+                    mul(area2, sx), mul(area2, sy), mul(area2, sz)
+                };
+                for (int t = 0; t < TriangleMoments::Count; ++t) {
+                    const __m256d s = add(sum[t], terms[t]);
+                    const __m256d z = sub(s, sum[t]);
+                    err[t] = add(err[t], add(sub(sum[t], sub(s, z)), sub(terms[t], z)));
+                    sum[t] = s;
+                }
+            }
+            for (int t = 0; t < TriangleMoments::Count; ++t) {
+                _mm256_storeu_pd(m.sum[t], sum[t]);
+                _mm256_storeu_pd(m.error[t], err[t]);
+            }
+        }
+
+        HALFMESH_AVX2 void normals_avx2(const TriangleBatch &b, std::size_t n,
+                                        double *nx, double *ny, double *nz, double *area) {
+            const __m256d zero = _mm256_setzero_pd(), one = _mm256_set1_pd(1.0), half = _mm256_set1_pd(0.5);
+            for (std::size_t i = 0; i + 4 <= n; i += 4) {
+                const __m256d ax = _mm256_loadu_pd(&b.ax[i]), ay = _mm256_loadu_pd(&b.ay[i]), az = _mm256_loadu_pd(&b.az[i]);
+                const __m256d e1x = sub(_mm256_loadu_pd(&b.bx[i]), ax);
+                const __m256d e1y = sub(_mm256_loadu_pd(&b.by[i]), ay);
+                const __m256d e1z = sub(_mm256_loadu_pd(&b.bz[i]), az);
+                const __m256d e2x = sub(_mm256_loadu_pd(&b.cx[i]), ax);
+                const __m256d e2y = sub(_mm256_loadu_pd(&b.cy[i]), ay);
+                const __m256d e2z = sub(_mm256_loadu_pd(&b.cz[i]), az);
+                const __m256d x = sub(mul(e1y, e2z), mul(e1z, e2y));
+                const __m256d y = sub(mul(e1z, e2x), mul(e1x, e2z));
+                const __m256d z = sub(mul(e1x, e2y), mul(e1y, e2x));
+                const __m256d length = _mm256_sqrt_pd(add(add(mul(x, x), mul(y, y)), mul(z, z)));
+                const __m256d inverse = _mm256_and_pd(_mm256_cmp_pd(length, zero, _CMP_GT_OQ),
+                                                      _mm256_div_pd(one, length));
+                _mm256_storeu_pd(nx + i, mul(x, inverse));
+                _mm256_storeu_pd(ny + i, mul(y, inverse));
+                _mm256_storeu_pd(nz + i, mul(z, inverse));
+                _mm256_storeu_pd(area + i, mul(half, length));
+            }
+        }
+
+        HALFMESH_AVX2 void bounds_avx2(const double *x, const double *y, const double *z, std::size_t n,
+                         double lo[3], double hi[3]) {
+            __m256d lx = _mm256_set1_pd(lo[0]), ly = _mm256_set1_pd(lo[1]), lz = _mm256_set1_pd(lo[2]);
+            __m256d hx = _mm256_set1_pd(hi[0]), hy = _mm256_set1_pd(hi[1]), hz = _mm256_set1_pd(hi[2]);
+            std::size_t i = 0;
+            for (; i + 4 <= n; i += 4) {
+                const __m256d px = _mm256_loadu_pd(x + i), py = _mm256_loadu_pd(y + i), pz = _mm256_loadu_pd(z + i);
+                lx = _mm256_min_pd(lx, px);
+                ly = _mm256_min_pd(ly, py);
+                lz = _mm256_min_pd(lz, pz);
+                hx = _mm256_max_pd(hx, px);
+                hy = _mm256_max_pd(hy, py);
+                hz = _mm256_max_pd(hz, pz);
+            }
+            double l[3][4], h[3][4];
+            _mm256_storeu_pd(l[0], lx);
+            _mm256_storeu_pd(l[1], ly);
+            _mm256_storeu_pd(l[2], lz);
+            _mm256_storeu_pd(h[0], hx);
+            _mm256_storeu_pd(h[1], hy);
+            _mm256_storeu_pd(h[2], hz);
+            for (int k = 0; k < 3; ++k)
+                for (int lane = 0; lane < 4; ++lane) {
+                    lo[k] = std::min(lo[k], l[k][lane]);
+                    hi[k] = std::max(hi[k], h[k][lane]);
+                }
+            for (; i < n; ++i) {
+                lo[0] = std::min(lo[0], x[i]);
+                lo[1] = std::min(lo[1], y[i]);
+                lo[2] = std::min(lo[2], z[i]);
+                hi[0] = std::max(hi[0], x[i]);
+                hi[1] = std::max(hi[1], y[i]);
+                hi[2] = std::max(hi[2], z[i]);
+            }
+        }
+
+        // Same operations as hit_one for triangles i..i+3; returns the lane mask
+        HALFMESH_AVX2 int hit_four_avx2(const TriangleBatch &b, std::size_t i, const double o[3], const double d[3],
+                                        double *t, double *u, double *v) {
+            const __m256d dx = _mm256_set1_pd(d[0]), dy = _mm256_set1_pd(d[1]), dz = _mm256_set1_pd(d[2]);
+            const __m256d ax = _mm256_loadu_pd(&b.ax[i]), ay = _mm256_loadu_pd(&b.ay[i]), az = _mm256_loadu_pd(&b.az[i]);
+            const __m256d e1x = sub(_mm256_loadu_pd(&b.bx[i]), ax);
+            const __m256d e1y = sub(_mm256_loadu_pd(&b.by[i]), ay);
+            const __m256d e1z = sub(_mm256_loadu_pd(&b.bz[i]), az);
+            const __m256d e2x = sub(_mm256_loadu_pd(&b.cx[i]), ax);
+            const __m256d e2y = sub(_mm256_loadu_pd(&b.cy[i]), ay);
+            const __m256d e2z = sub(_mm256_loadu_pd(&b.cz[i]), az);
+            const __m256d px = sub(mul(dy, e2z), mul(dz, e2y));
+            const __m256d py = sub(mul(dz, e2x), mul(dx, e2z));
+            const __m256d pz = sub(mul(dx, e2y), mul(dy, e2x));
+            const __m256d det = add(add(mul(e1x, px), mul(e1y, py)), mul(e1z, pz));
+            const __m256d inverse = _mm256_div_pd(_mm256_set1_pd(1.0), det);
+            const __m256d sx = sub(_mm256_set1_pd(o[0]), ax);
+            const __m256d sy = sub(_mm256_set1_pd(o[1]), ay);
+            const __m256d sz = sub(_mm256_set1_pd(o[2]), az);
+            const __m256d qx = sub(mul(sy, e1z), mul(sz, e1y));
+            const __m256d qy = sub(mul(sz, e1x), mul(sx, e1z));
+            const __m256d qz = sub(mul(sx, e1y), mul(sy, e1x));
+            const __m256d uu = mul(add(add(mul(sx, px), mul(sy, py)), mul(sz, pz)), inverse);
+            const __m256d vv = mul(add(add(mul(dx, qx), mul(dy, qy)), mul(dz, qz)), inverse);
+            const __m256d tt = mul(add(add(mul(e2x, qx), mul(e2y, qy)), mul(e2z, qz)), inverse);
+            const __m256d zero = _mm256_setzero_pd(), one = _mm256_set1_pd(1.0);
+            __m256d inside = _mm256_cmp_pd(det, zero, _CMP_NEQ_UQ);
+            inside = _mm256_and_pd(inside, _mm256_cmp_pd(uu, zero, _CMP_GE_OQ));
+            inside = _mm256_and_pd(inside, _mm256_cmp_pd(uu, one, _CMP_LE_OQ));
+            inside = _mm256_and_pd(inside, _mm256_cmp_pd(vv, zero, _CMP_GE_OQ));
+            inside = _mm256_and_pd(inside, _mm256_cmp_pd(add(uu, vv), one, _CMP_LE_OQ));
+            const int mask = _mm256_movemask_pd(inside);
+            if (mask != 0) {
+                _mm256_storeu_pd(t, tt);
+                _mm256_storeu_pd(u, uu);
+                _mm256_storeu_pd(v, vv);
+            }
+            return mask;
+        }
+
+        // Same result as enter_lane, four lanes at a time. min / max return
+        // their second operand on NaN or equal inputs, which is exactly the
+        // compare-and-keep of the scalar test.
+        HALFMESH_AVX2 std::uint32_t enter_box_avx2(const RayLanes &r, std::uint32_t active,
+                                                   const float lo[3], const float hi[3]) {
+            const __m256d low[3] = {_mm256_set1_pd(lo[0]), _mm256_set1_pd(lo[1]), _mm256_set1_pd(lo[2])};
+            const __m256d high[3] = {_mm256_set1_pd(hi[0]), _mm256_set1_pd(hi[1]), _mm256_set1_pd(hi[2])};
+            std::uint32_t entering = 0;
+            for (std::size_t first = 0; first < kPacketLanes; first += 4) {
+                if (!(active >> first & 0xfu)) continue;
+                __m256d t_min = _mm256_load_pd(&r.t_min[first]);
+                __m256d t_max = _mm256_load_pd(&r.t_max[first]);
+                for (int k = 0; k < 3; ++k) {
+                    const __m256d origin = _mm256_load_pd(&r.origin[k][first]);
+                    const __m256d inverse = _mm256_load_pd(&r.inverse[k][first]);
+                    const __m256d t0 = mul(sub(low[k], origin), inverse);
+                    const __m256d t1 = mul(sub(high[k], origin), inverse);
+                    t_min = _mm256_max_pd(_mm256_min_pd(t1, t0), t_min);
+                    t_max = _mm256_min_pd(_mm256_max_pd(t0, t1), t_max);
+                }
+                entering |= static_cast<std::uint32_t>(
+                    _mm256_movemask_pd(_mm256_cmp_pd(t_min, t_max, _CMP_LE_OQ))) << first;
+            }
+            return entering & active;
+        }
+
+        // Same operations as hit_one for triangle i against lanes
+        // first..first+3; returns the mask of lanes crossing it in [t_min, t_max]
+        HALFMESH_AVX2 int hit_lanes_avx2(const TriangleBatch &b, std::size_t i, const RayLanes &r, std::size_t first,
+                                         double *t, double *u, double *v) {
+            const __m256d ax = _mm256_set1_pd(b.ax[i]), ay = _mm256_set1_pd(b.ay[i]), az = _mm256_set1_pd(b.az[i]);
+            const __m256d e1x = sub(_mm256_set1_pd(b.bx[i]), ax);
+            const __m256d e1y = sub(_mm256_set1_pd(b.by[i]), ay);
+            const __m256d e1z = sub(_mm256_set1_pd(b.bz[i]), az);
+            const __m256d e2x = sub(_mm256_set1_pd(b.cx[i]), ax);
+            const __m256d e2y = sub(_mm256_set1_pd(b.cy[i]), ay);
+            const __m256d e2z = sub(_mm256_set1_pd(b.cz[i]), az);
+            const __m256d dx = _mm256_load_pd(&r.direction[0][first]);
+            const __m256d dy = _mm256_load_pd(&r.direction[1][first]);
+            const __m256d dz = _mm256_load_pd(&r.direction[2][first]);
+            const __m256d px = sub(mul(dy, e2z), mul(dz, e2y));
+            const __m256d py = sub(mul(dz, e2x), mul(dx, e2z));
+            const __m256d pz = sub(mul(dx, e2y), mul(dy, e2x));
+            const __m256d det = add(add(mul(e1x, px), mul(e1y, py)), mul(e1z, pz));
+            const __m256d inverse = _mm256_div_pd(_mm256_set1_pd(1.0), det);
+            const __m256d sx = sub(_mm256_load_pd(&r.origin[0][first]), ax);
+            const __m256d sy = sub(_mm256_load_pd(&r.origin[1][first]), ay);
+            const __m256d sz = sub(_mm256_load_pd(&r.origin[2][first]), az);
+            const __m256d qx = sub(mul(sy, e1z), mul(sz, e1y));
+            const __m256d qy = sub(mul(sz, e1x), mul(sx, e1z));
+            const __m256d qz = sub(mul(sx, e1y), mul(sy, e1x));
+            const __m256d uu = mul(add(add(mul(sx, px), mul(sy, py)), mul(sz, pz)), inverse);
+            const __m256d vv = mul(add(add(mul(dx, qx), mul(dy, qy)), mul(dz, qz)), inverse);
+            const __m256d tt = mul(add(add(mul(e2x, qx), mul(e2y, qy)), mul(e2z, qz)), inverse);
+            const __m256d zero = _mm256_setzero_pd(), one = _mm256_set1_pd(1.0);
+            __m256d inside = _mm256_cmp_pd(det, zero, _CMP_NEQ_UQ);
+            inside = _mm256_and_pd(inside, _mm256_cmp_pd(uu, zero, _CMP_GE_OQ));
+            inside = _mm256_and_pd(inside, _mm256_cmp_pd(uu, one, _CMP_LE_OQ));
+            inside = _mm256_and_pd(inside, _mm256_cmp_pd(vv, zero, _CMP_GE_OQ));
+            inside = _mm256_and_pd(inside, _mm256_cmp_pd(add(uu, vv), one, _CMP_LE_OQ));
+            inside = _mm256_and_pd(inside, _mm256_cmp_pd(tt, _mm256_load_pd(&r.t_min[first]), _CMP_GE_OQ));
+            inside = _mm256_and_pd(inside, _mm256_cmp_pd(tt, _mm256_load_pd(&r.t_max[first]), _CMP_LE_OQ));
+            const int mask = _mm256_movemask_pd(inside);
+            if (mask != 0) {
+                _mm256_storeu_pd(t, tt);
+                _mm256_storeu_pd(u, uu);
+                _mm256_storeu_pd(v, vv);
+            }
+            return mask;
+        }
+
+        std::atomic<bool> avx2_enabled{true};
+
+        bool cpu_has_avx2() {
+            static const bool has = __builtin_cpu_supports("avx2");
+            return has && avx2_enabled.load(std::memory_order_relaxed);
+        }
+#endif
+    }
+
+    // — TriangleMoments —
+    void TriangleMoments::merge(const TriangleMoments &other) {
+        for (int t = 0; t < Count; ++t)
+            for (int lane = 0; lane < kLanes; ++lane) {
+                two_sum(sum[t][lane], error[t][lane], other.sum[t][lane]);
+                error[t][lane] += other.error[t][lane];
+            }
+    }
+
+    double TriangleMoments::total(int term) const {
+        double s = 0.0, e = 0.0;
+        for (int lane = 0; lane < kLanes; ++lane) two_sum(s, e, sum[term][lane]);
+        for (int lane = 0; lane < kLanes; ++lane) e += error[term][lane];
+        return s + e;
+    }
+
+    void TriangleBatch::resize(std::size_t n) {
+        for (auto *v: {&ax, &ay, &az, &bx, &by, &bz, &cx, &cy, &cz}) v->resize(n);
+    }
+
+    // — Kernels —
+    void accumulate_moments(const TriangleBatch &batch, std::size_t n, std::size_t first,
+                            TriangleMoments &moments) {
+        std::size_t i = 0;
+#ifdef HALFMESH_AVX2_KERNELS
+        if (cpu_has_avx2()) {
+            // scalar up to a lane boundary, then whole groups of four
+            for (; i < n && (first + i) % TriangleMoments::kLanes != 0; ++i)
+                add_triangle(batch, i, static_cast<int>((first + i) % TriangleMoments::kLanes), moments);
+            const std::size_t groups_end = i + (n - i) / 4 * 4;
+            accumulate_avx2(batch, i, groups_end, moments);
+            i = groups_end;
+        }
+#endif
+        for (; i < n; ++i)
+            add_triangle(batch, i, static_cast<int>((first + i) % TriangleMoments::kLanes), moments);
+    }
+
+    void triangle_normals(const TriangleBatch &batch, std::size_t n,
+                          double *nx, double *ny, double *nz, double *area) {
+        std::size_t i = 0;
+#ifdef HALFMESH_AVX2_KERNELS
+        if (cpu_has_avx2()) {
+            normals_avx2(batch, n, nx, ny, nz, area);
+            i = n / 4 * 4;
+        }
+#endif
+        for (; i < n; ++i) normal_of(batch, i, nx, ny, nz, area);
+    }
+
+    void extend_bounds(const double *x, const double *y, const double *z, std::size_t n,
+                       double lo[3], double hi[3]) {
+#ifdef HALFMESH_AVX2_KERNELS
+        if (cpu_has_avx2()) {
+            bounds_avx2(x, y, z, n, lo, hi);
+            return;
+        }
+#endif
+        for (std::size_t i = 0; i < n; ++i) {
+            lo[0] = std::min(lo[0], x[i]);
+            lo[1] = std::min(lo[1], y[i]);
+            lo[2] = std::min(lo[2], z[i]);
+            hi[0] = std::max(hi[0], x[i]);
+            hi[1] = std::max(hi[1], y[i]);
+            hi[2] = std::max(hi[2], z[i]);
+        }
+    }
+
+    std::size_t nearest_hit(const TriangleBatch &batch, std::size_t begin, std::size_t end,
+                            const double origin[3], const double direction[3],
+                            double t_min, double &t_max, double &u, double &v) {
+        std::size_t nearest = end;
+        const auto take = [&](std::size_t i, double ti, double ui, double vi) {
+            if (ti >= t_min && (nearest == end ? ti <= t_max : ti < t_max)) {
+                nearest = i;
+                t_max = ti;
+                u = ui;
+                v = vi;
+            }
+        };
+        std::size_t i = begin;
+#ifdef HALFMESH_AVX2_KERNELS
+        if (cpu_has_avx2()) {
+            // a tail of one to three triangles goes through the vector
+            // kernel too when the arrays reach a whole group past it, with
+            // the lanes beyond end masked off
+            const std::size_t room = batch.ax.size();
+            double t[4], uu[4], vv[4];
+            for (; i < end && i + 4 <= room; i += 4) {
+                int mask = hit_four_avx2(batch, i, origin, direction, t, uu, vv);
+                if (end - i < 4) mask &= (1 << (end - i)) - 1;
+                for (int lane = 0; lane < 4; ++lane)
+                    if (mask >> lane & 1) take(i + lane, t[lane], uu[lane], vv[lane]);
+            }
+        }
+#endif
+        for (; i < end; ++i) {
+            double t, uu, vv;
+            if (hit_one(batch, i, origin, direction, t, uu, vv)) take(i, t, uu, vv);
+        }
+        return nearest;
+    }
+
+    std::uint32_t lanes_entering_box(const RayLanes &rays, std::uint32_t active,
+                                     const float lo[3], const float hi[3]) {
+        std::uint32_t entering = 0;
+#ifdef HALFMESH_AVX2_KERNELS
+        if (cpu_has_avx2()) return enter_box_avx2(rays, active, lo, hi);
+#endif
+        for (std::size_t lane = 0; lane < kPacketLanes; ++lane)
+            if (active >> lane & 1u && enter_lane(rays, lane, lo, hi)) entering |= 1u << lane;
+        return entering;
+    }
+
+    std::uint32_t nearest_hits(const TriangleBatch &batch, std::size_t begin, std::size_t end,
+                               RayLanes &rays, std::uint32_t active, std::size_t *nearest,
+                               double *u, double *v) {
+        std::uint32_t took = 0;
+        const auto take = [&](std::size_t lane, std::size_t i, double t, double ui, double vi) {
+            if (t < rays.t_max[lane] || i < nearest[lane]) {
+                rays.t_max[lane] = t;
+                nearest[lane] = i;
+                u[lane] = ui;
+                v[lane] = vi;
+                took |= 1u << lane;
+            }
+        };
+#ifdef HALFMESH_AVX2_KERNELS
+        if (cpu_has_avx2()) {
+            double t[4], uu[4], vv[4];
+            for (std::size_t i = begin; i < end; ++i)
+                for (std::size_t first = 0; first < kPacketLanes; first += 4) {
+                    if (!(active >> first & 0xfu)) continue;
+                    const int mask = hit_lanes_avx2(batch, i, rays, first, t, uu, vv) &
+                                     static_cast<int>(active >> first & 0xfu);
+                    for (int lane = 0; lane < 4; ++lane)
+                        if (mask >> lane & 1) take(first + lane, i, t[lane], uu[lane], vv[lane]);
+                }
+            return took;
+        }
+#endif
+        for (std::size_t lane = 0; lane < kPacketLanes; ++lane) {
+            if (!(active >> lane & 1u)) continue;
+            const double origin[3] = {rays.origin[0][lane], rays.origin[1][lane], rays.origin[2][lane]};
+            const double direction[3] = {rays.direction[0][lane], rays.direction[1][lane], rays.direction[2][lane]};
+            for (std::size_t i = begin; i < end; ++i) {
+                double t, uu, vv;
+                if (hit_one(batch, i, origin, direction, t, uu, vv) && t >= rays.t_min[lane] && t <= rays.t_max[lane])
+                    take(lane, i, t, uu, vv);
+            }
+        }
+        return took;
+    }
+
+    bool simd_kernels_active() {
+#ifdef HALFMESH_AVX2_KERNELS
+        return cpu_has_avx2();
+#else
+        return false;
+#endif
+    }
+
+    void enable_simd_kernels(bool enabled) {
+#ifdef HALFMESH_AVX2_KERNELS
+        avx2_enabled.store(enabled, std::memory_order_relaxed);
+#else
+        (void) enabled;
+#endif
+    }
+} // namespace halfMesh::detail
@@ -0,0 +1,56 @@
+#include "mapped_file.hpp"
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define HALFMESH_HAS_MMAP 1
+#endif
+
+namespace halfMesh {
+    mapped_file::mapped_file(const std::string &filename) {
+#ifdef HALFMESH_HAS_MMAP
+        const int fd = ::open(filename.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw std::runtime_error("Could not open " + filename);
+        }
+        struct stat st{};
+        if (::fstat(fd, &st) != 0) {
+            ::close(fd);
+            throw std::runtime_error("Could not stat " + filename);
+        }
+        size_ = static_cast<std::size_t>(st.st_size);
+        if (size_ > 0) {
+            void *p = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p != MAP_FAILED) {
+                // we scan front to back, let the kernel read ahead
+                ::madvise(p, size_, MADV_SEQUENTIAL);
+                data_ = static_cast<const char *>(p);
+                mapped_ = true;
+            }
+        }
+        ::close(fd);
+        if (mapped_ || size_ == 0) return;
+#endif
+        // fallback: slurp the file
+        std::ifstream in(filename, std::ios::binary);
+        if (!in) {
+            throw std::runtime_error("Could not open " + filename);
+        }
+        buffer_.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        data_ = buffer_.data();
+        size_ = buffer_.size();
+    }
+
+    mapped_file::~mapped_file() {
+#ifdef HALFMESH_HAS_MMAP
+        if (mapped_) {
+            ::munmap(const_cast<char *>(data_), size_);
+        }
+#endif
+    }
+} // namespace halfMesh
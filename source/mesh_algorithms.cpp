@@ -1,6 +1,9 @@
 #include "triMesh.hpp"
-#include <unordered_set>
-#include <queue>
+#include "task_scheduler.hpp"
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <memory>
 #include <vector>
 
 namespace halfMesh {
@@ -9,168 +12,457 @@ namespace halfMesh {
     }
 
     unsigned triMesh::compute_number_of_holes() const {
-        // collect boundary half-edges
-        std::vector<halfEdgePtr> boundaries;
-        for (auto &he: half_edges_) {
-            if (he->is_boundary())
-                boundaries.push_back(he);
+        return static_cast<unsigned>(boundary_loops().size());
+    }
+
+    namespace {
+        enum class EdgeUse { Unused, Boundary, Interior, NonManifold, Inconsistent };
+
+        // Two faces on an edge share one directed half-edge when they run it
+        // the same way, and then the half-edge has no opposite
+        EdgeUse edge_use(const edgePtr &e) {
+            const unsigned n = e->get_face_count();
+            if (n == 0) return EdgeUse::Unused;
+            if (n == 1) return EdgeUse::Boundary;
+            if (n > 2) return EdgeUse::NonManifold;
+            const auto he = e->get_one_half_edge();
+            return he && he->get_opposing_half_edge() ? EdgeUse::Interior : EdgeUse::Inconsistent;
         }
 
-        std::unordered_set<unsigned> used;
-        unsigned loops = 0;
-        for (const auto &start: boundaries) {
-            unsigned h0 = start->get_handle();
-            if (used.count(h0)) continue;
-            auto cur = start;
-            do {
-                used.insert(cur->get_handle());
-                // next boundary around vertex_two
-                auto v = cur->get_vertex_two();
-                halfEdgePtr next = nullptr;
-                for (auto &cand: v->get_outgoing_half_edges()) {
-                    if (cand != cur && cand->is_boundary()) {
-                        next = cand;
-                        break;
-                    }
-                }
-                cur = next;
-            } while (cur && cur->get_handle() != h0);
-            ++loops;
+        // A half-edge on a hole: the only side of an edge used by one face.
+        // An edge two faces run the same way has no opposite either, but
+        // it is not a boundary.
+        bool on_boundary(const halfEdgePtr &he) {
+            if (he->get_opposing_half_edge() || !he->get_parent_face()) return false;
+            const auto e = he->get_parent_edge();
+            return e && edge_use(e) == EdgeUse::Boundary;
         }
-        return loops;
     }
 
-    bool triMesh::has_boundary() const {
-        for (auto &e: edges_) {
-            if (e->is_boundary()) {
-                return true;
+    BoundaryLoops triMesh::boundary_loops() const {
+        if (const auto cached = std::atomic_load(&loop_cache_); cached && cached->version == topology_version_)
+            return cached->loops;
+
+        // boundary half-edges in mesh order
+        std::vector<halfEdgePtr> boundary = parallel_reduce(
+            std::size_t(0), half_edges_.size(), std::vector<halfEdgePtr>{},
+            [this](std::vector<halfEdgePtr> found, std::size_t i) {
+                const auto &he = half_edges_[i];
+                if (on_boundary(he)) found.push_back(he);
+                return found;
+            },
+            [](std::vector<halfEdgePtr> a, const std::vector<halfEdgePtr> &b) {
+                a.insert(a.end(), b.begin(), b.end());
+                return a;
+            });
+
+        // The boundary half-edge leaving the end of he: turn around that
+        // vertex through the faces until an edge has no opposite. The walk
+        // stops at an edge with no opposite that is not a boundary (two
+        // faces running it the same way), and is bounded so a broken fan
+        // cannot spin forever.
+        const auto next_boundary = [](const halfEdgePtr &he, std::size_t limit) -> halfEdgePtr {
+            halfEdgePtr cur = he->next();
+            for (std::size_t steps = 0; cur && steps < limit; ++steps) {
+                const auto opposite = cur->get_opposing_half_edge();
+                if (!opposite) return on_boundary(cur) ? cur : nullptr;
+                cur = opposite->next();
             }
+            return nullptr;
+        };
+
+        auto cache = std::make_shared<LoopCache>();
+        cache->version = topology_version_;
+        BoundaryLoops &loops = cache->loops;
+        loops.half_edges.reserve(boundary.size());
+        loops.vertices.reserve(boundary.size());
+        std::vector<char> used(next_half_edge_handle_, 0);
+        for (const auto &start: boundary) {
+            if (used[start->get_handle()]) continue;
+            halfEdgePtr cur = start;
+            do {
+                used[cur->get_handle()] = 1;
+                loops.half_edges.push_back(cur->get_handle());
+                loops.vertices.push_back(cur->get_vertex_one()->get_handle());
+                cur = next_boundary(cur, half_edges_.size());
+            } while (cur && cur != start && !used[cur->get_handle()]);
+            loops.offsets.push_back(loops.half_edges.size());
         }
-        return false;
+
+        const std::shared_ptr<const LoopCache> result = std::move(cache);
+        std::atomic_store(&loop_cache_, result);
+        return result->loops;
+    }
+
+    bool triMesh::has_boundary() const {
+        return topology_summary().has_boundary();
     }
 
     int triMesh::euler_characteristic() const {
-        return static_cast<int>(vertices_.size()  - edges_.size() + faces_.size());
+        return topology_summary().euler_characteristic;
     }
 
     int triMesh::genus() const {
-        const int chi = euler_characteristic();
-        const int b = has_boundary() ? compute_number_of_holes() : 0;
-        return (2 - b - chi) / 2;
+        return topology_summary().genus;
     }
 
-    bool triMesh::is_edge_manifold() const {
-        for (auto &e: edges_) {
-            const auto he0 = e->get_one_half_edge();
-            if (!he0) continue;
-            int count = 1;
-            if (he0->get_opposing_half_edge()) ++count;
-            if (count > 2) return false;
+    namespace {
+        // Corners in the fan of `start` (an outgoing half-edge), walking
+        // clockwise to the fan's first corner and then counter-clockwise;
+        // stops after limit steps on broken links
+        unsigned fan_size(const halfEdgePtr &start, unsigned limit) {
+            halfEdgePtr first = start;
+            for (unsigned steps = 0; steps < limit; ++steps) {
+                const auto opposite = first->get_opposing_half_edge();
+                const auto previous = opposite ? opposite->next() : nullptr;
+                if (!previous || previous == start) break;
+                first = previous;
+            }
+            unsigned count = 1;
+            for (halfEdgePtr he = first; count <= limit; ++count) {
+                const auto incoming = he->prev();
+                const auto next = incoming ? incoming->get_opposing_half_edge() : nullptr;
+                if (!next || next == first) break;
+                he = next;
+            }
+            return count;
         }
-        return true;
+    }
+
+    bool triMesh::is_edge_manifold() const {
+        return topology_summary().edge_manifold;
     }
 
     bool triMesh::is_manifold() const {
-        if (!is_edge_manifold()) return false;
-
-        for (auto &v: vertices_) {
-            auto inc_faces = one_ring_faces_of_a_vertex(v);
-            if (inc_faces.empty()) continue;
-
-            std::unordered_set<unsigned> seen;
-            std::queue<facePtr> Q;
-            auto it = inc_faces.begin();
-            Q.push(*it);
-            seen.insert((*it)->get_handle());
-
-            while (!Q.empty()) {
-                auto f = Q.front();
-                Q.pop();
-                for (auto &nbr: adjacent_faces(f)) {
-                    if (inc_faces.count(nbr) == 0) continue;
-                    unsigned h = nbr->get_handle();
-                    if (seen.insert(h).second)
-                        Q.push(nbr);
-                }
+        return topology_summary().manifold;
+    }
+
+    bool triMesh::is_oriented() const {
+        return topology_summary().oriented;
+    }
+
+    ManifoldReport triMesh::check_manifold() const {
+        ManifoldReport report;
+
+        // 1) edges, by the number of faces on them
+        struct EdgeScan {
+            std::size_t used = 0, boundary = 0;
+            std::vector<unsigned> non_manifold, inconsistent;
+        };
+        EdgeScan edges = parallel_reduce(std::size_t(0), edges_.size(), EdgeScan{},
+                                         [this](EdgeScan scan, std::size_t i) {
+                                             const EdgeUse use = edge_use(edges_[i]);
+                                             if (use != EdgeUse::Unused) ++scan.used;
+                                             switch (use) {
+                                                 case EdgeUse::Boundary: ++scan.boundary;
+                                                     break;
+                                                 case EdgeUse::NonManifold: scan.non_manifold.push_back(edges_[i]->get_handle());
+                                                     break;
+                                                 case EdgeUse::Inconsistent: scan.inconsistent.push_back(edges_[i]->get_handle());
+                                                     break;
+                                                 default: break;
+                                             }
+                                             return scan;
+                                         },
+                                         [](EdgeScan a, const EdgeScan &b) {
+                                             a.used += b.used;
+                                             a.boundary += b.boundary;
+                                             a.non_manifold.insert(a.non_manifold.end(), b.non_manifold.begin(), b.non_manifold.end());
+                                             a.inconsistent.insert(a.inconsistent.end(), b.inconsistent.begin(), b.inconsistent.end());
+                                             return a;
+                                         });
+        report.edges = edges.used;
+        report.boundary_edges = edges.boundary;
+        report.non_manifold_edges = std::move(edges.non_manifold);
+        report.inconsistent_edges = std::move(edges.inconsistent);
+        report.edge_manifold = report.non_manifold_edges.empty();
+        report.oriented = report.inconsistent_edges.empty();
+
+        // 2) corners per vertex, and one of them to start its fan from
+        std::vector<std::atomic<unsigned> > corners(next_vertex_handle_);
+        std::vector<halfEdgePtr> start(next_vertex_handle_);
+        parallel_for(0, corners.size(), [&corners](std::size_t h) { corners[h].store(0, std::memory_order_relaxed); });
+        parallel_for(0, half_edges_.size(), [&](std::size_t i) {
+            const auto &he = half_edges_[i];
+            if (!he->get_parent_face()) return;
+            const unsigned v = he->get_vertex_one()->get_handle();
+            if (corners[v].fetch_add(1, std::memory_order_relaxed) == 0) start[v] = he;
+        });
+
+        // endpoints of broken edges have half-edges shared between faces
+        std::vector<char> skip(next_vertex_handle_, 0);
+        for (const auto *list: {&report.non_manifold_edges, &report.inconsistent_edges})
+            for (unsigned h: *list) {
+                const auto &e = handle_to_edge_.at(h);
+                skip[e->get_vertex_one()->get_handle()] = 1;
+                skip[e->get_vertex_two()->get_handle()] = 1;
             }
 
-            if (seen.size() != inc_faces.size())
-                return false;
-        }
+        // 3) a vertex is manifold when one fan covers all of its corners
+        report.non_manifold_vertices = parallel_reduce(std::size_t(0), vertices_.size(), std::vector<unsigned>{},
+                                                       [&](std::vector<unsigned> bad, std::size_t i) {
+                                                           const unsigned h = vertices_[i]->get_handle();
+                                                           const unsigned n = corners[h].load(std::memory_order_relaxed);
+                                                           if (n > 0 && !skip[h] && fan_size(start[h], n) != n)
+                                                               bad.push_back(h);
+                                                           return bad;
+                                                       },
+                                                       [](std::vector<unsigned> a, const std::vector<unsigned> &b) {
+                                                           a.insert(a.end(), b.begin(), b.end());
+                                                           return a;
+                                                       });
+        report.vertex_manifold = report.non_manifold_vertices.empty();
+        return report;
+    }
 
+    bool triMesh::is_triangular() const {
         return true;
     }
 
-    bool triMesh::is_oriented() const {
-        for (auto &he: half_edges_) {
-            const auto opp = he->get_opposing_half_edge();
-            if (!opp) continue;
-            const auto a1 = he->get_vertex_one();
-            const auto b1 = he->get_vertex_two();
-            const auto a2 = opp->get_vertex_one();
-            const auto b2 = opp->get_vertex_two();
-            if (!(a1 && b1 && a2 && b2)) return false;
-            if (a1->get_handle() != b2->get_handle() ||
-                b1->get_handle() != a2->get_handle())
-                return false;
-        }
-        return true;
+    //
+    // For a surface with C components, b boundary loops and genus g,
+    // V - E + F = 2C - 2g - b. Lone vertices are components with
+    // V - E + F = 1 and are left out of the genus.
+    //
+    TopologySummary triMesh::topology_summary() const {
+        if (const auto cached = std::atomic_load(&summary_cache_); cached && cached->version == topology_version_)
+            return cached->summary;
+
+        const ManifoldReport report = check_manifold();
+        const ComponentLabels components = connected_components();
+        const std::size_t lone = static_cast<std::size_t>(
+            std::count(components.face_counts.begin(), components.face_counts.end(), 0));
+
+        auto cache = std::make_shared<SummaryCache>();
+        cache->version = topology_version_;
+        TopologySummary &out = cache->summary;
+        out.vertices = vertices_.size();
+        out.edges = report.edges;
+        out.faces = faces_.size();
+        out.boundary_edges = report.boundary_edges;
+        out.boundary_loops = out.boundary_edges > 0 ? boundary_loops().size() : 0;
+        out.components = components.count;
+        out.euler_characteristic = static_cast<int>(out.vertices) - static_cast<int>(out.edges) + static_cast<int>(out.faces);
+        const int surfaces = static_cast<int>(components.count - lone);
+        out.genus = (2 * surfaces - static_cast<int>(out.boundary_loops) - (out.euler_characteristic - static_cast<int>(lone))) / 2;
+        out.edge_manifold = report.edge_manifold;
+        out.manifold = report.manifold();
+        out.oriented = report.oriented;
+
+        const std::shared_ptr<const SummaryCache> result = std::move(cache);
+        std::atomic_store(&summary_cache_, result);
+        return result->summary;
     }
 
-    bool triMesh::is_triangular() const {
-        return true;
+    size_t triMesh::num_connected_components() const {
+        return topology_summary().components;
     }
 
-    double triMesh::surface_area() const {
-        double total = 0.0;
+    //
+    // Lock-free union-find over vertex handles: a root is only ever linked
+    // below a smaller root with a CAS, and finds halve their paths as they
+    // go. Whatever the order of the unions, every component ends up rooted
+    // at its lowest handle, so the labels do not depend on the threads.
+    //
+    ComponentLabels triMesh::connected_components() const {
+        constexpr unsigned none = std::numeric_limits<unsigned>::max();
+        const std::size_t n = next_vertex_handle_;
+        std::vector<std::atomic<unsigned> > parent(n);
+        parallel_for(0, n, [&parent](std::size_t h) {
+            parent[h].store(static_cast<unsigned>(h), std::memory_order_relaxed);
+        });
 
-        for (const auto &f : faces_) {
-            // unpack the three corner vertices
-            auto [v0, v1, v2] = f->get_vertices();
+        const auto find = [&parent](unsigned x) {
+            unsigned p = parent[x].load(std::memory_order_relaxed);
+            while (p != x) {
+                const unsigned gp = parent[p].load(std::memory_order_relaxed);
+                // halve: point x at its grandparent, fine to lose the race
+                parent[x].compare_exchange_weak(p, gp, std::memory_order_relaxed);
+                x = p;
+                p = parent[x].load(std::memory_order_relaxed);
+            }
+            return x;
+        };
+        const auto unite = [&](unsigned a, unsigned b) {
+            while (true) {
+                a = find(a);
+                b = find(b);
+                if (a == b) return;
+                if (a < b) std::swap(a, b);
+                unsigned expected = a;
+                if (parent[a].compare_exchange_weak(expected, b, std::memory_order_relaxed)) return;
+            }
+        };
+        parallel_for(0, faces_.size(), [&](std::size_t i) {
+            auto [a,b,c] = faces_[i]->get_vertices();
+            unite(a->get_handle(), b->get_handle());
+            unite(b->get_handle(), c->get_handle());
+        });
+
+        // flatten, then number the roots in handle order
+        ComponentLabels out;
+        out.vertex_labels.assign(n, none);
+        std::vector<char> used(n, 0);
+        parallel_for(0, vertices_.size(), [&](std::size_t i) {
+            const unsigned h = vertices_[i]->get_handle();
+            out.vertex_labels[h] = find(h);
+            used[h] = 1;
+        });
+        std::vector<unsigned> root_label(n, none);
+        for (std::size_t h = 0; h < n; ++h) {
+            if (!used[h]) continue;
+            unsigned &label = root_label[out.vertex_labels[h]];
+            if (label == none) {
+                label = static_cast<unsigned>(out.count++);
+                out.vertex_counts.push_back(0);
+            }
+            ++out.vertex_counts[label];
+        }
+        parallel_for(0, n, [&](std::size_t h) {
+            if (used[h]) out.vertex_labels[h] = root_label[out.vertex_labels[h]];
+        });
+
+        out.face_labels.assign(next_face_handle_, none);
+        parallel_for(0, faces_.size(), [&](std::size_t i) {
+            const auto a = std::get<0>(faces_[i]->get_vertices());
+            out.face_labels[faces_[i]->get_handle()] = out.vertex_labels[a->get_handle()];
+        });
+        out.face_counts.assign(out.count, 0);
+        for (auto &f: faces_) ++out.face_counts[out.face_labels[f->get_handle()]];
+        return out;
+    }
 
-            // pull out their 3D positions
-            const Eigen::Vector3d p0 = v0->get_position();
-            const Eigen::Vector3d p1 = v1->get_position();
-            const Eigen::Vector3d p2 = v2->get_position();
+    std::size_t triMesh::connected_components(const std::string &property) {
+        const ComponentLabels labels = connected_components();
+        const auto column = [](const std::vector<unsigned> &values) {
+            std::vector<int> out(values.size());
+            for (std::size_t h = 0; h < values.size(); ++h)
+                out[h] = values[h] == std::numeric_limits<unsigned>::max() ? -1 : static_cast<int>(values[h]);
+            return out;
+        };
+        set_vertex_property_column(property, column(labels.vertex_labels));
+        set_face_property_column(property, column(labels.face_labels));
+        return labels.count;
+    }
 
-            // standard triangle area
-            total += 0.5 * (p1 - p0).cross(p2 - p0).norm();
+    namespace {
+        // Handles grouped by component: the items of component c are
+        // order[offset[c], offset[c + 1]), in index order
+        struct Grouping {
+            std::vector<std::size_t> offset;
+            std::vector<unsigned> order;
+        };
+
+        Grouping group_by_label(const std::vector<unsigned> &labels, std::size_t count) {
+            Grouping g;
+            g.offset.assign(count + 1, 0);
+            for (unsigned l: labels)
+                if (l < count) ++g.offset[l + 1];
+            for (std::size_t c = 0; c < count; ++c) g.offset[c + 1] += g.offset[c];
+            g.order.resize(g.offset.back());
+            std::vector<std::size_t> fill(g.offset.begin(), g.offset.end() - 1);
+            for (std::size_t h = 0; h < labels.size(); ++h)
+                if (labels[h] < count) g.order[fill[labels[h]]++] = static_cast<unsigned>(h);
+            return g;
         }
 
-        return total;
+        // Copy every array column of from into to, entry old -> new for
+        // each pair of remap; handles without a value stay null
+        void carry_columns(const nlohmann::json &from, nlohmann::json &to,
+                           const std::vector<std::pair<unsigned, unsigned> > &remap, std::size_t size) {
+            if (!from.is_object()) return;
+            for (auto &[name, column]: from.items()) {
+                if (!column.is_array()) continue;
+                nlohmann::json out(size, nullptr);
+                for (auto [old_handle, new_handle]: remap)
+                    if (old_handle < column.size()) out[new_handle] = column[old_handle];
+                to[name] = std::move(out);
+            }
+        }
     }
 
-    size_t triMesh::num_connected_components() const {
-        const size_t N = vertices_.size();
-        std::vector<char> visited(N, 0);
-        size_t comps = 0;
-
-        for (auto &v0: vertices_) {
-            const unsigned h0 = v0->get_handle();
-            if (visited[h0]) continue;
-            ++comps;
-            std::queue<vertexPtr> Q;
-            Q.push(v0);
-            visited[h0] = 1;
-
-            while (!Q.empty()) {
-                const auto v = Q.front();
-                Q.pop();
-                for (const auto &he: v->get_outgoing_half_edges()) {
-                    if (auto w = he->get_vertex_two(); w && !visited[w->get_handle()]) {
-                        visited[w->get_handle()] = 1;
-                        Q.push(w);
-                    }
+    std::vector<triMesh> triMesh::split_components() const {
+        constexpr unsigned none = std::numeric_limits<unsigned>::max();
+        const ComponentLabels labels = connected_components();
+        const std::size_t count = labels.count;
+
+        // per-component vertex and face lists, and each vertex's index in its part
+        const Grouping vertices = group_by_label(labels.vertex_labels, count);
+        const Grouping faces = group_by_label(labels.face_labels, count);
+        std::vector<unsigned> local(next_vertex_handle_, none);
+        parallel_for(0, count, [&](std::size_t c) {
+            for (std::size_t i = vertices.offset[c]; i < vertices.offset[c + 1]; ++i)
+                local[vertices.order[i]] = static_cast<unsigned>(i - vertices.offset[c]);
+        }, 1);
+
+        // edges and half-edges only matter when they carry properties
+        const auto label_of = [&](const auto &items, bool wanted) {
+            std::vector<unsigned> out;
+            if (!wanted) return out;
+            out.assign(items.size(), none);
+            parallel_for(0, items.size(), [&](std::size_t i) {
+                out[i] = labels.vertex_labels[items[i]->get_vertex_one()->get_handle()];
+            });
+            return out;
+        };
+        const auto edge_labels = label_of(edges_, edge_data_store.is_object() && !edge_data_store.empty());
+        const auto half_edge_labels = label_of(half_edges_, half_edge_data_store.is_object() && !half_edge_data_store.empty());
+        const Grouping edges = group_by_label(edge_labels, edge_labels.empty() ? 0 : count);
+        const Grouping half_edges = group_by_label(half_edge_labels, half_edge_labels.empty() ? 0 : count);
+
+        std::vector<triMesh> parts(count);
+        parallel_for(0, count, [&](std::size_t k) {
+            triMesh &part = parts[k];
+            std::vector<std::array<double, 3> > positions;
+            positions.reserve(vertices.offset[k + 1] - vertices.offset[k]);
+            for (std::size_t i = vertices.offset[k]; i < vertices.offset[k + 1]; ++i) {
+                const auto &v = handle_to_vertex_.at(vertices.order[i]);
+                positions.push_back({v->get_x(), v->get_y(), v->get_z()});
+            }
+            std::vector<std::array<unsigned, 3> > triangles;
+            triangles.reserve(faces.offset[k + 1] - faces.offset[k]);
+            for (std::size_t i = faces.offset[k]; i < faces.offset[k + 1]; ++i) {
+                auto [a,b,c] = handle_to_face_.at(faces.order[i])->get_vertices();
+                triangles.push_back({local[a->get_handle()], local[b->get_handle()], local[c->get_handle()]});
+            }
+            part.build_from_arrays(positions, triangles);
+
+            // properties, matched through the part's own lookups
+            std::vector<std::pair<unsigned, unsigned> > remap;
+            for (std::size_t i = vertices.offset[k]; i < vertices.offset[k + 1]; ++i)
+                remap.emplace_back(vertices.order[i], static_cast<unsigned>(i - vertices.offset[k]));
+            carry_columns(vertex_data_store, part.vertex_data_store, remap, part.next_vertex_handle_);
+
+            remap.clear();
+            for (std::size_t i = faces.offset[k]; i < faces.offset[k + 1]; ++i) {
+                const auto &t = triangles[i - faces.offset[k]];
+                const unsigned h = part.find_face_handle(t[0], t[1], t[2]);
+                if (h != none) remap.emplace_back(faces.order[i], h);
+            }
+            carry_columns(face_data_store, part.face_data_store, remap, part.next_face_handle_);
+
+            if (!edge_labels.empty()) {
+                remap.clear();
+                for (std::size_t i = edges.offset[k]; i < edges.offset[k + 1]; ++i) {
+                    const auto &e = edges_[edges.order[i]];
+                    unsigned a = local[e->get_vertex_one()->get_handle()], b = local[e->get_vertex_two()->get_handle()];
+                    if (a > b) std::swap(a, b);
+                    if (const auto it = part.edge_lookup_.find({a, b}); it != part.edge_lookup_.end())
+                        remap.emplace_back(e->get_handle(), it->second);
                 }
-                for (const auto &he: v->get_incoming_half_edges()) {
-                    if (auto w = he->get_vertex_one(); w && !visited[w->get_handle()]) {
-                        visited[w->get_handle()] = 1;
-                        Q.push(w);
-                    }
+                carry_columns(edge_data_store, part.edge_data_store, remap, part.next_edge_handle_);
+            }
+            if (!half_edge_labels.empty()) {
+                remap.clear();
+                for (std::size_t i = half_edges.offset[k]; i < half_edges.offset[k + 1]; ++i) {
+                    const auto &he = half_edges_[half_edges.order[i]];
+                    const HalfEdgeKey key{local[he->get_vertex_one()->get_handle()], local[he->get_vertex_two()->get_handle()]};
+                    if (const auto it = part.half_edge_lookup_.find(key); it != part.half_edge_lookup_.end())
+                        remap.emplace_back(he->get_handle(), it->second->get_handle());
                 }
+                carry_columns(half_edge_data_store, part.half_edge_data_store, remap, part.next_half_edge_handle_);
             }
-        }
-
-        return comps;
+        }, 1);
+        return parts;
     }
 } // namespace HalfMesh
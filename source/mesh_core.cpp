@@ -1,7 +1,9 @@
 #include <iostream>
 
 #include "triMesh.hpp"
+#include "task_scheduler.hpp"
 #include <utility>      // for std::swap
+#include <stdexcept>
 
 namespace halfMesh {
     // Canonicalization helpers (could also live in a detail header)
@@ -20,6 +22,108 @@ namespace halfMesh {
 
     triMesh::~triMesh() = default;
 
+    triMesh::triMesh(const triMesh &other) {
+        copy_from(other);
+    }
+
+    triMesh &triMesh::operator=(const triMesh &other) {
+        if (this != &other) {
+            clear_data();
+            copy_from(other);
+        }
+        return *this;
+    }
+
+    triMesh::triMesh(triMesh &&other) noexcept = default;
+
+    triMesh &triMesh::operator=(triMesh &&other) noexcept = default;
+
+    void triMesh::copy_from(const triMesh &other) {
+        // Look up our copy of one of other's objects, nullptr if it is gone
+        const auto mapped = [](const auto &map, const auto &p) -> typename std::decay_t<decltype(map)>::mapped_type {
+            if (!p) return nullptr;
+            const auto it = map.find(p->get_handle());
+            return it == map.end() ? nullptr : it->second;
+        };
+
+        // 1) objects, keeping their handles
+        vertices_.reserve(other.vertices_.size());
+        for (auto &v: other.vertices_) {
+            auto nv = std::make_shared<vertex>(v->get_x(), v->get_y(), v->get_z());
+            nv->set_handle(v->get_handle());
+            vertices_.push_back(nv);
+            handle_to_vertex_[nv->get_handle()] = nv;
+        }
+        edges_.reserve(other.edges_.size());
+        for (auto &e: other.edges_) {
+            auto ne = std::make_shared<edge>(mapped(handle_to_vertex_, e->get_vertex_one()),
+                                             mapped(handle_to_vertex_, e->get_vertex_two()));
+            ne->set_handle(e->get_handle());
+            ne->set_boundary(e->is_boundary());
+            ne->set_face_count(e->get_face_count());
+            edges_.push_back(ne);
+            handle_to_edge_[ne->get_handle()] = ne;
+        }
+        faces_.reserve(other.faces_.size());
+        for (auto &f: other.faces_) {
+            auto [a,b,c] = f->get_vertices();
+            auto nf = std::make_shared<face>(mapped(handle_to_vertex_, a),
+                                             mapped(handle_to_vertex_, b),
+                                             mapped(handle_to_vertex_, c));
+            nf->set_handle(f->get_handle());
+            faces_.push_back(nf);
+            handle_to_face_[nf->get_handle()] = nf;
+        }
+        half_edges_.reserve(other.half_edges_.size());
+        for (auto &he: other.half_edges_) {
+            auto nh = std::make_shared<halfedge>(mapped(handle_to_vertex_, he->get_vertex_one()),
+                                                 mapped(handle_to_vertex_, he->get_vertex_two()));
+            nh->set_handle(he->get_handle());
+            nh->set_boundary(he->is_boundary());
+            nh->set_parent_face(mapped(handle_to_face_, he->get_parent_face()));
+            nh->set_parent_edge(mapped(handle_to_edge_, he->get_parent_edge()));
+            half_edges_.push_back(nh);
+            handle_to_half_edge_[nh->get_handle()] = nh;
+        }
+
+        // 2) pointer links between them
+        for (size_t i = 0; i < other.half_edges_.size(); ++i) {
+            const auto &he = other.half_edges_[i];
+            const auto &nh = half_edges_[i];
+            nh->set_opposing_half_edge(mapped(handle_to_half_edge_, he->get_opposing_half_edge()));
+            nh->set_next(mapped(handle_to_half_edge_, he->next()));
+            nh->set_prev(mapped(handle_to_half_edge_, he->prev()));
+        }
+        for (size_t i = 0; i < other.edges_.size(); ++i)
+            edges_[i]->set_one_half_edge(mapped(handle_to_half_edge_, other.edges_[i]->get_one_half_edge()));
+        for (size_t i = 0; i < other.faces_.size(); ++i)
+            faces_[i]->set_one_half_edge(mapped(handle_to_half_edge_, other.faces_[i]->get_one_half_edge()));
+        for (size_t i = 0; i < other.vertices_.size(); ++i) {
+            for (auto &he: other.vertices_[i]->get_outgoing_half_edges())
+                if (auto nh = mapped(handle_to_half_edge_, he)) vertices_[i]->add_outgoing_half_edge(nh);
+            for (auto &he: other.vertices_[i]->get_incoming_half_edges())
+                if (auto nh = mapped(handle_to_half_edge_, he)) vertices_[i]->add_incoming_half_edge(nh);
+        }
+
+        // 3) lookups are keyed by handles, only the half-edge one holds pointers
+        edge_lookup_ = other.edge_lookup_;
+        face_lookup_ = other.face_lookup_;
+        half_edge_lookup_.reserve(other.half_edge_lookup_.size());
+        for (auto &[key, he]: other.half_edge_lookup_)
+            if (auto nh = mapped(handle_to_half_edge_, he)) half_edge_lookup_[key] = nh;
+
+        vertex_data_store = other.vertex_data_store;
+        edge_data_store = other.edge_data_store;
+        face_data_store = other.face_data_store;
+        half_edge_data_store = other.half_edge_data_store;
+
+        next_vertex_handle_ = other.next_vertex_handle_;
+        next_half_edge_handle_ = other.next_half_edge_handle_;
+        next_edge_handle_ = other.next_edge_handle_;
+        next_face_handle_ = other.next_face_handle_;
+        normal_cache_.tracking = other.normal_cache_.tracking;
+    }
+
     void triMesh::clear_data() {
         vertices_.clear();
         half_edges_.clear();
@@ -35,10 +139,16 @@ namespace halfMesh {
         vertex_data_store.clear();
         edge_data_store.clear();
         face_data_store.clear();
+        half_edge_data_store.clear();
         next_vertex_handle_ = 0;
         next_half_edge_handle_ = 0;
         next_edge_handle_ = 0;
         next_face_handle_ = 0;
+        ++topology_version_;
+        ++geometry_version_;
+        const bool tracking = normal_cache_.tracking;
+        normal_cache_ = NormalCache{};
+        normal_cache_.tracking = tracking;
     }
 
     // Core mutators
@@ -47,6 +157,8 @@ namespace halfMesh {
         unsigned h = next_vertex_handle_++;
         v->set_handle(h);
         vertices_.push_back(v);
+        ++topology_version_;
+        ++geometry_version_;
         handle_to_vertex_[h] = v;
         // std::cout << "Added vertex : " << h << " with coordinates : " << x << "," << y << "," << z << std::endl;
         return v;
@@ -63,6 +175,7 @@ namespace halfMesh {
         const unsigned h = next_half_edge_handle_++;
         he->set_handle(h);
         he->set_parent_face(f);
+        ++topology_version_;
 
         // link opposites
         const auto rev = std::make_pair(v2->get_handle(), v1->get_handle());
@@ -87,6 +200,9 @@ namespace halfMesh {
         const auto key = make_edge_key(v1->get_handle(), v2->get_handle());
         if (const auto it = edge_lookup_.find(key); it != edge_lookup_.end()) {
             const auto e = handle_to_edge_[it->second];
+            // a third face here makes the edge non-manifold; the directed
+            // half-edge may be shared then, so the count is what tells
+            e->set_face_count(e->get_face_count() + 1);
             const auto he = add_half_edge(v1, v2, f);
             he->set_parent_edge(e);
             e->set_one_half_edge(he);
@@ -98,7 +214,9 @@ namespace halfMesh {
         auto e = std::make_shared<edge>(v1, v2);
         const unsigned h = next_edge_handle_++;
         e->set_handle(h);
+        e->set_face_count(1);
         edges_.push_back(e);
+        ++topology_version_;
         handle_to_edge_[h] = e;
         edge_lookup_[key] = h;
 
@@ -126,6 +244,7 @@ namespace halfMesh {
         const unsigned fh = next_face_handle_++;
         f->set_handle(fh);
         faces_.push_back(f);
+        ++topology_version_;
         handle_to_face_[fh] = f;
         face_lookup_[key] = fh;
 
@@ -195,14 +314,21 @@ namespace halfMesh {
             }
         }
 
-        // 3) Remove from face lookup map
+        // 3) Remove from face lookup map, its edges lose a face
         auto [a,b,c] = f->get_vertices();
         const FaceKey fk = make_face_key(a->get_handle(), b->get_handle(), c->get_handle());
         face_lookup_.erase(fk);
+        for (const auto &[x, y]: {std::make_pair(a, b), std::make_pair(b, c), std::make_pair(c, a)}) {
+            const auto it = edge_lookup_.find(make_edge_key(x->get_handle(), y->get_handle()));
+            if (it == edge_lookup_.end()) continue;
+            const auto &e = handle_to_edge_.at(it->second);
+            if (e->get_face_count() > 0) e->set_face_count(e->get_face_count() - 1);
+        }
 
         // 4) Finally erase the face itself
         handle_to_face_.erase(f->get_handle());
         faces_.erase(fit);
+        ++topology_version_;
 
         return true;
     }
@@ -259,6 +385,7 @@ namespace halfMesh {
         // 4) Finally erase the edge itself
         handle_to_edge_.erase(e->get_handle());
         edges_.erase(eit);
+        ++topology_version_;
 
         return true;
     }
@@ -305,6 +432,7 @@ namespace halfMesh {
         // 5) Finally erase the vertex itself
         handle_to_vertex_.erase(v->get_handle());
         vertices_.erase(vit);
+        ++topology_version_;
 
         return true;
     }
@@ -339,22 +467,107 @@ namespace halfMesh {
         }
 
         // mark half-edge boundaries
-        for (const auto &he: half_edges_) {
-            if (const auto currentOppositeHE = he->get_opposing_half_edge(); !currentOppositeHE) {
-                he->set_boundary(true);
-            } else {
-                he->set_boundary(false);
-            }
-        }
+        parallel_for(0, half_edges_.size(), [this](std::size_t i) {
+            const auto &he = half_edges_[i];
+            he->set_boundary(!he->get_opposing_half_edge());
+        });
 
         // mark edge boundaries
-        for (const auto &e: edges_) {
+        parallel_for(0, edges_.size(), [this](std::size_t i) {
+            const auto &e = edges_[i];
             e->set_boundary(
                 e->get_one_half_edge()->is_boundary()
             );
+        });
+    }
+
+
+    void triMesh::build_from_arrays(const std::vector<std::array<double, 3> > &positions,
+                                    const std::vector<std::array<unsigned, 3> > &triangles) {
+        clear_data();
+
+        // 1) size every container once, a closed triangle mesh has E ~ 1.5F
+        const size_t nv = positions.size();
+        const size_t nf = triangles.size();
+        vertices_.reserve(nv);
+        handle_to_vertex_.reserve(nv);
+        faces_.reserve(nf);
+        handle_to_face_.reserve(nf);
+        face_lookup_.reserve(nf);
+        edges_.reserve(nf * 3 / 2 + 1);
+        handle_to_edge_.reserve(nf * 3 / 2 + 1);
+        edge_lookup_.reserve(nf * 3 / 2 + 1);
+        half_edges_.reserve(nf * 3);
+        handle_to_half_edge_.reserve(nf * 3);
+        half_edge_lookup_.reserve(nf * 3);
+
+        // 2) vertices get handles 0..nv-1 in input order
+        for (const auto &p: positions)
+            add_vertex(p[0], p[1], p[2]);
+
+        // 3) faces, skipping anything that is out of range or degenerate
+        for (const auto &t: triangles) {
+            if (t[0] >= nv || t[1] >= nv || t[2] >= nv) continue;
+            if (t[0] == t[1] || t[1] == t[2] || t[2] == t[0]) continue;
+            add_face(vertices_[t[0]], vertices_[t[1]], vertices_[t[2]]);
+        }
+
+        complete_mesh();
+    }
+
+    // — Eigen export —
+    Eigen::MatrixXd triMesh::positions_matrix() const {
+        Eigen::MatrixXd V(static_cast<Eigen::Index>(vertices_.size()), 3);
+        for (Eigen::Index i = 0; i < V.rows(); ++i) {
+            const auto &v = vertices_[static_cast<size_t>(i)];
+            V(i, 0) = v->get_x();
+            V(i, 1) = v->get_y();
+            V(i, 2) = v->get_z();
         }
+        return V;
     }
 
+    Eigen::MatrixXi triMesh::faces_matrix() const {
+        // handles are rows unless vertices were deleted or added with gaps
+        bool dense = true;
+        for (size_t i = 0; i < vertices_.size() && dense; ++i)
+            dense = vertices_[i]->get_handle() == i;
+        std::unordered_map<unsigned, int> row;
+        if (!dense) {
+            row.reserve(vertices_.size());
+            for (size_t i = 0; i < vertices_.size(); ++i)
+                row[vertices_[i]->get_handle()] = static_cast<int>(i);
+        }
+        const auto index = [&](const vertexPtr &v) {
+            return dense ? static_cast<int>(v->get_handle()) : row.at(v->get_handle());
+        };
+
+        Eigen::MatrixXi F(static_cast<Eigen::Index>(faces_.size()), 3);
+        for (Eigen::Index i = 0; i < F.rows(); ++i) {
+            auto [a,b,c] = faces_[static_cast<size_t>(i)]->get_vertices();
+            F(i, 0) = index(a);
+            F(i, 1) = index(b);
+            F(i, 2) = index(c);
+        }
+        return F;
+    }
+
+    void triMesh::set_positions(const Eigen::Ref<const Eigen::MatrixXd> &V) {
+        if (V.rows() != static_cast<Eigen::Index>(vertices_.size()) || V.cols() != 3)
+            throw std::runtime_error("set_positions: expected a " + std::to_string(vertices_.size()) + " x 3 matrix");
+        for (Eigen::Index i = 0; i < V.rows(); ++i) {
+            const auto &v = vertices_[static_cast<size_t>(i)];
+            v->set_x(V(i, 0));
+            v->set_y(V(i, 1));
+            v->set_z(V(i, 2));
+        }
+        ++geometry_version_;
+    }
+
+    unsigned triMesh::find_face_handle(unsigned a, unsigned b, unsigned c) const {
+        const auto it = face_lookup_.find(make_face_key(a, b, c));
+        return it == face_lookup_.end() ? std::numeric_limits<unsigned>::max() : it->second;
+    }
 
     // trivial handle‐->object
     vertexPtr triMesh::get_vertex(unsigned h) const { return handle_to_vertex_.at(h); }
@@ -1,7 +1,149 @@
 #include "triMesh.hpp"
+#include "geometry_kernels.hpp"
+#include "task_scheduler.hpp"
+#include <algorithm>
+#include <array>
 #include <cmath>
+#include <limits>
 
 namespace halfMesh {
+    namespace {
+        using detail::TriangleBatch;
+        using detail::TriangleMoments;
+
+        // Faces / vertices gathered into flat arrays per batch; batch
+        // boundaries (and with them the summation order) do not depend on
+        // the thread count
+        constexpr std::size_t kBatch = kDefaultGrain;
+
+        // Corners of faces [first, first + kBatch) into batch; returns the count
+        std::size_t gather_triangles(const std::vector<facePtr> &faces, std::size_t first, TriangleBatch &batch) {
+            batch.resize(kBatch);
+            const std::size_t n = std::min(kBatch, faces.size() - first);
+            for (std::size_t i = 0; i < n; ++i) {
+                auto [a,b,c] = faces[first + i]->get_vertices();
+                batch.ax[i] = a->get_x();
+                batch.ay[i] = a->get_y();
+                batch.az[i] = a->get_z();
+                batch.bx[i] = b->get_x();
+                batch.by[i] = b->get_y();
+                batch.bz[i] = b->get_z();
+                batch.cx[i] = c->get_x();
+                batch.cy[i] = c->get_y();
+                batch.cz[i] = c->get_z();
+            }
+            return n;
+        }
+
+        TriangleMoments face_moments(const std::vector<facePtr> &faces) {
+            const std::size_t batches = (faces.size() + kBatch - 1) / kBatch;
+            return parallel_reduce(std::size_t(0), batches, TriangleMoments{},
+                                   [&faces](TriangleMoments m, std::size_t c) {
+                                       thread_local TriangleBatch batch;
+                                       const std::size_t first = c * kBatch;
+                                       const std::size_t n = gather_triangles(faces, first, batch);
+                                       detail::accumulate_moments(batch, n, first, m);
+                                       return m;
+                                   },
+                                   [](TriangleMoments a, const TriangleMoments &b) {
+                                       a.merge(b);
+                                       return a;
+                                   }, 1);
+        }
+    }
+
+    Eigen::AlignedBox3d triMesh::axis_aligned_bounding_box() const {
+        struct Bounds {
+            double lo[3], hi[3];
+        };
+        constexpr double inf = std::numeric_limits<double>::infinity();
+        const Bounds empty{{inf, inf, inf}, {-inf, -inf, -inf}};
+        const std::size_t batches = (vertices_.size() + kBatch - 1) / kBatch;
+        const Bounds b = parallel_reduce(std::size_t(0), batches, empty, [this](Bounds box, std::size_t c) {
+            thread_local std::vector<double> x, y, z;
+            x.resize(kBatch);
+            y.resize(kBatch);
+            z.resize(kBatch);
+            const std::size_t first = c * kBatch;
+            const std::size_t n = std::min(kBatch, vertices_.size() - first);
+            for (std::size_t i = 0; i < n; ++i) {
+                const auto &v = vertices_[first + i];
+                x[i] = v->get_x();
+                y[i] = v->get_y();
+                z[i] = v->get_z();
+            }
+            detail::extend_bounds(x.data(), y.data(), z.data(), n, box.lo, box.hi);
+            return box;
+        }, [](Bounds a, const Bounds &b) {
+            for (int k = 0; k < 3; ++k) {
+                a.lo[k] = std::min(a.lo[k], b.lo[k]);
+                a.hi[k] = std::max(a.hi[k], b.hi[k]);
+            }
+            return a;
+        }, 1);
+
+        Eigen::AlignedBox3d box;
+        box.setEmpty();
+        if (!vertices_.empty()) {
+            box.min() = Eigen::Vector3d(b.lo[0], b.lo[1], b.lo[2]);
+            box.max() = Eigen::Vector3d(b.hi[0], b.hi[1], b.hi[2]);
+        }
+        return box;
+    }
+
+    // — Mass properties —
+    double triMesh::surface_area() const {
+        return 0.5 * face_moments(faces_).total(TriangleMoments::Area2);
+    }
+
+    double triMesh::volume() const {
+        return face_moments(faces_).total(TriangleMoments::Det) / 6.0;
+    }
+
+    Eigen::Vector3d triMesh::centroid() const {
+        return mass_properties().centroid;
+    }
+
+    Eigen::Matrix3d triMesh::inertia_tensor() const {
+        return mass_properties().inertia;
+    }
+
+    //
+    // Each face and the origin span a tetrahedron with signed volume d / 6;
+    // summing over a closed surface gives the solid integrals
+    //   V = sum d / 6,  int x dV = sum d s / 24,
+    //   int x x' dV = sum d (aa' + bb' + cc' + ss') / 120
+    // and the inertia about the centroid follows from the second moment.
+    //
+    MassProperties triMesh::mass_properties() const {
+        const TriangleMoments m = face_moments(faces_);
+        const auto vec = [&m](int t) { return Eigen::Vector3d(m.total(t), m.total(t + 1), m.total(t + 2)); };
+
+        MassProperties out;
+        out.area = 0.5 * m.total(TriangleMoments::Area2);
+        out.volume = m.total(TriangleMoments::Det) / 6.0;
+
+        // a surface that encloses nothing has no solid centroid or inertia
+        const bool solid = std::abs(out.volume) > 1e-12 * std::pow(out.area, 1.5);
+        if (!solid) {
+            if (out.area > 0) out.centroid = vec(TriangleMoments::Area2S) / (6.0 * out.area);
+            return out;
+        }
+        out.centroid = vec(TriangleMoments::DetS) / (24.0 * out.volume);
+
+        const int c = TriangleMoments::DetCov;
+        Eigen::Matrix3d second;
+        second << m.total(c), m.total(c + 3), m.total(c + 4),
+                m.total(c + 3), m.total(c + 1), m.total(c + 5),
+                m.total(c + 4), m.total(c + 5), m.total(c + 2);
+        second /= 120.0;
+        // about the centroid, positive for either orientation
+        Eigen::Matrix3d covariance = second - out.volume * out.centroid * out.centroid.transpose();
+        if (out.volume < 0) covariance = -covariance;
+        out.inertia = covariance.trace() * Eigen::Matrix3d::Identity() - covariance;
+        return out;
+    }
+
     double triMesh::get_area(unsigned fh) const {
         auto f = get_face(fh);
         auto [v1,v2,v3] = f->get_vertices();
@@ -46,4 +188,235 @@ namespace halfMesh {
                               + n2.get_z() * n2.get_z());
         return std::acos(dot / (m1 * m2));
     }
+
+    // — Batch face geometry —
+    namespace {
+        constexpr double kNaN = std::numeric_limits<double>::quiet_NaN();
+
+        // Unit normals and areas of the given faces, written at their handles
+        void face_geometry(const std::vector<facePtr> &faces, Eigen::Vector3d *normals, double *areas) {
+            const std::size_t batches = (faces.size() + kBatch - 1) / kBatch;
+            parallel_for(0, batches, [&](std::size_t c) {
+                thread_local TriangleBatch batch;
+                thread_local std::vector<double> nx, ny, nz, area;
+                nx.resize(kBatch);
+                ny.resize(kBatch);
+                nz.resize(kBatch);
+                area.resize(kBatch);
+                const std::size_t first = c * kBatch;
+                const std::size_t n = gather_triangles(faces, first, batch);
+                detail::triangle_normals(batch, n, nx.data(), ny.data(), nz.data(), area.data());
+                for (std::size_t i = 0; i < n; ++i) {
+                    const unsigned h = faces[first + i]->get_handle();
+                    if (normals) normals[h] = Eigen::Vector3d(nx[i], ny[i], nz[i]);
+                    if (areas) areas[h] = area[i];
+                }
+            }, 1);
+        }
+
+        // Unit normals and areas of all faces, indexed by face handle
+        void face_normals_and_areas(const std::vector<facePtr> &faces, std::size_t handles,
+                                    std::vector<Eigen::Vector3d> *normals, std::vector<double> *areas) {
+            if (normals) normals->assign(handles, Eigen::Vector3d::Constant(kNaN));
+            if (areas) areas->assign(handles, kNaN);
+            face_geometry(faces, normals ? normals->data() : nullptr, areas ? areas->data() : nullptr);
+        }
+    }
+
+    std::vector<double> triMesh::compute_face_areas() const {
+        std::vector<double> areas;
+        face_normals_and_areas(faces_, next_face_handle_, nullptr, &areas);
+        return areas;
+    }
+
+    std::vector<Eigen::Vector3d> triMesh::compute_face_normals() const {
+        std::vector<Eigen::Vector3d> normals;
+        face_normals_and_areas(faces_, next_face_handle_, &normals, nullptr);
+        return normals;
+    }
+
+    std::vector<double> triMesh::compute_dihedral_angles() const {
+        const auto normals = compute_face_normals();
+        std::vector<double> angles(next_edge_handle_, kNaN);
+        parallel_for(0, edges_.size(), [&](std::size_t i) {
+            const auto &e = edges_[i];
+            const auto he = e->get_one_half_edge();
+            const auto opposite = he ? he->get_opposing_half_edge() : nullptr;
+            if (!opposite) return;
+            const auto f1 = he->get_parent_face(), f2 = opposite->get_parent_face();
+            if (!f1 || !f2) return;
+            const double dot = normals[f1->get_handle()].dot(normals[f2->get_handle()]);
+            angles[e->get_handle()] = std::acos(std::clamp(dot, -1.0, 1.0));
+        });
+        return angles;
+    }
+
+    void triMesh::compute_face_areas(const std::string &property) {
+        set_face_property_column(property, compute_face_areas());
+    }
+
+    void triMesh::compute_face_normals(const std::string &property) {
+        const auto normals = compute_face_normals();
+        std::vector<std::array<double, 3> > column(normals.size());
+        for (std::size_t h = 0; h < normals.size(); ++h) column[h] = {normals[h].x(), normals[h].y(), normals[h].z()};
+        set_face_property_column(property, column);
+    }
+
+    void triMesh::compute_dihedral_angles(const std::string &property) {
+        set_edge_property_column(property, compute_dihedral_angles());
+    }
+    // — Maintained normals —
+    namespace {
+        // Angle of triangle (p, q, r) at p
+        double corner_angle(const Eigen::Vector3d &p, const Eigen::Vector3d &q, const Eigen::Vector3d &r) {
+            const Eigen::Vector3d a = q - p, b = r - p;
+            return std::atan2(a.cross(b).norm(), a.dot(b));
+        }
+
+        std::array<double, 3> to_array(const Eigen::Vector3d &v) {
+            return {v.x(), v.y(), v.z()};
+        }
+
+        std::vector<std::array<double, 3> > to_column(const std::vector<Eigen::Vector3d> &values) {
+            std::vector<std::array<double, 3> > column(values.size());
+            for (std::size_t h = 0; h < values.size(); ++h) column[h] = to_array(values[h]);
+            return column;
+        }
+    }
+
+    void triMesh::set_normal_tracking(bool enabled) {
+        if (enabled == normal_cache_.tracking) return;
+        normal_cache_ = NormalCache{};
+        normal_cache_.tracking = enabled;
+    }
+
+    void triMesh::update_face_normals(const std::string &property) {
+        NormalCache &cache = normal_cache_;
+        // a column we did not write ourselves gets rewritten whole
+        if (cache.face_property != property && face_data_store.contains(property))
+            face_data_store.erase(property);
+        cache.face_property = property;
+        refresh_normals();
+        if (!cache.tracking) cache = NormalCache{};
+    }
+
+    void triMesh::update_vertex_normals(NormalWeighting weighting, const std::string &property) {
+        NormalCache &cache = normal_cache_;
+        if (cache.vertex_property != property && vertex_data_store.contains(property))
+            vertex_data_store.erase(property);
+        if (cache.weighting != weighting) cache.vertex_normals.clear();
+        cache.vertex_property = property;
+        cache.weighting = weighting;
+        refresh_normals();
+        if (!cache.tracking) cache = NormalCache{};
+    }
+
+    void triMesh::refresh_normals() {
+        NormalCache &cache = normal_cache_;
+        const bool full = !cache.valid || cache.topology_version != topology_version_;
+
+        std::vector<unsigned> dirty_faces, dirty_vertices;
+        if (full) {
+            cache.topology_version = topology_version_;
+            cache.corners.assign(next_face_handle_, {0, 0, 0});
+            cache.ring_offsets.assign(next_vertex_handle_ + 1, 0);
+            for (auto &f: faces_) {
+                auto [a,b,c] = f->get_vertices();
+                cache.corners[f->get_handle()] = {a->get_handle(), b->get_handle(), c->get_handle()};
+                ++cache.ring_offsets[a->get_handle() + 1];
+                ++cache.ring_offsets[b->get_handle() + 1];
+                ++cache.ring_offsets[c->get_handle() + 1];
+            }
+            for (std::size_t h = 0; h < next_vertex_handle_; ++h) cache.ring_offsets[h + 1] += cache.ring_offsets[h];
+            cache.ring_faces.resize(cache.ring_offsets.back());
+            std::vector<unsigned> fill(cache.ring_offsets.begin(), cache.ring_offsets.end() - 1);
+            for (auto &f: faces_)
+                for (unsigned v: cache.corners[f->get_handle()]) cache.ring_faces[fill[v]++] = f->get_handle();
+
+            cache.positions.assign(next_vertex_handle_, Eigen::Vector3d::Constant(kNaN));
+            parallel_for(0, vertices_.size(), [&](std::size_t i) {
+                cache.positions[vertices_[i]->get_handle()] = vertices_[i]->get_position();
+            });
+            face_normals_and_areas(faces_, next_face_handle_, &cache.face_normals, &cache.face_areas);
+            cache.valid = true;
+        } else {
+            // vertices that moved since the last update
+            std::vector<char> moved(next_vertex_handle_, 0);
+            parallel_for(0, vertices_.size(), [&](std::size_t i) {
+                const unsigned h = vertices_[i]->get_handle();
+                const Eigen::Vector3d p = vertices_[i]->get_position();
+                if (p != cache.positions[h]) {
+                    cache.positions[h] = p;
+                    moved[h] = 1;
+                }
+            });
+            // the faces around them, and the vertices of those faces
+            std::vector<char> face_flag(next_face_handle_, 0), vertex_flag(next_vertex_handle_, 0);
+            for (unsigned v = 0; v < next_vertex_handle_; ++v) {
+                if (!moved[v]) continue;
+                for (unsigned k = cache.ring_offsets[v]; k < cache.ring_offsets[v + 1]; ++k) {
+                    const unsigned f = cache.ring_faces[k];
+                    if (face_flag[f]) continue;
+                    face_flag[f] = 1;
+                    dirty_faces.push_back(f);
+                    for (unsigned w: cache.corners[f])
+                        if (!vertex_flag[w]) {
+                            vertex_flag[w] = 1;
+                            dirty_vertices.push_back(w);
+                        }
+                }
+            }
+            std::vector<facePtr> faces(dirty_faces.size());
+            for (std::size_t i = 0; i < faces.size(); ++i) faces[i] = handle_to_face_.at(dirty_faces[i]);
+            face_geometry(faces, cache.face_normals.data(), cache.face_areas.data());
+        }
+
+        // blended vertex normals, for every vertex when the weighting changed
+        const bool want_vertices = !cache.vertex_property.empty();
+        const bool all_vertices = full || cache.vertex_normals.size() != next_vertex_handle_;
+        if (want_vertices) {
+            const auto blend = [&cache](unsigned v) {
+                Eigen::Vector3d sum = Eigen::Vector3d::Zero();
+                for (unsigned k = cache.ring_offsets[v]; k < cache.ring_offsets[v + 1]; ++k) {
+                    const unsigned f = cache.ring_faces[k];
+                    double w = 1.0;
+                    if (cache.weighting == NormalWeighting::Area) {
+                        w = cache.face_areas[f];
+                    } else if (cache.weighting == NormalWeighting::Angle) {
+                        const auto &c = cache.corners[f];
+                        const int i = c[0] == v ? 0 : c[1] == v ? 1 : 2;
+                        w = corner_angle(cache.positions[c[i]], cache.positions[c[(i + 1) % 3]],
+                                         cache.positions[c[(i + 2) % 3]]);
+                    }
+                    sum += w * cache.face_normals[f];
+                }
+                const double length = sum.norm();
+                cache.vertex_normals[v] = length > 0 ? Eigen::Vector3d(sum / length) : Eigen::Vector3d::Zero();
+            };
+            if (all_vertices) {
+                cache.vertex_normals.assign(next_vertex_handle_, Eigen::Vector3d::Constant(kNaN));
+                parallel_for(0, vertices_.size(), [&](std::size_t i) { blend(vertices_[i]->get_handle()); });
+            } else {
+                parallel_for(0, dirty_vertices.size(), [&](std::size_t i) { blend(dirty_vertices[i]); });
+            }
+        }
+
+        // write the columns, whole after a full pass or when they went missing
+        if (!cache.face_property.empty()) {
+            auto &column = face_data_store[cache.face_property];
+            if (full || !column.is_array() || column.size() != next_face_handle_) {
+                column = to_column(cache.face_normals);
+            } else {
+                for (unsigned f: dirty_faces) column[f] = to_array(cache.face_normals[f]);
+            }
+        }
+        if (want_vertices) {
+            auto &column = vertex_data_store[cache.vertex_property];
+            if (all_vertices || !column.is_array() || column.size() != next_vertex_handle_) {
+                column = to_column(cache.vertex_normals);
+            } else {
+                for (unsigned v: dirty_vertices) column[v] = to_array(cache.vertex_normals[v]);
+            }
+        }
+    }
 } // namespace HalfMesh
@@ -1,50 +1,185 @@
 #include "triMesh.hpp"
+#include "mapped_file.hpp"
+#include "parse_utilities.hpp"
+#include "thread_pool.hpp"
+#include <functional>
 #include <iostream>
 #include <fstream>
 #include <sstream>
+#include <stdexcept>
 #include <iterator>
+#include <map>
 
 namespace halfMesh {
     void triMesh::save(const std::string &fn) const {
-        switch (guess_mesh_format(fn)) {
+        const auto type = guess_mesh_format(fn);
+        if (type == MeshType::Unknown) {
+            std::cerr << "Unknown format: " << fn << "\n";
+            return;
+        }
+        std::ofstream out(fn, std::ios::binary);
+        if (!out) {
+            std::cerr << "Can't open " << fn << std::endl;
+            return;
+        }
+        write(out, type);
+    }
+
+    void triMesh::read(const std::string &filename) {
+        const mapped_file file(filename);
+        auto type = guess_mesh_format(filename);
+        if (type == MeshType::Unknown)
+            type = detect_mesh_format(reinterpret_cast<const std::byte *>(file.data()), file.size());
+        if (type == MeshType::Unknown) {
+            std::cerr << "Unknown format: " << filename << std::endl;
+            return;
+        }
+        read_from_memory(reinterpret_cast<const std::byte *>(file.data()), file.size(), type);
+    }
+
+    void triMesh::read_from_memory(const std::byte *data, std::size_t size, MeshType type) {
+        if (type == MeshType::Unknown)
+            type = detect_mesh_format(data, size);
+        const auto *bytes = reinterpret_cast<const char *>(data);
+        switch (type) {
             case MeshType::Gmsh:
-                write_gmsh(fn);
+                read_gmsh(bytes, size);
                 break;
             case MeshType::Stl:
-                write_stl_ascii(fn);
+                read_stl(bytes, size);
                 break;
             case MeshType::Binary:
-                write_binary(fn);
+                read_binary(bytes, size);
                 break;
-            case MeshType::Vtk:
-                write_vtk(fn);
+            case MeshType::Obj:
+                read_obj(bytes, size);
                 break;
-            default:
-                std::cerr << "Unknown format: " << fn << "\n";
+            case MeshType::Ply:
+                read_ply(bytes, size);
+                break;
+            case MeshType::Compressed:
+                read_compressed(bytes, size);
                 break;
+            default:
+                throw std::runtime_error("Unsupported format for reading");
         }
     }
 
-    void triMesh::read(const std::string &filename) {
-        switch (guess_mesh_format(filename)) {
+    void triMesh::read_from_memory(const std::vector<std::byte> &buffer, MeshType type) {
+        read_from_memory(buffer.data(), buffer.size(), type);
+    }
+
+    std::vector<std::byte> triMesh::save_to_memory(MeshType type) const {
+        std::ostringstream out(std::ios::binary);
+        write(out, type);
+        const std::string s = out.str();
+        std::vector<std::byte> buffer(s.size());
+        std::memcpy(buffer.data(), s.data(), s.size());
+        return buffer;
+    }
+
+    void triMesh::write(std::ostream &out, MeshType type) const {
+        switch (type) {
             case MeshType::Gmsh:
-                read_gmsh(filename);
+                write_gmsh(out);
                 break;
             case MeshType::Stl:
-                read_stl(filename);
+                write_stl_ascii(out);
                 break;
             case MeshType::Binary:
-                read_binary(filename);
+                write_binary(out);
+                break;
+            case MeshType::Vtk:
+                write_vtk(out);
+                break;
+            case MeshType::Obj:
+                write_obj(out);
+                break;
+            case MeshType::Ply:
+                write_ply(out);
+                break;
+            case MeshType::Glb:
+                write_glb(out, true);
+                break;
+            case MeshType::Compressed:
+                write_compressed(out, 16);
                 break;
             default:
-                std::cerr << "Unknown format: " << filename << std::endl;
+                std::cerr << "Unknown format" << std::endl;
+                break;
+        }
+    }
+
+    // — Async —
+    namespace {
+        IoResult failed(const std::string &message) {
+            IoResult result;
+            result.status = IoStatus::Failed;
+            result.message = message;
+            return result;
         }
     }
 
+    std::future<IoResult> triMesh::save_async(const std::string &filename) const {
+        return save_async(triMesh(*this), filename);
+    }
+
+    std::future<IoResult> triMesh::save_async(triMesh &&mesh, const std::string &filename) {
+        auto owned = std::make_shared<triMesh>(std::move(mesh));
+        return io_thread_pool().submit([owned, filename] {
+            IoResult result;
+            if (guess_mesh_format(filename) == MeshType::Unknown) {
+                result.status = IoStatus::UnknownFormat;
+                result.message = "Unknown format: " + filename;
+                return result;
+            }
+            // judged by the stream itself: a file at the path may be stale
+            // or cut short by a full disk
+            try {
+                std::ofstream out(filename, std::ios::binary);
+                if (!out) return failed("Can't open " + filename);
+                owned->write(out, guess_mesh_format(filename));
+                out.flush();
+                const auto end = out.tellp();
+                if (!out.good() || end < 0) return failed("Could not write " + filename);
+                result.bytes = static_cast<std::uintmax_t>(end);
+                out.close();
+                if (out.fail()) return failed("Could not write " + filename);
+            } catch (const std::exception &e) {
+                return failed(e.what());
+            }
+            return result;
+        });
+    }
+
+    std::future<std::pair<triMesh, IoResult> > triMesh::read_async(const std::string &filename) {
+        return io_thread_pool().submit([filename] {
+            std::pair<triMesh, IoResult> out;
+            try {
+                const mapped_file file(filename);
+                const auto *data = reinterpret_cast<const std::byte *>(file.data());
+                auto type = guess_mesh_format(filename);
+                if (type == MeshType::Unknown)
+                    type = detect_mesh_format(data, file.size());
+                if (type == MeshType::Unknown) {
+                    out.second.status = IoStatus::UnknownFormat;
+                    out.second.message = "Unknown format: " + filename;
+                    return out;
+                }
+                out.first.read_from_memory(data, file.size(), type);
+                out.second.bytes = file.size();
+            } catch (const std::exception &e) {
+                out.second = failed(e.what());
+            }
+            return out;
+        });
+    }
+
     // — Gmsh —
-    void triMesh::read_gmsh(const std::string &fn) {
+    void triMesh::read_gmsh(const char *data, std::size_t size) {
         clear_data();
-        std::ifstream in(fn);
+        detail::memory_buffer buf(data, size);
+        std::istream in(&buf);
         std::string line;
         bool in_nodes = false, in_elems = false;
         std::unordered_map<unsigned, vertexPtr> tmp;
@@ -88,28 +223,94 @@ namespace halfMesh {
         complete_mesh();
     }
 
-    void triMesh::read_binary(const std::string &fn) {
+    namespace {
+        // A .bm file as handle -> element, so journal records can be
+        // replayed before any connectivity is built
+        struct BinaryMesh {
+            std::map<unsigned, std::array<double, 3> > vertices;
+            std::map<unsigned, std::array<unsigned, 3> > faces;
+        };
+
+        // Apply one bm_journal delta record
+        void replay_bm_record(const nlohmann::json &record, BinaryMesh &mesh, nlohmann::json *stores[4]) {
+            const auto list = [&record](const char *key) { return record.value(key, nlohmann::json::array()); };
+            for (auto &h: list("DELETED_FACES")) mesh.faces.erase(h.get<unsigned>());
+            for (auto &h: list("DELETED_VERTICES")) mesh.vertices.erase(h.get<unsigned>());
+            for (auto &vv: list("VERTICES"))
+                mesh.vertices[vv.at(0).get<unsigned>()] = {vv.at(1), vv.at(2), vv.at(3)};
+            for (auto &ff: list("FACES"))
+                mesh.faces[ff.at(0).get<unsigned>()] = {ff.at(1), ff.at(2), ff.at(3)};
+
+            const char *keys[4] = {"VERTEX_PROPERTIES", "EDGE_PROPERTIES", "FACE_PROPERTIES", "HALF_EDGE_PROPERTIES"};
+            for (int i = 0; i < 4; ++i)
+                if (record.contains(keys[i])) *stores[i] = stores[i]->patch(record[keys[i]]);
+        }
+    }
+
+    void triMesh::read_binary(const char *data, std::size_t size) {
         clear_data();
-        std::ifstream in(fn, std::ios::binary);
-        std::vector<uint8_t> buf((std::istreambuf_iterator<char>(in)),
-                                 std::istreambuf_iterator<char>());
-        auto js = nlohmann::json::from_bson(buf);
-        for (auto &vv: js["VERTICES"])
-            add_vertex(vv[0], vv[1], vv[2]);
-        for (auto &ff: js["FACES"])
-            add_face(
-                get_vertex(ff[0].get<unsigned>()),
-                get_vertex(ff[1].get<unsigned>()),
-                get_vertex(ff[2].get<unsigned>()));
+        const auto *bytes = reinterpret_cast<const std::uint8_t *>(data);
+        // size of the BSON document at offset at, 0 if it does not fit
+        const auto document_size = [bytes, size](std::size_t at) -> std::size_t {
+            if (size - at < 5) return 0;
+            std::uint32_t n = 0;
+            for (int i = 3; i >= 0; --i) n = (n << 8) | bytes[at + i];
+            return n >= 5 && n <= size - at ? n : 0;
+        };
+        std::size_t at = document_size(0);
+        if (at == 0) throw std::runtime_error("Truncated .bm file");
+        auto js = nlohmann::json::from_bson(bytes, bytes + at);
+
+        // handles are stored when they are not simply 0..n-1
+        BinaryMesh mesh;
+        const auto &vertex_handles = js.value("VERTEX_HANDLES", nlohmann::json::array());
+        const auto &face_handles = js.value("FACE_HANDLES", nlohmann::json::array());
+        unsigned k = 0;
+        for (auto &vv: js["VERTICES"]) {
+            const unsigned h = vertex_handles.empty() ? k : vertex_handles.at(k).get<unsigned>();
+            mesh.vertices[h] = {vv[0], vv[1], vv[2]};
+            ++k;
+        }
+        k = 0;
+        for (auto &ff: js["FACES"]) {
+            const unsigned h = face_handles.empty() ? k : face_handles.at(k).get<unsigned>();
+            mesh.faces[h] = {ff[0], ff[1], ff[2]};
+            ++k;
+        }
         vertex_data_store = js["VERTEX_PROPERTIES"];
         edge_data_store = js["EDGE_PROPERTIES"];
         face_data_store = js["FACE_PROPERTIES"];
+        // older files predate half-edge properties
+        half_edge_data_store = js.value("HALF_EDGE_PROPERTIES", nlohmann::json());
+
+        // bm_journal delta records follow the base document; a torn last
+        // record from an interrupted save is dropped
+        nlohmann::json *stores[4] = {&vertex_data_store, &edge_data_store, &face_data_store, &half_edge_data_store};
+        while (at < size) {
+            const std::size_t n = document_size(at);
+            if (n == 0) break;
+            replay_bm_record(nlohmann::json::from_bson(bytes + at, bytes + at + n), mesh, stores);
+            at += n;
+        }
+
+        for (auto &[h, p]: mesh.vertices) {
+            next_vertex_handle_ = h;
+            add_vertex(p[0], p[1], p[2]);
+        }
+        for (auto &[h, f]: mesh.faces) {
+            const auto vertex_at = [this](unsigned v) {
+                const auto it = handle_to_vertex_.find(v);
+                if (it == handle_to_vertex_.end()) throw std::runtime_error("Corrupt .bm file: unknown vertex");
+                return it->second;
+            };
+            next_face_handle_ = h;
+            add_face(vertex_at(f[0]), vertex_at(f[1]), vertex_at(f[2]));
+        }
         complete_mesh();
     }
 
     // — Writers —
-    void triMesh::write_gmsh(const std::string &fn) const {
-        std::ofstream out(fn);
+    void triMesh::write_gmsh(std::ostream &out) const {
         out << "$MeshFormat\n2.2 0 " << sizeof(double) << "\n$EndMeshFormat\n";
         out << "$Nodes\n" << vertices_.size() << "\n";
         for (auto &v: vertices_)
@@ -124,8 +325,7 @@ namespace halfMesh {
         out << "$EndElements\n";
     }
 
-    void triMesh::write_obj(const std::string &fn) const {
-        std::ofstream out(fn);
+    void triMesh::write_obj(std::ostream &out) const {
         for (auto &v: vertices_)
             out << "v " << v->get_x() << " " << v->get_y() << " " << v->get_z() << "\n";
         for (auto &f: faces_) {
@@ -134,28 +334,36 @@ namespace halfMesh {
         }
     }
 
-    void triMesh::write_binary(const std::string &fn) const {
+    void triMesh::write_binary(std::ostream &out) const {
         nlohmann::json js;
-        for (auto &v: vertices_)
+        bool dense_vertices = true, dense_faces = true;
+        for (auto &v: vertices_) {
+            dense_vertices = dense_vertices && v->get_handle() == js["VERTICES"].size();
             js["VERTICES"].push_back({v->get_x(), v->get_y(), v->get_z()});
+        }
         for (auto &f: faces_) {
             auto [a,b,c] = f->get_vertices();
+            dense_faces = dense_faces && f->get_handle() == js["FACES"].size();
             js["FACES"].push_back({a->get_handle(), b->get_handle(), c->get_handle()});
         }
+        // faces and properties refer to handles, keep them after deletions
+        if (!dense_vertices)
+            for (auto &v: vertices_) js["VERTEX_HANDLES"].push_back(v->get_handle());
+        if (!dense_faces)
+            for (auto &f: faces_) js["FACE_HANDLES"].push_back(f->get_handle());
         js["VERTEX_PROPERTIES"] = vertex_data_store;
         js["EDGE_PROPERTIES"] = edge_data_store;
         js["FACE_PROPERTIES"] = face_data_store;
+        js["HALF_EDGE_PROPERTIES"] = half_edge_data_store;
 
         auto buf = nlohmann::json::to_bson(js);
-        std::ofstream out(fn, std::ios::binary);
         out.write(
             reinterpret_cast<const char *>(buf.data()),
             static_cast<std::streamsize>(buf.size())
         );
     }
 
-    void triMesh::write_vtk(const std::string &fn) const {
-        std::ofstream out(fn);
+    void triMesh::write_vtk(std::ostream &out) const {
         out << "# vtk DataFile Version 2.0\nHalfMesh VTK\nASCII\nDATASET POLYDATA\n";
         out << "POINTS " << vertices_.size() << " float\n";
         for (auto &v: vertices_)
@@ -170,34 +378,29 @@ namespace halfMesh {
     //
     // Write ASCII STL
     //
-    void triMesh::write_stl_ascii(const std::string &fn) const {
-        std::ofstream out(fn);
-        if (!out) {
-            std::cerr << "Can't open " << fn << std::endl;
-            return;
-        }
-        out << "solid halfMesh" << std::endl;
+    void triMesh::write_stl_ascii(std::ostream &out) const {
+        out << "solid halfMesh\n";
         for (auto &f: faces_) {
             auto [a,b,c] = f->get_vertices();
-            out << "  facet normal " << 0.0 << " " << 0.0 << " " << 0.0 << std::endl;
-            out << "    outer loop" << std::endl;
-            out << "      vertex " << a->get_x() << " " << a->get_y() << " " << a->get_z() << std::endl;
-            out << "      vertex " << b->get_x() << " " << b->get_y() << " " << b->get_z() << std::endl;
-            out << "      vertex " << c->get_x() << " " << c->get_y() << " " << c->get_z() << std::endl;
-            out << "    endloop" << std::endl;
-            out << "  endfacet" << std::endl;
+            out << "  facet normal " << 0.0 << " " << 0.0 << " " << 0.0 << "\n";
+            out << "    outer loop\n";
+            out << "      vertex " << a->get_x() << " " << a->get_y() << " " << a->get_z() << "\n";
+            out << "      vertex " << b->get_x() << " " << b->get_y() << " " << b->get_z() << "\n";
+            out << "      vertex " << c->get_x() << " " << c->get_y() << " " << c->get_z() << "\n";
+            out << "    endloop\n";
+            out << "  endfacet\n";
         }
-        out << "endsolid halfMesh" << std::endl;
-        out.close();
+        out << "endsolid halfMesh\n";
     }
 
     //
     // Read STL (auto–detect ASCII vs binary)
     //
-    void triMesh::read_stl(const std::string &filename) {
-        std::ifstream file(filename, std::ios::binary);
-        if (!file) {
-            throw std::runtime_error("Could not open STL file.");
+    void triMesh::read_stl(const char *data, std::size_t size) {
+        detail::memory_buffer buffer(data, size);
+        std::istream file(&buffer);
+        if (size < 5) {
+            throw std::runtime_error("Not an STL file.");
         }
 
         // Lambda for the hash function
@@ -207,12 +410,15 @@ namespace halfMesh {
         };
 
         // Lambda to read binary STL files
-        auto readBinarySTL = [&file, &arrayHash]() {
+        auto readBinarySTL = [&file, &arrayHash, size]() {
+            if (size < 84) throw std::runtime_error("Not an STL file.");
             char header[80];
             file.read(header, 80);
 
             uint32_t numTriangles;
             file.read(reinterpret_cast<char *>(&numTriangles), sizeof(numTriangles));
+            if (84 + 50 * static_cast<std::uint64_t>(numTriangles) > size)
+                throw std::runtime_error("Truncated binary STL.");
 
             std::vector<std::array<double, 3> > vertices;
             std::vector<std::array<unsigned int, 3> > triangles;
@@ -286,13 +492,16 @@ namespace halfMesh {
             return std::make_pair(vertices, triangles);
         };
 
-        // Check if the file is binary or ASCII
-        char header[80];
-        file.read(header, 80);
-        file.seekg(0, std::ios::beg);
-
+        // Check if the file is binary or ASCII. Binary headers may start with
+        // "solid" too, so the binary size check wins.
         std::pair<std::vector<std::array<double, 3> >, std::vector<std::array<unsigned int, 3> > > rawResult;
-        if (header[0] == 's' && header[1] == 'o' && header[2] == 'l' && header[3] == 'i' && header[4] == 'd') {
+        bool binary = false;
+        if (size >= 84) {
+            std::uint32_t count;
+            std::memcpy(&count, data + 80, sizeof(count));
+            binary = 84 + 50 * static_cast<std::uint64_t>(count) == size;
+        }
+        if (!binary && std::strncmp(data, "solid", 5) == 0) {
             // ASCII STL
             rawResult = readAsciiSTL();
         } else {
@@ -300,35 +509,14 @@ namespace halfMesh {
             rawResult = readBinarySTL();
         }
 
-        // Convert the result to sLib3MFPosition and sLib3MFTriangle
-        std::vector<std::array<double,3>> positions;
+        // Hand the de-duplicated soup to the bulk builder
+        std::vector<std::array<double, 3> > positions;
+        positions.reserve(rawResult.first.size());
         for (const auto &vertex: rawResult.first) {
             positions.push_back({static_cast<float>(vertex[0]), static_cast<float>(vertex[1]),
-                                               static_cast<float>(vertex[2])});
+                                 static_cast<float>(vertex[2])});
         }
-        std::vector<std::array<int, 3>> triangles;
-        for (const auto &triangle: rawResult.second) {
-            triangles.push_back({
-                static_cast<int>(triangle[0]),
-                static_cast<int>(triangle[1]),
-                static_cast<int>(triangle[2])});
-        }
-
-        std::unordered_map<int, vertexPtr> vertexMap;
-        for (unsigned int i = 0; i < positions.size(); ++i) {
-            auto iter = positions[i];
-            auto currentVertex = add_vertex(iter[0], iter[1], iter[2]);
-            vertexMap[i] = currentVertex;
-        }
-        for (unsigned int i = 0; i < triangles.size(); ++i) {
-            auto iter = triangles[i];
-            auto currentTriangle = add_face(
-                vertexMap[iter[0]],
-                vertexMap[iter[1]],
-                vertexMap[iter[2]]);
-        }
-
-        complete_mesh();
+        build_from_arrays(positions, rawResult.second);
     }
 
     //
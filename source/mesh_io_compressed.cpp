@@ -0,0 +1,842 @@
+#include "triMesh.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace halfMesh {
+    namespace {
+        //
+        // .hmc layout (integers are LEB128 varints, doubles raw little endian):
+        //   "HMC" 0x01, mode, position bits, Rice parameter per axis,
+        //   vertex count, triangle count, bounding box minimum, quantisation step,
+        //   then the mode specific body.
+        //
+        // Edgebreaker body: number of vertex ids, traversal triangles and
+        // components, the dummy vertex ids, the corner patch list, then the
+        // CLERS bit stream and the position residual stream. Holes are closed
+        // with a fan around one dummy vertex each, so the traversal only ever
+        // sees closed surfaces; dummy triangles are dropped when decoding.
+        //
+        // Raw body: delta coded indices and position residuals, used for
+        // non-manifold input or whenever it is smaller.
+        //
+        constexpr char kMagic[4] = {'H', 'M', 'C', 1};
+
+        enum class hmc_mode : std::uint8_t { Edgebreaker = 0, Raw = 1 };
+
+        enum class clers : std::uint8_t { C, S, R, L, E };
+
+        constexpr unsigned kUnset = std::numeric_limits<unsigned>::max();
+
+        // Decoder corner table markers: free edges wait for a later triangle,
+        // to-zip edges for an earlier one; pending S gates and handles are neither
+        constexpr std::int64_t kFree = -1, kToZip = -2, kOpen = -3;
+
+        // Unary prefixes longer than this switch to an explicit width
+        constexpr unsigned kRiceEscape = 24;
+
+        inline std::int64_t next_corner(std::int64_t c) { return c % 3 == 2 ? c - 2 : c + 1; }
+        inline std::int64_t prev_corner(std::int64_t c) { return c % 3 == 0 ? c + 2 : c - 1; }
+
+        inline std::uint64_t low_bits(unsigned n) { return n >= 64 ? ~0ull : (1ull << n) - 1; }
+
+        inline std::uint64_t zigzag(std::int64_t v) {
+            return (static_cast<std::uint64_t>(v) << 1) ^ static_cast<std::uint64_t>(v >> 63);
+        }
+
+        inline std::int64_t unzigzag(std::uint64_t v) {
+            return static_cast<std::int64_t>(v >> 1) ^ -static_cast<std::int64_t>(v & 1);
+        }
+
+        [[noreturn]] void corrupt() { throw std::runtime_error("Corrupt compressed mesh"); }
+
+        //— Bit and byte streams ——
+        class bit_writer {
+        public:
+            // n <= 56
+            void put(std::uint64_t bits, unsigned n) {
+                acc_ |= (bits & low_bits(n)) << fill_;
+                fill_ += n;
+                while (fill_ >= 8) {
+                    bytes_.push_back(static_cast<char>(acc_ & 0xff));
+                    acc_ >>= 8;
+                    fill_ -= 8;
+                }
+            }
+
+            std::string finish() {
+                if (fill_ > 0) bytes_.push_back(static_cast<char>(acc_ & 0xff));
+                acc_ = 0;
+                fill_ = 0;
+                return std::move(bytes_);
+            }
+
+        private:
+            std::string bytes_;
+            std::uint64_t acc_ = 0;
+            unsigned fill_ = 0;
+        };
+
+        class bit_reader {
+        public:
+            bit_reader(const unsigned char *data, std::size_t size) : data_(data), size_(size) {
+            }
+
+            // n <= 56
+            std::uint64_t get(unsigned n) {
+                while (fill_ < n) {
+                    if (pos_ >= size_) corrupt();
+                    acc_ |= static_cast<std::uint64_t>(data_[pos_++]) << fill_;
+                    fill_ += 8;
+                }
+                const std::uint64_t v = acc_ & low_bits(n);
+                acc_ >>= n;
+                fill_ -= n;
+                return v;
+            }
+
+        private:
+            const unsigned char *data_;
+            std::size_t size_, pos_ = 0;
+            std::uint64_t acc_ = 0;
+            unsigned fill_ = 0;
+        };
+
+        // Edgebreaker code: C = 0, S = 100, R = 101, L = 110, E = 111 (first bit first)
+        void put_symbol(bit_writer &w, clers s) {
+            if (s == clers::C) {
+                w.put(0, 1);
+            } else {
+                w.put(1, 1);
+                w.put(static_cast<unsigned>(s) - 1, 2);
+            }
+        }
+
+        clers get_symbol(bit_reader &r) {
+            if (r.get(1) == 0) return clers::C;
+            return static_cast<clers>(r.get(2) + 1);
+        }
+
+        void put_rice(bit_writer &w, std::uint64_t v, unsigned k) {
+            const std::uint64_t q = v >> k;
+            if (q < kRiceEscape) {
+                w.put(low_bits(static_cast<unsigned>(q)), static_cast<unsigned>(q));
+                w.put(0, 1);
+                w.put(v, k);
+                return;
+            }
+            unsigned width = 0;
+            while (width < 64 && (v >> width) != 0) ++width;
+            w.put(low_bits(kRiceEscape), kRiceEscape);
+            w.put(width, 7);
+            w.put(v, std::min(width, 32u));
+            if (width > 32) w.put(v >> 32, width - 32);
+        }
+
+        std::uint64_t get_rice(bit_reader &r, unsigned k) {
+            unsigned q = 0;
+            while (q < kRiceEscape && r.get(1)) ++q;
+            if (q < kRiceEscape) return (static_cast<std::uint64_t>(q) << k) | r.get(k);
+            const auto width = static_cast<unsigned>(r.get(7));
+            if (width > 64) corrupt();
+            std::uint64_t v = r.get(std::min(width, 32u));
+            if (width > 32) v |= r.get(width - 32) << 32;
+            return v;
+        }
+
+        // Rice parameter with the smallest total size, searched around log2(mean)
+        unsigned best_rice_parameter(const std::vector<std::uint64_t> &values) {
+            if (values.empty()) return 0;
+            double mean = 0;
+            for (auto v: values) mean += static_cast<double>(v);
+            mean /= static_cast<double>(values.size());
+            const int guess = mean < 1 ? 0 : static_cast<int>(std::log2(mean));
+            unsigned best = 0;
+            std::uint64_t best_bits = std::numeric_limits<std::uint64_t>::max();
+            for (int k = std::max(0, guess - 2); k <= std::min(guess + 2, 48); ++k) {
+                std::uint64_t bits = 0;
+                for (auto v: values) {
+                    const std::uint64_t q = v >> k;
+                    bits += q < kRiceEscape ? q + 1 + k : kRiceEscape + 7 + 64;
+                }
+                if (bits < best_bits) {
+                    best_bits = bits;
+                    best = static_cast<unsigned>(k);
+                }
+            }
+            return best;
+        }
+
+        void put_varint(std::string &out, std::uint64_t v) {
+            while (v >= 0x80) {
+                out.push_back(static_cast<char>((v & 0x7f) | 0x80));
+                v >>= 7;
+            }
+            out.push_back(static_cast<char>(v));
+        }
+
+        void put_double(std::string &out, double v) {
+            char b[8];
+            std::memcpy(b, &v, 8);
+            out.append(b, 8);
+        }
+
+        void put_block(std::string &out, const std::string &block) {
+            put_varint(out, block.size());
+            out += block;
+        }
+
+        class byte_reader {
+        public:
+            byte_reader(const char *data, std::size_t size)
+                : p_(reinterpret_cast<const unsigned char *>(data)), end_(p_ + size) {
+            }
+
+            std::uint8_t byte() {
+                if (p_ >= end_) corrupt();
+                return *p_++;
+            }
+
+            std::uint64_t varint() {
+                std::uint64_t v = 0;
+                for (unsigned shift = 0; shift < 64; shift += 7) {
+                    const std::uint8_t b = byte();
+                    v |= static_cast<std::uint64_t>(b & 0x7f) << shift;
+                    if (!(b & 0x80)) return v;
+                }
+                corrupt();
+            }
+
+            double real() {
+                if (end_ - p_ < 8) corrupt();
+                double v;
+                std::memcpy(&v, p_, 8);
+                p_ += 8;
+                return v;
+            }
+
+            bit_reader block() {
+                const std::uint64_t n = varint();
+                if (n > static_cast<std::uint64_t>(end_ - p_)) corrupt();
+                bit_reader r(p_, static_cast<std::size_t>(n));
+                p_ += n;
+                return r;
+            }
+
+        private:
+            const unsigned char *p_;
+            const unsigned char *end_;
+        };
+
+        //— Positions ——
+        struct quantizer {
+            double lo[3] = {0, 0, 0};
+            double step[3] = {0, 0, 0};
+
+            std::int64_t quantize(double x, int axis) const {
+                return step[axis] > 0 ? std::llround((x - lo[axis]) / step[axis]) : 0;
+            }
+
+            double restore(std::int64_t q, int axis) const { return lo[axis] + static_cast<double>(q) * step[axis]; }
+        };
+
+        quantizer make_quantizer(const std::vector<std::array<double, 3> > &positions, int bits) {
+            quantizer qz;
+            if (positions.empty()) return qz;
+            for (int a = 0; a < 3; ++a) {
+                double lo = positions[0][a], hi = positions[0][a];
+                for (auto &p: positions) {
+                    lo = std::min(lo, p[a]);
+                    hi = std::max(hi, p[a]);
+                }
+                qz.lo[a] = lo;
+                qz.step[a] = hi > lo ? (hi - lo) / static_cast<double>(low_bits(static_cast<unsigned>(bits))) : 0.0;
+            }
+            return qz;
+        }
+
+        //
+        // Parallelogram prediction for vertex id v, introduced by a C triangle
+        // across gate corner g: b + c - a over the gate's triangle. Falls back
+        // to the gate edge midpoint, then to the previous vertex, whenever a
+        // reference is a dummy or not decoded yet.
+        //
+        struct predictor {
+            const std::vector<unsigned> &V;
+            const std::vector<std::int64_t> &gate;
+            const std::vector<char> &dummy;
+            const std::vector<std::int64_t> &q; // 3 per vertex id
+
+            std::int64_t operator()(unsigned v, int axis, unsigned last) const {
+                const auto known = [&](unsigned u) { return u < v && !dummy[u]; };
+                const std::int64_t g = v < gate.size() ? gate[v] : -1;
+                if (g >= 0) {
+                    const unsigned a = V[g], b = V[next_corner(g)], c = V[prev_corner(g)];
+                    if (known(a) && known(b) && known(c))
+                        return q[3 * b + axis] + q[3 * c + axis] - q[3 * a + axis];
+                    if (known(b) && known(c))
+                        return (q[3 * b + axis] + q[3 * c + axis]) / 2;
+                }
+                return last == kUnset ? 0 : q[3 * last + axis];
+            }
+        };
+
+        //— Edgebreaker decoding ——
+        class eb_decoder {
+        public:
+            eb_decoder(std::uint64_t triangles, std::uint64_t ids)
+                : V(3 * triangles, kUnset), O(3 * triangles, kOpen), gate(ids, -1),
+                  capacity_(triangles), ids_(ids) {
+            }
+
+            // One component: a start triangle with three new vertices, then CLERS
+            void component(bit_reader &r) {
+                if (T_ >= capacity_ || N_ + 3 > ids_) corrupt();
+                const std::int64_t s = 3 * static_cast<std::int64_t>(T_++);
+                V[s] = N_++;
+                V[s + 1] = N_++;
+                V[s + 2] = N_++;
+                O[s + 1] = kFree;
+                O[s + 2] = kFree;
+
+                std::int64_t c = s;
+                while (true) {
+                    const std::int64_t t = attach(c);
+                    c = t + 1;
+                    switch (get_symbol(r)) {
+                        case clers::C:
+                            if (N_ >= ids_) corrupt();
+                            gate[N_] = O[t];
+                            V[t] = N_++;
+                            O[t + 2] = kFree;
+                            break;
+                        case clers::L:
+                            O[t + 2] = kToZip;
+                            zip(t + 2);
+                            break;
+                        case clers::R:
+                            O[t + 1] = kToZip;
+                            zip_back(t + 1);
+                            c = t + 2;
+                            break;
+                        case clers::S:
+                            pending_.push_back(t + 2);
+                            break;
+                        case clers::E:
+                            O[t + 1] = kToZip;
+                            O[t + 2] = kToZip;
+                            zip(t + 2);
+                            // resume the innermost S whose left side is still open
+                            while (true) {
+                                if (pending_.empty()) return;
+                                c = pending_.back();
+                                pending_.pop_back();
+                                if (r.get(1) == 0) break;
+                            }
+                            break;
+                    }
+                }
+            }
+
+            std::uint64_t triangles() const { return T_; }
+
+            std::vector<unsigned> V;
+            std::vector<std::int64_t> O;
+            std::vector<std::int64_t> gate; // gate corner of the C triangle introducing each id
+
+        private:
+            // New triangle across gate corner c
+            std::int64_t attach(std::int64_t c) {
+                if (T_ >= capacity_) corrupt();
+                const std::int64_t t = 3 * static_cast<std::int64_t>(T_++);
+                O[c] = t;
+                O[t] = c;
+                V[t + 1] = V[prev_corner(c)];
+                V[t + 2] = V[next_corner(c)];
+                return t;
+            }
+
+            // Glue to-zip edge c to the free edge following it around its end
+            // vertex, copy the id of its start vertex around, then carry on
+            // with the to-zip edge the glue has made adjacent
+            void zip(std::int64_t c) {
+                const std::size_t limit = O.size();
+                std::size_t steps = 0;
+                while (true) {
+                    std::int64_t b = next_corner(c);
+                    while (O[b] >= 0) {
+                        b = next_corner(O[b]);
+                        if (++steps > limit) return;
+                    }
+                    if (O[b] != kFree) return;
+                    O[c] = b;
+                    O[b] = c;
+                    std::int64_t a = prev_corner(c);
+                    V[prev_corner(a)] = V[prev_corner(b)];
+                    while (O[a] >= 0 && b != a) {
+                        a = prev_corner(O[a]);
+                        V[prev_corner(a)] = V[prev_corner(b)];
+                        if (++steps > limit) return;
+                    }
+                    c = prev_corner(c);
+                    while (O[c] >= 0 && c != b) {
+                        c = prev_corner(O[c]);
+                        if (++steps > limit) return;
+                    }
+                    if (O[c] != kToZip) return;
+                }
+            }
+
+            // Mirror of zip for R triangles, which close the fan around their
+            // gate vertex: glue c to the free edge before it around its start
+            // vertex and copy the id of its end vertex around
+            void zip_back(std::int64_t c) {
+                const std::size_t limit = O.size();
+                std::size_t steps = 0;
+                std::int64_t b = prev_corner(c);
+                while (O[b] >= 0) {
+                    b = prev_corner(O[b]);
+                    if (++steps > limit) return;
+                }
+                if (O[b] != kFree) return;
+                O[c] = b;
+                O[b] = c;
+                std::int64_t a = next_corner(c);
+                V[next_corner(a)] = V[next_corner(b)];
+                while (O[a] >= 0 && b != a) {
+                    a = next_corner(O[a]);
+                    V[next_corner(a)] = V[next_corner(b)];
+                    if (++steps > limit) return;
+                }
+            }
+
+            std::vector<std::int64_t> pending_;
+            std::uint64_t T_ = 0, capacity_;
+            unsigned N_ = 0;
+            std::uint64_t ids_;
+        };
+
+        //— Encoding ——
+        std::string encode_header(hmc_mode mode, int bits, const unsigned rice[3], std::uint64_t nv,
+                                  std::uint64_t nt, const quantizer &qz) {
+            std::string out(kMagic, 4);
+            out.push_back(static_cast<char>(mode));
+            out.push_back(static_cast<char>(bits));
+            for (int a = 0; a < 3; ++a) out.push_back(static_cast<char>(rice[a]));
+            put_varint(out, nv);
+            put_varint(out, nt);
+            for (double x: qz.lo) put_double(out, x);
+            for (double x: qz.step) put_double(out, x);
+            return out;
+        }
+
+        std::string encode_raw(const std::vector<std::array<double, 3> > &positions,
+                               const std::vector<std::array<unsigned, 3> > &tris, int bits, const quantizer &qz) {
+            bit_writer index_bits;
+            std::int64_t last = 0;
+            std::vector<std::uint64_t> deltas;
+            deltas.reserve(3 * tris.size());
+            for (auto &t: tris)
+                for (unsigned v: t) {
+                    deltas.push_back(zigzag(static_cast<std::int64_t>(v) - last));
+                    last = v;
+                }
+            const unsigned index_k = best_rice_parameter(deltas);
+            for (auto d: deltas) put_rice(index_bits, d, index_k);
+
+            unsigned rice[3];
+            std::vector<std::uint64_t> residuals[3];
+            for (int a = 0; a < 3; ++a) {
+                std::int64_t prev = 0;
+                for (auto &p: positions) {
+                    const std::int64_t q = qz.quantize(p[a], a);
+                    residuals[a].push_back(zigzag(q - prev));
+                    prev = q;
+                }
+                rice[a] = best_rice_parameter(residuals[a]);
+            }
+            bit_writer position_bits;
+            for (std::size_t i = 0; i < positions.size(); ++i)
+                for (int a = 0; a < 3; ++a) put_rice(position_bits, residuals[a][i], rice[a]);
+
+            std::string out = encode_header(hmc_mode::Raw, bits, rice, positions.size(), tris.size(), qz);
+            out.push_back(static_cast<char>(index_k));
+            put_block(out, index_bits.finish());
+            put_block(out, position_bits.finish());
+            return out;
+        }
+
+        // Empty string when the input is not an edge-manifold, consistently oriented surface
+        std::string encode_edgebreaker(const std::vector<std::array<double, 3> > &positions,
+                                       const std::vector<std::array<unsigned, 3> > &tris, int bits,
+                                       const quantizer &qz) {
+            const auto nv = static_cast<unsigned>(positions.size());
+
+            // 1) corner table; every directed edge may appear once
+            std::vector<unsigned> Vc;
+            Vc.reserve(3 * tris.size());
+            for (auto &t: tris) {
+                if (t[0] == t[1] || t[1] == t[2] || t[0] == t[2]) return {};
+                Vc.insert(Vc.end(), t.begin(), t.end());
+            }
+            const auto key = [](std::uint64_t a, std::uint64_t b) { return (a << 32) | b; };
+            std::unordered_map<std::uint64_t, std::int64_t> edge_corner; // edge opposite a corner -> corner
+            edge_corner.reserve(Vc.size() * 2);
+            const auto add_edges = [&](std::size_t first) {
+                for (std::size_t c = first; c < Vc.size(); ++c)
+                    if (!edge_corner.emplace(key(Vc[next_corner(c)], Vc[prev_corner(c)]),
+                                             static_cast<std::int64_t>(c)).second)
+                        return false;
+                return true;
+            };
+            if (!add_edges(0)) return {};
+
+            // 2) close every boundary loop with a fan around a dummy vertex
+            std::unordered_map<unsigned, std::vector<unsigned> > boundary_out;
+            std::size_t boundary_edges = 0;
+            for (std::size_t c = 0; c < Vc.size(); ++c) {
+                const unsigned a = Vc[next_corner(c)], b = Vc[prev_corner(c)];
+                if (!edge_corner.count(key(b, a))) {
+                    boundary_out[a].push_back(b);
+                    ++boundary_edges;
+                }
+            }
+            unsigned dummies = 0;
+            const std::size_t real_corners = Vc.size();
+            // a loop passing a vertex twice is split into simple cycles, so no
+            // dummy sees the same boundary vertex twice
+            std::vector<unsigned> path;
+            std::unordered_map<unsigned, std::size_t> on_path;
+            while (boundary_edges > 0) {
+                auto start = boundary_out.begin();
+                while (start->second.empty()) start = boundary_out.erase(start);
+                unsigned a = start->first;
+                path.assign(1, a);
+                on_path.clear();
+                on_path.emplace(a, 0);
+                while (path.size() > 1 || !boundary_out[a].empty()) {
+                    auto &out = boundary_out[a];
+                    if (out.empty()) return {};
+                    const unsigned b = out.back();
+                    out.pop_back();
+                    --boundary_edges;
+                    const auto seen = on_path.find(b);
+                    if (seen == on_path.end()) {
+                        on_path.emplace(b, path.size());
+                        path.push_back(b);
+                        a = b;
+                        continue;
+                    }
+                    // b closes the cycle path[seen..] -> b
+                    const unsigned d = nv + dummies++;
+                    const std::size_t first = seen->second;
+                    path.push_back(b);
+                    for (std::size_t i = first; i + 1 < path.size(); ++i)
+                        Vc.insert(Vc.end(), {path[i + 1], path[i], d});
+                    for (std::size_t i = first + 1; i + 1 < path.size(); ++i) on_path.erase(path[i]);
+                    path.resize(first + 1);
+                    a = b;
+                }
+            }
+            if (!add_edges(real_corners)) return {};
+
+            const std::size_t nt_all = Vc.size() / 3;
+            std::vector<std::int64_t> Oc(Vc.size());
+            for (std::size_t c = 0; c < Vc.size(); ++c) {
+                const auto it = edge_corner.find(key(Vc[prev_corner(c)], Vc[next_corner(c)]));
+                if (it == edge_corner.end()) return {};
+                Oc[c] = it->second;
+            }
+            edge_corner.clear();
+
+            // 3) traversal; ids are handed out in the order the decoder creates them
+            std::vector<unsigned> id(nv + dummies, kUnset);
+            std::vector<char> visited(nt_all, 0);
+            std::vector<std::int64_t> tri_corner, pending;
+            tri_corner.reserve(nt_all);
+            std::vector<unsigned> extra_ids; // fresh start triangle ids for already numbered vertices
+            bit_writer conn;
+            unsigned N = 0;
+            std::uint64_t components = 0;
+            for (std::size_t t0 = 0; t0 < nt_all; ++t0) {
+                if (visited[t0]) continue;
+                ++components;
+                std::int64_t c = 3 * static_cast<std::int64_t>(t0);
+                for (const std::int64_t k: {c, next_corner(c), prev_corner(c)}) {
+                    const unsigned fresh = N++;
+                    if (id[Vc[k]] == kUnset) id[Vc[k]] = fresh;
+                    else extra_ids.push_back(fresh);
+                }
+                visited[t0] = 1;
+                tri_corner.push_back(c);
+
+                c = Oc[c];
+                while (true) {
+                    visited[c / 3] = 1;
+                    tri_corner.push_back(c);
+                    if (id[Vc[c]] == kUnset) {
+                        id[Vc[c]] = N++;
+                        put_symbol(conn, clers::C);
+                        c = Oc[next_corner(c)];
+                        continue;
+                    }
+                    const bool right = visited[Oc[next_corner(c)] / 3];
+                    const bool left = visited[Oc[prev_corner(c)] / 3];
+                    if (right && left) {
+                        put_symbol(conn, clers::E);
+                        bool done = true;
+                        while (!pending.empty()) {
+                            c = pending.back();
+                            pending.pop_back();
+                            // a left side reached meanwhile is a handle
+                            if (!visited[c / 3]) {
+                                conn.put(0, 1);
+                                done = false;
+                                break;
+                            }
+                            conn.put(1, 1);
+                        }
+                        if (done) break;
+                    } else if (right) {
+                        put_symbol(conn, clers::R);
+                        c = Oc[prev_corner(c)];
+                    } else if (left) {
+                        put_symbol(conn, clers::L);
+                        c = Oc[next_corner(c)];
+                    } else {
+                        put_symbol(conn, clers::S);
+                        pending.push_back(Oc[prev_corner(c)]);
+                        c = Oc[next_corner(c)];
+                    }
+                }
+            }
+            // unreferenced vertices go last
+            for (unsigned v = 0; v < nv; ++v)
+                if (id[v] == kUnset) id[v] = N++;
+
+            std::vector<char> dummy(N, 0);
+            std::vector<unsigned> orig(N, kUnset);
+            for (unsigned v = 0; v < nv; ++v) orig[id[v]] = v;
+            for (unsigned d = 0; d < dummies; ++d) dummy[id[nv + d]] = 1;
+            for (unsigned x: extra_ids) dummy[x] = 1;
+
+            // 4) run the decoder; wherever it cannot infer a corner's vertex
+            //    (handles, pinched vertices) the correct id goes into a patch
+            const std::string conn_bytes = conn.finish();
+            eb_decoder dec(nt_all, N);
+            {
+                bit_reader r(reinterpret_cast<const unsigned char *>(conn_bytes.data()), conn_bytes.size());
+                for (std::uint64_t k = 0; k < components; ++k) dec.component(r);
+            }
+            if (dec.triangles() != nt_all || tri_corner.size() != nt_all) return {};
+
+            std::vector<std::pair<std::uint64_t, unsigned> > patches;
+            for (std::size_t t = 0; t < nt_all; ++t) {
+                const std::int64_t c = tri_corner[t];
+                const unsigned expected[3] = {id[Vc[c]], id[Vc[next_corner(c)]], id[Vc[prev_corner(c)]]};
+                for (int k = 0; k < 3; ++k)
+                    if (dec.V[3 * t + k] != expected[k]) {
+                        patches.emplace_back(3 * t + k, expected[k]);
+                        dec.V[3 * t + k] = expected[k];
+                    }
+            }
+
+            // 5) position residuals in id order
+            std::vector<std::int64_t> q(3 * static_cast<std::size_t>(N), 0);
+            for (unsigned v = 0; v < N; ++v)
+                if (orig[v] != kUnset)
+                    for (int a = 0; a < 3; ++a) q[3 * v + a] = qz.quantize(positions[orig[v]][a], a);
+            const predictor predict{dec.V, dec.gate, dummy, q};
+            std::vector<std::uint64_t> residuals[3];
+            unsigned last = kUnset;
+            for (unsigned v = 0; v < N; ++v) {
+                if (dummy[v]) continue;
+                for (int a = 0; a < 3; ++a) residuals[a].push_back(zigzag(q[3 * v + a] - predict(v, a, last)));
+                last = v;
+            }
+            unsigned rice[3];
+            for (int a = 0; a < 3; ++a) rice[a] = best_rice_parameter(residuals[a]);
+            bit_writer position_bits;
+            for (std::size_t i = 0; i < residuals[0].size(); ++i)
+                for (int a = 0; a < 3; ++a) put_rice(position_bits, residuals[a][i], rice[a]);
+
+            // 6) assemble
+            std::string out = encode_header(hmc_mode::Edgebreaker, bits, rice, nv, tris.size(), qz);
+            put_varint(out, N);
+            put_varint(out, nt_all);
+            put_varint(out, components);
+            std::vector<unsigned> dummy_ids;
+            for (unsigned v = 0; v < N; ++v)
+                if (dummy[v]) dummy_ids.push_back(v);
+            put_varint(out, dummy_ids.size());
+            unsigned prev = 0;
+            for (unsigned v: dummy_ids) {
+                put_varint(out, v - prev);
+                prev = v;
+            }
+            put_varint(out, patches.size());
+            std::uint64_t prev_corner_index = 0;
+            for (auto &[corner, v]: patches) {
+                put_varint(out, corner - prev_corner_index);
+                put_varint(out, v);
+                prev_corner_index = corner;
+            }
+            put_block(out, conn_bytes);
+            put_block(out, position_bits.finish());
+            return out;
+        }
+
+        //— Decoding ——
+        void decode(const char *data, std::size_t size, std::vector<std::array<double, 3> > &positions,
+                    std::vector<std::array<unsigned, 3> > &tris) {
+            if (size < 4 || std::memcmp(data, kMagic, 4) != 0)
+                throw std::runtime_error("Not a compressed halfMesh file");
+            byte_reader in(data + 4, size - 4);
+            const auto mode = static_cast<hmc_mode>(in.byte());
+            in.byte(); // position bits, informational
+            unsigned rice[3];
+            for (auto &k: rice) {
+                k = in.byte();
+                if (k > 56) corrupt();
+            }
+            const std::uint64_t nv = in.varint(), nt = in.varint();
+            if (nv >= kUnset) corrupt();
+            quantizer qz;
+            for (double &x: qz.lo) x = in.real();
+            for (double &x: qz.step) x = in.real();
+
+            if (mode == hmc_mode::Raw) {
+                const unsigned index_k = in.byte();
+                if (index_k > 56) corrupt();
+                bit_reader index_bits = in.block();
+                bit_reader position_bits = in.block();
+                tris.resize(static_cast<std::size_t>(nt));
+                std::int64_t last = 0;
+                for (auto &t: tris)
+                    for (unsigned &v: t) {
+                        last += unzigzag(get_rice(index_bits, index_k));
+                        if (last < 0 || static_cast<std::uint64_t>(last) >= nv) corrupt();
+                        v = static_cast<unsigned>(last);
+                    }
+                positions.resize(static_cast<std::size_t>(nv));
+                std::int64_t prev[3] = {0, 0, 0};
+                for (auto &p: positions)
+                    for (int a = 0; a < 3; ++a) {
+                        prev[a] += unzigzag(get_rice(position_bits, rice[a]));
+                        p[a] = qz.restore(prev[a], a);
+                    }
+                return;
+            }
+            if (mode != hmc_mode::Edgebreaker) corrupt();
+
+            const std::uint64_t N = in.varint(), nt_all = in.varint(), components = in.varint();
+            if (N >= kUnset || N < nv || nt_all < nt) corrupt();
+            std::vector<char> dummy(static_cast<std::size_t>(N), 0);
+            const std::uint64_t ndummy = in.varint();
+            if (ndummy > N) corrupt();
+            std::uint64_t v = 0;
+            for (std::uint64_t i = 0; i < ndummy; ++i) {
+                v += in.varint();
+                if (v >= N) corrupt();
+                dummy[v] = 1;
+            }
+            const std::uint64_t npatches = in.varint();
+            std::vector<std::pair<std::uint64_t, unsigned> > patches;
+            patches.reserve(static_cast<std::size_t>(std::min<std::uint64_t>(npatches, 3 * nt_all)));
+            std::uint64_t corner = 0;
+            for (std::uint64_t i = 0; i < npatches; ++i) {
+                corner += in.varint();
+                const std::uint64_t id = in.varint();
+                if (corner >= 3 * nt_all || id >= N) corrupt();
+                patches.emplace_back(corner, static_cast<unsigned>(id));
+            }
+            bit_reader conn = in.block();
+            bit_reader position_bits = in.block();
+
+            // connectivity
+            eb_decoder dec(nt_all, N);
+            for (std::uint64_t k = 0; k < components; ++k) dec.component(conn);
+            if (dec.triangles() != nt_all) corrupt();
+            for (auto &[c, id]: patches) dec.V[c] = id;
+            for (unsigned x: dec.V)
+                if (x >= N) corrupt();
+
+            // positions, in id order
+            std::vector<std::int64_t> q(3 * static_cast<std::size_t>(N), 0);
+            const predictor predict{dec.V, dec.gate, dummy, q};
+            std::vector<unsigned> compact(static_cast<std::size_t>(N), kUnset);
+            positions.clear();
+            positions.reserve(static_cast<std::size_t>(nv));
+            unsigned last = kUnset;
+            for (unsigned id = 0; id < N; ++id) {
+                if (dummy[id]) continue;
+                std::array<double, 3> p;
+                for (int a = 0; a < 3; ++a) {
+                    q[3 * id + a] = predict(id, a, last) + unzigzag(get_rice(position_bits, rice[a]));
+                    p[a] = qz.restore(q[3 * id + a], a);
+                }
+                compact[id] = static_cast<unsigned>(positions.size());
+                positions.push_back(p);
+                last = id;
+            }
+            if (positions.size() != nv) corrupt();
+
+            // triangles without dummy corners
+            tris.clear();
+            tris.reserve(static_cast<std::size_t>(nt));
+            for (std::size_t t = 0; t < nt_all; ++t) {
+                const unsigned a = compact[dec.V[3 * t]], b = compact[dec.V[3 * t + 1]], c = compact[dec.V[3 * t + 2]];
+                if (a == kUnset || b == kUnset || c == kUnset) continue;
+                tris.push_back({a, b, c});
+            }
+            if (tris.size() != nt) corrupt();
+        }
+    }
+
+    // — Compressed (.hmc) —
+    void triMesh::save_compressed(const std::string &fn, int position_bits) const {
+        std::ofstream out(fn, std::ios::binary);
+        if (!out) {
+            std::cerr << "Can't open " << fn << std::endl;
+            return;
+        }
+        write_compressed(out, position_bits);
+    }
+
+    void triMesh::write_compressed(std::ostream &out, int position_bits) const {
+        position_bits = std::clamp(position_bits, 1, 30);
+
+        // dense rows, as for the other writers
+        std::vector<unsigned> row(next_vertex_handle_, 0);
+        std::vector<std::array<double, 3> > positions;
+        positions.reserve(vertices_.size());
+        for (auto &v: vertices_) {
+            row[v->get_handle()] = static_cast<unsigned>(positions.size());
+            positions.push_back({v->get_x(), v->get_y(), v->get_z()});
+        }
+        std::vector<std::array<unsigned, 3> > tris;
+        tris.reserve(faces_.size());
+        for (auto &f: faces_) {
+            auto [a,b,c] = f->get_vertices();
+            tris.push_back({row[a->get_handle()], row[b->get_handle()], row[c->get_handle()]});
+        }
+
+        const quantizer qz = make_quantizer(positions, position_bits);
+        std::string bytes = encode_edgebreaker(positions, tris, position_bits, qz);
+        std::string raw = encode_raw(positions, tris, position_bits, qz);
+        if (bytes.empty() || raw.size() < bytes.size()) bytes.swap(raw);
+        out.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+    }
+
+    void triMesh::read_compressed(const char *data, std::size_t size) {
+        std::vector<std::array<double, 3> > positions;
+        std::vector<std::array<unsigned, 3> > tris;
+        decode(data, size, positions, tris);
+        build_from_arrays(positions, tris);
+    }
+} // namespace halfMesh
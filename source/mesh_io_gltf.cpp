@@ -0,0 +1,249 @@
+#include "triMesh.hpp"
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <limits>
+
+namespace halfMesh {
+    namespace {
+        // glTF constants
+        constexpr std::uint32_t kGlbMagic = 0x46546C67; // "glTF"
+        constexpr std::uint32_t kGlbVersion = 2;
+        constexpr std::uint32_t kChunkJson = 0x4E4F534A; // "JSON"
+        constexpr std::uint32_t kChunkBin = 0x004E4942; // "BIN\0"
+        constexpr int kFloat = 5126;
+        constexpr int kUnsignedInt = 5125;
+        constexpr int kArrayBuffer = 34962;
+        constexpr int kElementArrayBuffer = 34963;
+
+        // Post-transform cache size Tipsify optimises for
+        constexpr int kVertexCacheSize = 16;
+
+        //
+        // Tipsify (Sander, Nehab, Barczak 2007): reorders triangles so that
+        // consecutive ones share vertices still in the GPU's post-transform
+        // cache. Runs in linear time; returns the new triangle order.
+        //
+        std::vector<unsigned> tipsify(const std::vector<std::array<unsigned, 3> > &tris, size_t nv, int cache) {
+            // vertex -> triangles adjacency in CSR form
+            std::vector<unsigned> offset(nv + 1, 0), live(nv, 0);
+            for (auto &t: tris)
+                for (unsigned v: t) ++offset[v + 1];
+            for (size_t v = 0; v < nv; ++v) {
+                live[v] = offset[v + 1];
+                offset[v + 1] += offset[v];
+            }
+            std::vector<unsigned> adjacency(offset[nv]);
+            {
+                std::vector<unsigned> fill(offset.begin(), offset.end() - 1);
+                for (unsigned t = 0; t < tris.size(); ++t)
+                    for (unsigned v: tris[t]) adjacency[fill[v]++] = t;
+            }
+
+            std::vector<int> stamp(nv, 0);
+            std::vector<char> emitted(tris.size(), 0);
+            std::vector<unsigned> dead_end, order, candidates;
+            order.reserve(tris.size());
+            int time = cache + 1;
+            size_t cursor = 0;
+            long long fan = nv ? 0 : -1;
+
+            while (fan >= 0) {
+                // 1) emit every remaining triangle around the fanning vertex
+                candidates.clear();
+                for (unsigned k = offset[fan]; k < offset[fan + 1]; ++k) {
+                    const unsigned t = adjacency[k];
+                    if (emitted[t]) continue;
+                    for (unsigned v: tris[t]) {
+                        dead_end.push_back(v);
+                        candidates.push_back(v);
+                        --live[v];
+                        if (time - stamp[v] > cache) stamp[v] = time++;
+                    }
+                    emitted[t] = 1;
+                    order.push_back(t);
+                }
+
+                // 2) next fan: the candidate still in cache with the most use left
+                long long best = -1;
+                int best_priority = -1;
+                for (unsigned v: candidates) {
+                    if (live[v] == 0) continue;
+                    int priority = 0;
+                    if (time - stamp[v] + 2 * static_cast<int>(live[v]) <= cache)
+                        priority = time - stamp[v];
+                    if (priority > best_priority) {
+                        best_priority = priority;
+                        best = v;
+                    }
+                }
+
+                // 3) dead end: recently touched vertices first, then scan forward
+                while (best < 0 && !dead_end.empty()) {
+                    const unsigned v = dead_end.back();
+                    dead_end.pop_back();
+                    if (live[v] > 0) best = v;
+                }
+                while (best < 0 && cursor < nv) {
+                    if (live[cursor] > 0) best = static_cast<long long>(cursor);
+                    ++cursor;
+                }
+                fan = best;
+            }
+            return order;
+        }
+
+        template<typename T>
+        void put(std::vector<char> &buf, size_t at, T v) {
+            std::memcpy(buf.data() + at, &v, sizeof(T));
+        }
+    }
+
+    // — glTF binary —
+    void triMesh::save_glb(const std::string &fn, bool reorder_for_gpu_cache) const {
+        std::ofstream out(fn, std::ios::binary);
+        if (!out) {
+            std::cerr << "Can't open " << fn << std::endl;
+            return;
+        }
+        write_glb(out, reorder_for_gpu_cache);
+    }
+
+    void triMesh::write_glb(std::ostream &out, bool reorder_for_gpu_cache) const {
+        // 1) dense rows for vertices and index triangles
+        std::vector<unsigned> row(next_vertex_handle_, 0);
+        for (size_t i = 0; i < vertices_.size(); ++i)
+            row[vertices_[i]->get_handle()] = static_cast<unsigned>(i);
+        std::vector<std::array<unsigned, 3> > tris;
+        tris.reserve(faces_.size());
+        for (auto &f: faces_) {
+            auto [a,b,c] = f->get_vertices();
+            tris.push_back({row[a->get_handle()], row[b->get_handle()], row[c->get_handle()]});
+        }
+
+        // 2) area weighted vertex normals (un-normalised face normals summed)
+        const size_t nv = vertices_.size();
+        std::vector<Eigen::Vector3d> normals(nv, Eigen::Vector3d::Zero());
+        for (auto &t: tris) {
+            const Eigen::Vector3d p0 = vertices_[t[0]]->get_position();
+            const Eigen::Vector3d n = (vertices_[t[1]]->get_position() - p0)
+                    .cross(vertices_[t[2]]->get_position() - p0);
+            for (unsigned v: t) normals[v] += n;
+        }
+
+        // 3) optionally reorder triangles for the post-transform cache and
+        //    renumber vertices by first use for the pre-transform fetch
+        std::vector<unsigned> vertex_order(nv);
+        for (size_t i = 0; i < nv; ++i) vertex_order[i] = static_cast<unsigned>(i);
+        if (reorder_for_gpu_cache && !tris.empty()) {
+            const auto order = tipsify(tris, nv, kVertexCacheSize);
+            std::vector<std::array<unsigned, 3> > sorted;
+            sorted.reserve(tris.size());
+            for (unsigned t: order) sorted.push_back(tris[t]);
+            tris.swap(sorted);
+
+            constexpr unsigned unset = std::numeric_limits<unsigned>::max();
+            std::vector<unsigned> remap(nv, unset);
+            unsigned next = 0;
+            vertex_order.clear();
+            for (auto &t: tris)
+                for (unsigned &v: t) {
+                    if (remap[v] == unset) {
+                        remap[v] = next++;
+                        vertex_order.push_back(v);
+                    }
+                    v = remap[v];
+                }
+            // unreferenced vertices go last
+            for (size_t v = 0; v < nv; ++v)
+                if (remap[v] == unset) vertex_order.push_back(static_cast<unsigned>(v));
+        }
+
+        // 4) binary chunk: interleaved float32 position+normal, then uint32 indices
+        constexpr size_t stride = 6 * sizeof(float);
+        const size_t vertex_bytes = nv * stride;
+        const size_t index_bytes = tris.size() * 3 * sizeof(std::uint32_t);
+        std::vector<char> bin(vertex_bytes + index_bytes);
+        Eigen::Vector3f lo = Eigen::Vector3f::Constant(std::numeric_limits<float>::max());
+        Eigen::Vector3f hi = Eigen::Vector3f::Constant(std::numeric_limits<float>::lowest());
+        for (size_t i = 0; i < nv; ++i) {
+            const unsigned v = vertex_order[i];
+            const Eigen::Vector3f p = vertices_[v]->get_position().cast<float>();
+            Eigen::Vector3f n = normals[v].cast<float>();
+            const float len = n.norm();
+            n = len > 0 ? Eigen::Vector3f(n / len) : Eigen::Vector3f(0, 0, 1);
+            lo = lo.cwiseMin(p);
+            hi = hi.cwiseMax(p);
+            std::memcpy(bin.data() + i * stride, p.data(), 3 * sizeof(float));
+            std::memcpy(bin.data() + i * stride + 3 * sizeof(float), n.data(), 3 * sizeof(float));
+        }
+        for (size_t t = 0; t < tris.size(); ++t)
+            for (int k = 0; k < 3; ++k)
+                put(bin, vertex_bytes + (3 * t + k) * sizeof(std::uint32_t), static_cast<std::uint32_t>(tris[t][k]));
+
+        // 5) JSON chunk describing the buffer
+        nlohmann::json js;
+        js["asset"] = {{"version", "2.0"}, {"generator", "halfMesh"}};
+        if (nv > 0 && !tris.empty()) {
+            js["scene"] = 0;
+            js["scenes"] = nlohmann::json::array({{{"nodes", {0}}}});
+            js["nodes"] = nlohmann::json::array({{{"mesh", 0}}});
+            js["meshes"] = nlohmann::json::array({
+                {
+                    {
+                        "primitives", nlohmann::json::array({
+                            {{"attributes", {{"POSITION", 0}, {"NORMAL", 1}}}, {"indices", 2}, {"mode", 4}}
+                        })
+                    }
+                }
+            });
+            js["buffers"] = nlohmann::json::array({{{"byteLength", bin.size()}}});
+            js["bufferViews"] = nlohmann::json::array({
+                {
+                    {"buffer", 0}, {"byteOffset", 0}, {"byteLength", vertex_bytes},
+                    {"byteStride", stride}, {"target", kArrayBuffer}
+                },
+                {
+                    {"buffer", 0}, {"byteOffset", vertex_bytes}, {"byteLength", index_bytes},
+                    {"target", kElementArrayBuffer}
+                }
+            });
+            js["accessors"] = nlohmann::json::array({
+                {
+                    {"bufferView", 0}, {"byteOffset", 0}, {"componentType", kFloat}, {"count", nv},
+                    {"type", "VEC3"}, {"min", {lo.x(), lo.y(), lo.z()}}, {"max", {hi.x(), hi.y(), hi.z()}}
+                },
+                {
+                    {"bufferView", 0}, {"byteOffset", 3 * sizeof(float)}, {"componentType", kFloat},
+                    {"count", nv}, {"type", "VEC3"}
+                },
+                {
+                    {"bufferView", 1}, {"byteOffset", 0}, {"componentType", kUnsignedInt},
+                    {"count", 3 * tris.size()}, {"type", "SCALAR"}
+                }
+            });
+        } else {
+            bin.clear();
+        }
+
+        std::string json = js.dump();
+        json.resize((json.size() + 3) & ~size_t(3), ' ');
+        bin.resize((bin.size() + 3) & ~size_t(3), 0);
+
+        // 6) header, JSON chunk, BIN chunk
+        const auto write_u32 = [&out](std::uint32_t v) { out.write(reinterpret_cast<const char *>(&v), 4); };
+        const size_t total = 12 + 8 + json.size() + (bin.empty() ? 0 : 8 + bin.size());
+        write_u32(kGlbMagic);
+        write_u32(kGlbVersion);
+        write_u32(static_cast<std::uint32_t>(total));
+        write_u32(static_cast<std::uint32_t>(json.size()));
+        write_u32(kChunkJson);
+        out.write(json.data(), static_cast<std::streamsize>(json.size()));
+        if (!bin.empty()) {
+            write_u32(static_cast<std::uint32_t>(bin.size()));
+            write_u32(kChunkBin);
+            out.write(bin.data(), static_cast<std::streamsize>(bin.size()));
+        }
+    }
+} // namespace halfMesh
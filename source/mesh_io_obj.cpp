@@ -0,0 +1,260 @@
+#include "triMesh.hpp"
+#include "parse_utilities.hpp"
+#include "task_scheduler.hpp"
+#include <limits>
+#include <stdexcept>
+
+namespace halfMesh {
+    using namespace detail;
+
+    namespace {
+        // Chunks smaller than this are not worth a thread of their own
+        constexpr size_t kMinChunkBytes = 1u << 20;
+
+        // Relative-index flags on an obj_corner
+        constexpr unsigned char kRelV = 1, kRelVt = 2, kRelVn = 4;
+        constexpr long long kNoIndex = std::numeric_limits<long long>::min();
+
+        // One polygon corner as written in the file. Indices are zero based;
+        // negative OBJ indices are stored relative to the start of the chunk
+        // and flagged, so they can be resolved once every chunk is parsed.
+        struct obj_corner {
+            long long v = kNoIndex, vt = kNoIndex, vn = kNoIndex;
+            unsigned char relative = 0;
+        };
+
+        struct obj_chunk {
+            std::vector<double> positions; // xyz
+            std::vector<double> texcoords; // uv
+            std::vector<double> normals; // xyz
+            std::vector<obj_corner> corners;
+            std::vector<unsigned> polygon_sizes;
+            bool bad_index = false;
+        };
+
+        // Turn a one based (or negative) OBJ index into our encoding
+        inline bool resolve_local(long long idx, size_t count, unsigned char flag,
+                                  long long &out, unsigned char &relative) {
+            if (idx > 0) {
+                out = idx - 1;
+            } else if (idx < 0) {
+                out = static_cast<long long>(count) + idx;
+                relative |= flag;
+            } else {
+                return false;
+            }
+            return true;
+        }
+
+        void parse_face(const char *p, const char *end, obj_chunk &chunk) {
+            unsigned n = 0;
+            const size_t nv = chunk.positions.size() / 3;
+            const size_t nt = chunk.texcoords.size() / 2;
+            const size_t nn = chunk.normals.size() / 3;
+            while (true) {
+                skip_blanks(p, end);
+                if (p >= end || *p == '#') break;
+
+                obj_corner c;
+                long long idx;
+                if (!parse_integer(p, end, idx) || !resolve_local(idx, nv, kRelV, c.v, c.relative)) {
+                    chunk.bad_index = true;
+                    break;
+                }
+                if (p < end && *p == '/') {
+                    ++p;
+                    // v//vn has no texture index
+                    if (p < end && *p != '/') {
+                        if (!parse_integer(p, end, idx) || !resolve_local(idx, nt, kRelVt, c.vt, c.relative)) {
+                            chunk.bad_index = true;
+                            break;
+                        }
+                    }
+                    if (p < end && *p == '/') {
+                        ++p;
+                        if (!parse_integer(p, end, idx) || !resolve_local(idx, nn, kRelVn, c.vn, c.relative)) {
+                            chunk.bad_index = true;
+                            break;
+                        }
+                    }
+                }
+                chunk.corners.push_back(c);
+                ++n;
+            }
+            if (chunk.bad_index) {
+                chunk.corners.resize(chunk.corners.size() - n);
+                return;
+            }
+            if (n >= 3) {
+                chunk.polygon_sizes.push_back(n);
+            } else {
+                // lines and points are not faces
+                chunk.corners.resize(chunk.corners.size() - n);
+            }
+        }
+
+        void parse_chunk(const char *p, const char *end, obj_chunk &chunk) {
+            while (p < end) {
+                const char *eol = find_eol(p, end);
+                skip_blanks(p, eol);
+
+                if (eol - p >= 2 && p[0] == 'v' && is_blank(p[1])) {
+                    double x = 0, y = 0, z = 0;
+                    const char *q = p + 1;
+                    if (parse_double(q, eol, x) && parse_double(q, eol, y) && parse_double(q, eol, z)) {
+                        chunk.positions.insert(chunk.positions.end(), {x, y, z});
+                    }
+                } else if (eol - p >= 3 && p[0] == 'v' && p[1] == 't' && is_blank(p[2])) {
+                    double u = 0, v = 0;
+                    const char *q = p + 2;
+                    if (parse_double(q, eol, u)) {
+                        // v is optional for 1D textures
+                        parse_double(q, eol, v);
+                        chunk.texcoords.insert(chunk.texcoords.end(), {u, v});
+                    }
+                } else if (eol - p >= 3 && p[0] == 'v' && p[1] == 'n' && is_blank(p[2])) {
+                    double x = 0, y = 0, z = 0;
+                    const char *q = p + 2;
+                    if (parse_double(q, eol, x) && parse_double(q, eol, y) && parse_double(q, eol, z)) {
+                        chunk.normals.insert(chunk.normals.end(), {x, y, z});
+                    }
+                } else if (eol - p >= 2 && p[0] == 'f' && is_blank(p[1])) {
+                    parse_face(p + 1, eol, chunk);
+                }
+                // everything else (o, g, s, usemtl, mtllib, comments) is ignored
+
+                p = eol + 1;
+            }
+        }
+
+        // Split [data, data+size) into line aligned ranges
+        std::vector<std::pair<const char *, const char *> >
+        split_lines(const char *data, size_t size, size_t parts) {
+            std::vector<std::pair<const char *, const char *> > ranges;
+            const char *end = data + size;
+            const char *begin = data;
+            for (size_t i = 1; i <= parts && begin < end; ++i) {
+                const char *cut = (i == parts) ? end : data + size * i / parts;
+                if (cut < begin) cut = begin;
+                if (cut < end) {
+                    const char *eol = find_eol(cut, end);
+                    cut = eol < end ? eol + 1 : end;
+                }
+                ranges.emplace_back(begin, cut);
+                begin = cut;
+            }
+            return ranges;
+        }
+    }
+
+    // — OBJ —
+    void triMesh::read_obj(const char *data, std::size_t size) {
+        // 1) parse line aligned chunks in parallel
+        size_t parts = size / kMinChunkBytes + 1;
+        parts = std::min<size_t>(parts, 4 * num_threads());
+        const auto ranges = split_lines(data, size, parts);
+        std::vector<obj_chunk> chunks(ranges.size());
+        parallel_for(0, ranges.size(), [&](size_t i) {
+            parse_chunk(ranges[i].first, ranges[i].second, chunks[i]);
+        }, 1);
+
+        // 2) prefix sums give every chunk its global element offsets
+        std::vector<size_t> v_base(chunks.size()), vt_base(chunks.size()), vn_base(chunks.size());
+        size_t nv = 0, nt = 0, nn = 0, ncorners = 0, npolys = 0;
+        for (size_t i = 0; i < chunks.size(); ++i) {
+            if (chunks[i].bad_index)
+                throw std::runtime_error("Malformed face index in OBJ file");
+            v_base[i] = nv;
+            vt_base[i] = nt;
+            vn_base[i] = nn;
+            nv += chunks[i].positions.size() / 3;
+            nt += chunks[i].texcoords.size() / 2;
+            nn += chunks[i].normals.size() / 3;
+            ncorners += chunks[i].corners.size();
+            npolys += chunks[i].polygon_sizes.size();
+        }
+
+        std::vector<std::array<double, 3> > positions;
+        positions.reserve(nv);
+        for (auto &c: chunks)
+            for (size_t k = 0; k + 2 < c.positions.size(); k += 3)
+                positions.push_back({c.positions[k], c.positions[k + 1], c.positions[k + 2]});
+
+        // 3) resolve indices and fan-triangulate polygons
+        const auto resolve = [](long long idx, bool relative, size_t base, size_t count) -> long long {
+            if (idx == kNoIndex) return -1;
+            if (relative) idx += static_cast<long long>(base);
+            if (idx < 0 || idx >= static_cast<long long>(count))
+                throw std::runtime_error("OBJ face index out of range");
+            return idx;
+        };
+
+        std::vector<std::array<unsigned, 3> > triangles;
+        std::vector<std::array<long long, 3> > tri_vt, tri_vn;
+        triangles.reserve(ncorners - 2 * npolys);
+        bool has_vt = false, has_vn = false;
+        std::vector<std::array<long long, 3> > corner;
+        for (size_t i = 0; i < chunks.size(); ++i) {
+            const auto &c = chunks[i];
+            size_t first = 0;
+            for (const unsigned n: c.polygon_sizes) {
+                corner.resize(n);
+                for (unsigned k = 0; k < n; ++k) {
+                    const auto &oc = c.corners[first + k];
+                    corner[k] = {
+                        resolve(oc.v, oc.relative & kRelV, v_base[i], nv),
+                        resolve(oc.vt, oc.relative & kRelVt, vt_base[i], nt),
+                        resolve(oc.vn, oc.relative & kRelVn, vn_base[i], nn)
+                    };
+                    has_vt |= corner[k][1] >= 0;
+                    has_vn |= corner[k][2] >= 0;
+                }
+                for (unsigned k = 1; k + 1 < n; ++k) {
+                    triangles.push_back({
+                        static_cast<unsigned>(corner[0][0]),
+                        static_cast<unsigned>(corner[k][0]),
+                        static_cast<unsigned>(corner[k + 1][0])
+                    });
+                    tri_vt.push_back({corner[0][1], corner[k][1], corner[k + 1][1]});
+                    tri_vn.push_back({corner[0][2], corner[k][2], corner[k + 1][2]});
+                }
+                first += n;
+            }
+        }
+
+        // 4) hand the soup to the bulk builder
+        build_from_arrays(positions, triangles);
+        if (!has_vt && !has_vn) return;
+
+        // 5) per-corner attributes live on the half-edge leaving that corner
+        std::vector<double> texcoords, normals;
+        texcoords.reserve(2 * nt);
+        normals.reserve(3 * nn);
+        for (auto &c: chunks) {
+            texcoords.insert(texcoords.end(), c.texcoords.begin(), c.texcoords.end());
+            normals.insert(normals.end(), c.normals.begin(), c.normals.end());
+        }
+
+        nlohmann::json uv_column = nlohmann::json::array();
+        nlohmann::json normal_column = nlohmann::json::array();
+        uv_column.get_ref<nlohmann::json::array_t &>().resize(next_half_edge_handle_);
+        normal_column.get_ref<nlohmann::json::array_t &>().resize(next_half_edge_handle_);
+
+        for (size_t t = 0; t < triangles.size(); ++t) {
+            const auto &tri = triangles[t];
+            const unsigned fh = find_face_handle(tri[0], tri[1], tri[2]);
+            if (fh == std::numeric_limits<unsigned>::max()) continue;
+            auto he = get_face(fh)->get_one_half_edge();
+            for (int k = 0; k < 3 && he; ++k, he = he->next()) {
+                const unsigned from = he->get_vertex_one()->get_handle();
+                const int j = (from == tri[0]) ? 0 : (from == tri[1]) ? 1 : 2;
+                if (const auto vt = tri_vt[t][j]; vt >= 0)
+                    uv_column[he->get_handle()] = {texcoords[2 * vt], texcoords[2 * vt + 1]};
+                if (const auto vn = tri_vn[t][j]; vn >= 0)
+                    normal_column[he->get_handle()] = {normals[3 * vn], normals[3 * vn + 1], normals[3 * vn + 2]};
+            }
+        }
+        if (has_vt) half_edge_data_store["texcoord"] = std::move(uv_column);
+        if (has_vn) half_edge_data_store["normal"] = std::move(normal_column);
+    }
+} // namespace halfMesh
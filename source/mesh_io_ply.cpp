@@ -0,0 +1,358 @@
+#include "triMesh.hpp"
+#include "parse_utilities.hpp"
+#include "ply_utilities.hpp"
+#include <cstdint>
+#include <ostream>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+
+namespace halfMesh {
+    using namespace detail;
+
+    namespace {
+        // Strided copy of one column out of fixed size binary records
+        template<typename T>
+        void gather_column(const char *base, size_t count, size_t stride, bool swap, double *out) {
+            for (size_t i = 0; i < count; ++i)
+                out[i] = static_cast<double>(load<T>(base + i * stride, swap));
+        }
+
+        void gather_column(ply_type t, const char *base, size_t count, size_t stride, bool swap, double *out) {
+            switch (t) {
+                case ply_type::Int8: gather_column<std::int8_t>(base, count, stride, swap, out); break;
+                case ply_type::UInt8: gather_column<std::uint8_t>(base, count, stride, swap, out); break;
+                case ply_type::Int16: gather_column<std::int16_t>(base, count, stride, swap, out); break;
+                case ply_type::UInt16: gather_column<std::uint16_t>(base, count, stride, swap, out); break;
+                case ply_type::Int32: gather_column<std::int32_t>(base, count, stride, swap, out); break;
+                case ply_type::UInt32: gather_column<std::uint32_t>(base, count, stride, swap, out); break;
+                case ply_type::Float32: gather_column<float>(base, count, stride, swap, out); break;
+                default: gather_column<double>(base, count, stride, swap, out); break;
+            }
+        }
+
+        //
+        // Sequential reader over the body, for ascii and binary alike
+        //
+        class ply_cursor {
+        public:
+            ply_cursor(const char *p, const char *end, ply_format f)
+                : p_(p), end_(end), ascii_(f == ply_format::Ascii),
+                  swap_((f == ply_format::BinaryLittleEndian) != host_is_little_endian()) {
+            }
+
+            double read(ply_type t) {
+                if (ascii_) {
+                    skip_spaces(p_, end_);
+                    double v;
+                    if (!parse_double(p_, end_, v))
+                        throw std::runtime_error("Malformed value in PLY body");
+                    return v;
+                }
+                const size_t n = ply_type_size(t);
+                if (static_cast<size_t>(end_ - p_) < n)
+                    throw std::runtime_error("Truncated PLY file");
+                const double v = load_scalar(t, p_, swap_);
+                p_ += n;
+                return v;
+            }
+
+            bool binary() const { return !ascii_; }
+            bool swap() const { return swap_; }
+            const char *position() const { return p_; }
+            size_t remaining() const { return static_cast<size_t>(end_ - p_); }
+            void advance(size_t n) { p_ += n; }
+
+        private:
+            const char *p_;
+            const char *end_;
+            bool ascii_;
+            bool swap_;
+        };
+
+        // A scalar property read into memory, before it becomes a typed column
+        struct ply_column {
+            std::string name;
+            ply_type type = ply_type::Float64;
+            std::vector<double> values;
+        };
+
+        // Bulk copy a column into the JSON store, keeping its integer/float kind
+        nlohmann::json to_json_column(const ply_column &c) {
+            if (is_float_type(c.type))
+                return c.values;
+            if (is_signed_type(c.type))
+                return std::vector<std::int64_t>(c.values.begin(), c.values.end());
+            return std::vector<std::uint64_t>(c.values.begin(), c.values.end());
+        }
+
+        void read_record(ply_cursor &cur, const ply_element &e, size_t row,
+                         std::vector<ply_column *> &columns, int list_index, std::vector<unsigned> &list) {
+            for (size_t k = 0; k < e.properties.size(); ++k) {
+                const auto &prop = e.properties[k];
+                if (prop.is_list) {
+                    const auto n = static_cast<size_t>(cur.read(prop.count_type));
+                    for (size_t j = 0; j < n; ++j) {
+                        const double v = cur.read(prop.type);
+                        if (static_cast<int>(k) == list_index) list.push_back(static_cast<unsigned>(v));
+                    }
+                } else {
+                    const double v = cur.read(prop.type);
+                    if (columns[k]) columns[k]->values[row] = v;
+                }
+            }
+        }
+
+        void skip_element(ply_cursor &cur, const ply_element &e) {
+            if (const size_t stride = e.fixed_stride(); cur.binary() && stride > 0) {
+                if (cur.remaining() < stride * e.count)
+                    throw std::runtime_error("Truncated PLY file");
+                cur.advance(stride * e.count);
+                return;
+            }
+            std::vector<ply_column *> none(e.properties.size(), nullptr);
+            std::vector<unsigned> unused;
+            for (size_t i = 0; i < e.count; ++i)
+                read_record(cur, e, i, none, -1, unused);
+        }
+
+        // Every scalar property of e becomes a column; slots maps property index to column
+        std::vector<ply_column> make_columns(const ply_element &e, std::vector<ply_column *> &slots) {
+            std::vector<ply_column> columns;
+            for (auto &prop: e.properties)
+                if (!prop.is_list)
+                    columns.push_back({prop.name, prop.type, std::vector<double>(e.count, 0.0)});
+            slots.assign(e.properties.size(), nullptr);
+            for (size_t k = 0; k < e.properties.size(); ++k)
+                for (auto &c: columns)
+                    if (!e.properties[k].is_list && c.name == e.properties[k].name) slots[k] = &c;
+            return columns;
+        }
+
+        // Pick the narrowest PLY type that holds every value of a JSON column
+        bool column_type(const nlohmann::json &column, const std::vector<unsigned> &handles, ply_type &type) {
+            bool any_float = false, any_negative = false, all_float32 = true;
+            double lo = 0.0, hi = 0.0;
+            for (const unsigned h: handles) {
+                if (h >= column.size()) continue;
+                const auto &v = column[h];
+                if (v.is_null()) continue;
+                if (!v.is_number() && !v.is_boolean()) return false;
+                const double d = v.is_boolean() ? (v.get<bool>() ? 1.0 : 0.0) : v.get<double>();
+                if (v.is_number_float()) {
+                    any_float = true;
+                    all_float32 &= static_cast<double>(static_cast<float>(d)) == d;
+                }
+                any_negative |= d < 0;
+                lo = std::min(lo, d);
+                hi = std::max(hi, d);
+            }
+            if (any_float) type = all_float32 ? ply_type::Float32 : ply_type::Float64;
+            else if (!any_negative && hi <= 255) type = ply_type::UInt8;
+            else if (!any_negative && hi <= 65535) type = ply_type::UInt16;
+            else if (!any_negative && hi <= std::numeric_limits<std::uint32_t>::max()) type = ply_type::UInt32;
+            else if (lo >= std::numeric_limits<std::int32_t>::min() && hi <= std::numeric_limits<std::int32_t>::max())
+                type = ply_type::Int32;
+            else type = ply_type::Float64;
+            return true;
+        }
+
+        struct ply_out_column {
+            std::string name;
+            ply_type type;
+            const nlohmann::json *values;
+        };
+
+        std::vector<ply_out_column> collect_columns(const nlohmann::json &store, const std::vector<unsigned> &handles,
+                                                    const std::vector<std::string> &reserved) {
+            std::vector<ply_out_column> out;
+            if (!store.is_object()) return out;
+            for (auto it = store.begin(); it != store.end(); ++it) {
+                if (!it.value().is_array()) continue;
+                std::string name = it.key();
+                std::replace(name.begin(), name.end(), ' ', '_');
+                if (std::find(reserved.begin(), reserved.end(), name) != reserved.end()) continue;
+                ply_type t;
+                if (column_type(it.value(), handles, t))
+                    out.push_back({name, t, &it.value()});
+            }
+            return out;
+        }
+
+        double column_value(const nlohmann::json &column, unsigned h) {
+            if (h >= column.size()) return 0.0;
+            const auto &v = column[h];
+            if (v.is_boolean()) return v.get<bool>() ? 1.0 : 0.0;
+            return v.is_number() ? v.get<double>() : 0.0;
+        }
+    }
+
+    // — PLY —
+    void triMesh::read_ply(const char *data, std::size_t size) {
+        const auto header = parse_ply_header(data, size);
+        ply_cursor cur(data + header.data_offset, data + size, header.format);
+
+        std::vector<std::array<double, 3> > positions;
+        std::vector<std::array<unsigned, 3> > triangles;
+        std::vector<size_t> triangle_source; // PLY face each triangle came from
+        std::vector<ply_column> vertex_columns, face_columns;
+
+        for (const auto &e: header.elements) {
+            std::vector<ply_column *> slots;
+            if (e.name == "vertex") {
+                const int ix = e.find("x"), iy = e.find("y"), iz = e.find("z");
+                if (ix < 0 || iy < 0 || iz < 0)
+                    throw std::runtime_error("PLY vertex element has no x/y/z");
+                vertex_columns = make_columns(e, slots);
+
+                if (const size_t stride = e.fixed_stride(); cur.binary() && stride > 0) {
+                    // fixed size records: strided bulk copy, one column at a time
+                    if (cur.remaining() < stride * e.count)
+                        throw std::runtime_error("Truncated PLY file");
+                    size_t offset = 0;
+                    for (size_t k = 0; k < e.properties.size(); ++k) {
+                        gather_column(e.properties[k].type, cur.position() + offset, e.count, stride,
+                                      cur.swap(), slots[k]->values.data());
+                        offset += ply_type_size(e.properties[k].type);
+                    }
+                    cur.advance(stride * e.count);
+                } else {
+                    std::vector<unsigned> unused;
+                    for (size_t i = 0; i < e.count; ++i)
+                        read_record(cur, e, i, slots, -1, unused);
+                }
+
+                const auto &xs = slots[ix]->values, &ys = slots[iy]->values, &zs = slots[iz]->values;
+                positions.resize(e.count);
+                for (size_t i = 0; i < e.count; ++i)
+                    positions[i] = {xs[i], ys[i], zs[i]};
+                // positions are not properties
+                vertex_columns.erase(std::remove_if(vertex_columns.begin(), vertex_columns.end(),
+                                                    [](const ply_column &c) {
+                                                        return c.name == "x" || c.name == "y" || c.name == "z";
+                                                    }), vertex_columns.end());
+            } else if (e.name == "face") {
+                int il = e.find("vertex_indices");
+                if (il < 0) il = e.find("vertex_index");
+                if (il < 0 || !e.properties[il].is_list)
+                    throw std::runtime_error("PLY face element has no vertex_indices list");
+                face_columns = make_columns(e, slots);
+                triangles.reserve(e.count);
+                triangle_source.reserve(e.count);
+
+                const auto &lp = e.properties[il];
+                const bool fast = cur.binary() && e.properties.size() == 1 && lp.count_type == ply_type::UInt8
+                                  && (lp.type == ply_type::Int32 || lp.type == ply_type::UInt32);
+                std::vector<unsigned> poly;
+                for (size_t i = 0; i < e.count; ++i) {
+                    // fast path: the usual "3 i j k" record decoded with direct loads
+                    if (fast && cur.remaining() >= 13 && static_cast<unsigned char>(cur.position()[0]) == 3) {
+                        const char *r = cur.position() + 1;
+                        triangles.push_back({
+                            load<std::uint32_t>(r, cur.swap()),
+                            load<std::uint32_t>(r + 4, cur.swap()),
+                            load<std::uint32_t>(r + 8, cur.swap())
+                        });
+                        triangle_source.push_back(i);
+                        cur.advance(13);
+                        continue;
+                    }
+                    poly.clear();
+                    read_record(cur, e, i, slots, il, poly);
+                    for (size_t k = 1; k + 1 < poly.size(); ++k) {
+                        triangles.push_back({poly[0], poly[k], poly[k + 1]});
+                        triangle_source.push_back(i);
+                    }
+                }
+            } else {
+                skip_element(cur, e);
+            }
+        }
+
+        build_from_arrays(positions, triangles);
+
+        // vertex handles are the PLY row numbers, so columns copy across as they are
+        for (auto &c: vertex_columns)
+            vertex_data_store[c.name] = to_json_column(c);
+
+        // face handles follow the triangles that survived the build
+        if (!face_columns.empty()) {
+            std::vector<unsigned> face_of(triangles.size());
+            for (size_t t = 0; t < triangles.size(); ++t)
+                face_of[t] = find_face_handle(triangles[t][0], triangles[t][1], triangles[t][2]);
+            for (auto &c: face_columns) {
+                ply_column per_face{c.name, c.type, std::vector<double>(next_face_handle_, 0.0)};
+                for (size_t t = 0; t < triangles.size(); ++t)
+                    if (face_of[t] != std::numeric_limits<unsigned>::max())
+                        per_face.values[face_of[t]] = c.values[triangle_source[t]];
+                face_data_store[c.name] = to_json_column(per_face);
+            }
+        }
+    }
+
+    void triMesh::write_ply(std::ostream &out) const {
+        // 1) dense row numbers for (possibly sparse) vertex handles
+        std::vector<unsigned> vertex_handles, face_handles;
+        vertex_handles.reserve(vertices_.size());
+        face_handles.reserve(faces_.size());
+        std::vector<unsigned> row(next_vertex_handle_, 0);
+        for (size_t i = 0; i < vertices_.size(); ++i) {
+            vertex_handles.push_back(vertices_[i]->get_handle());
+            row[vertices_[i]->get_handle()] = static_cast<unsigned>(i);
+        }
+        for (auto &f: faces_)
+            face_handles.push_back(f->get_handle());
+
+        // 2) every scalar numeric property becomes a typed PLY property
+        const auto vcols = collect_columns(vertex_data_store, vertex_handles, {"x", "y", "z"});
+        const auto fcols = collect_columns(face_data_store, face_handles, {"vertex_indices"});
+
+        out << "ply\nformat binary_little_endian 1.0\ncomment halfMesh\n";
+        out << "element vertex " << vertices_.size() << "\n";
+        out << "property double x\nproperty double y\nproperty double z\n";
+        for (auto &c: vcols)
+            out << "property " << ply_type_name(c.type) << " " << c.name << "\n";
+        out << "element face " << faces_.size() << "\n";
+        out << "property list uchar uint vertex_indices\n";
+        for (auto &c: fcols)
+            out << "property " << ply_type_name(c.type) << " " << c.name << "\n";
+        out << "end_header\n";
+
+        // 3) fixed size records, assembled in one buffer per element
+        const bool swap = !host_is_little_endian();
+        size_t vstride = 3 * sizeof(double);
+        for (auto &c: vcols) vstride += ply_type_size(c.type);
+        std::vector<char> buf(vstride * vertices_.size());
+        for (size_t i = 0; i < vertices_.size(); ++i) {
+            char *r = buf.data() + i * vstride;
+            const auto &v = vertices_[i];
+            store(r, v->get_x(), swap);
+            store(r + 8, v->get_y(), swap);
+            store(r + 16, v->get_z(), swap);
+            r += 24;
+            for (auto &c: vcols) {
+                store_scalar(c.type, r, column_value(*c.values, v->get_handle()), swap);
+                r += ply_type_size(c.type);
+            }
+        }
+        out.write(buf.data(), static_cast<std::streamsize>(buf.size()));
+
+        size_t fstride = 1 + 3 * sizeof(std::uint32_t);
+        for (auto &c: fcols) fstride += ply_type_size(c.type);
+        buf.assign(fstride * faces_.size(), 0);
+        for (size_t i = 0; i < faces_.size(); ++i) {
+            char *r = buf.data() + i * fstride;
+            auto [a,b,c] = faces_[i]->get_vertices();
+            r[0] = 3;
+            store(r + 1, static_cast<std::uint32_t>(row[a->get_handle()]), swap);
+            store(r + 5, static_cast<std::uint32_t>(row[b->get_handle()]), swap);
+            store(r + 9, static_cast<std::uint32_t>(row[c->get_handle()]), swap);
+            r += 13;
+            for (auto &col: fcols) {
+                store_scalar(col.type, r, column_value(*col.values, faces_[i]->get_handle()), swap);
+                r += ply_type_size(col.type);
+            }
+        }
+        out.write(buf.data(), static_cast<std::streamsize>(buf.size()));
+    }
+} // namespace halfMesh
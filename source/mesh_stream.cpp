@@ -0,0 +1,1175 @@
+#include "mesh_stream.hpp"
+#include "parse_utilities.hpp"
+#include "ply_utilities.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace halfMesh {
+    using namespace detail;
+
+    namespace {
+        // Read and write block size
+        constexpr std::size_t kBlockBytes = 1u << 20;
+
+        // Width reserved for element counts that are only known at the end
+        constexpr int kCountWidth = 20;
+
+        using Position = std::array<double, 3>;
+        using Triangle = std::array<std::uint64_t, 3>;
+
+        //
+        // Reads a file in fixed size blocks. ensure() makes a number of
+        // unread bytes contiguous, growing the buffer when it has to.
+        //
+        class block_reader {
+        public:
+            explicit block_reader(std::ifstream &in) : in_(in), buffer_(kBlockBytes) {
+            }
+
+            // Make n unread bytes available; false if the file ends first
+            bool ensure(std::size_t n) {
+                if (len_ - pos_ >= n) return true;
+                const std::size_t tail = len_ - pos_;
+                std::memmove(buffer_.data(), buffer_.data() + pos_, tail);
+                len_ = tail;
+                pos_ = 0;
+                if (buffer_.size() < n) buffer_.resize(std::max(n, 2 * buffer_.size()));
+                while (len_ < n && !eof_) {
+                    in_.read(buffer_.data() + len_, static_cast<std::streamsize>(buffer_.size() - len_));
+                    const auto got = static_cast<std::size_t>(in_.gcount());
+                    len_ += got;
+                    bytes_ += got;
+                    if (!in_ || got == 0) eof_ = true;
+                }
+                return len_ >= n;
+            }
+
+            const char *begin() const { return buffer_.data() + pos_; }
+            const char *end() const { return buffer_.data() + len_; }
+            std::size_t available() const { return len_ - pos_; }
+            void consume(std::size_t n) { pos_ += n; }
+            std::uintmax_t bytes_read() const { return bytes_; }
+
+        private:
+            std::ifstream &in_;
+            std::vector<char> buffer_;
+            std::size_t pos_ = 0, len_ = 0;
+            std::uintmax_t bytes_ = 0;
+            bool eof_ = false;
+        };
+
+        // Hands out one line at a time, without its '\n'
+        class line_reader {
+        public:
+            explicit line_reader(std::ifstream &in) : blocks_(in) {
+            }
+
+            // The line stays valid until the next call; false at end of file
+            bool next(const char *&begin, const char *&end) {
+                std::size_t scanned = 0;
+                while (true) {
+                    const char *p = blocks_.begin();
+                    const std::size_t n = blocks_.available();
+                    if (const auto *eol = static_cast<const char *>(std::memchr(p + scanned, '\n', n - scanned))) {
+                        begin = p;
+                        end = eol;
+                        blocks_.consume(static_cast<std::size_t>(eol - p) + 1);
+                        return true;
+                    }
+                    scanned = n;
+                    if (!blocks_.ensure(n + 1)) {
+                        if (n == 0) return false;
+                        // last line without a newline
+                        begin = blocks_.begin();
+                        end = blocks_.end();
+                        blocks_.consume(n);
+                        return true;
+                    }
+                }
+            }
+
+            std::uintmax_t bytes_read() const { return blocks_.bytes_read(); }
+
+        private:
+            block_reader blocks_;
+        };
+
+        // STL corners are not shared: corner k of triangle t is vertex 3t+k
+        void number_corners(TriangleChunk &chunk) {
+            chunk.indices.resize(chunk.positions.size() / 3);
+            for (std::size_t t = 0; t < chunk.indices.size(); ++t) {
+                const std::uint64_t first = 3 * (chunk.first_triangle + t);
+                chunk.indices[t] = {first, first + 1, first + 2};
+            }
+        }
+
+        std::ifstream open_input(const std::string &filename) {
+            std::ifstream in(filename, std::ios::binary);
+            if (!in) throw std::runtime_error("Could not open " + filename);
+            return in;
+        }
+
+        // — STL sources —
+        class stl_binary_source : public triangle_source {
+        public:
+            stl_binary_source(const std::string &filename, std::uintmax_t file_size)
+                : in_(open_input(filename)) {
+                char header[84];
+                if (!in_.read(header, sizeof(header)))
+                    throw std::runtime_error("Truncated binary STL " + filename);
+                std::uint32_t count;
+                std::memcpy(&count, header + 80, sizeof(count));
+                remaining_ = std::min<std::uint64_t>(count, (file_size - 84) / 50);
+            }
+
+            bool next(TriangleChunk &chunk, std::size_t max_triangles) override {
+                const std::size_t n = static_cast<std::size_t>(std::min<std::uint64_t>(remaining_, max_triangles));
+                chunk.positions.clear();
+                chunk.indices.clear();
+                chunk.first_triangle = next_triangle_;
+                if (n == 0) return false;
+
+                buffer_.resize(n * 50);
+                if (!in_.read(buffer_.data(), static_cast<std::streamsize>(buffer_.size())))
+                    throw std::runtime_error("Truncated binary STL");
+                chunk.positions.resize(3 * n);
+                for (std::size_t t = 0; t < n; ++t) {
+                    const char *rec = buffer_.data() + 50 * t + 12; // skip the normal
+                    for (int k = 0; k < 3; ++k) {
+                        float xyz[3];
+                        std::memcpy(xyz, rec + 12 * k, sizeof(xyz));
+                        chunk.positions[3 * t + k] = {xyz[0], xyz[1], xyz[2]};
+                    }
+                }
+                number_corners(chunk);
+                remaining_ -= n;
+                next_triangle_ += n;
+                bytes_ += buffer_.size();
+                return true;
+            }
+
+            bool single_precision() const override { return true; }
+
+            std::uintmax_t bytes_read() const override { return bytes_; }
+
+        private:
+            std::ifstream in_;
+            std::vector<char> buffer_;
+            std::uint64_t remaining_ = 0, next_triangle_ = 0;
+            std::uintmax_t bytes_ = 84;
+        };
+
+        class stl_ascii_source : public triangle_source {
+        public:
+            explicit stl_ascii_source(const std::string &filename)
+                : in_(open_input(filename)), lines_(in_) {
+            }
+
+            bool next(TriangleChunk &chunk, std::size_t max_triangles) override {
+                chunk.positions.clear();
+                chunk.first_triangle = next_triangle_;
+                const std::size_t limit = 3 * std::max<std::size_t>(max_triangles, 1);
+                const char *p, *eol;
+                while (chunk.positions.size() < limit && lines_.next(p, eol)) {
+                    skip_blanks(p, eol);
+                    if (eol - p < 7 || std::memcmp(p, "vertex", 6) != 0 || !is_blank(p[6])) continue;
+                    p += 6;
+                    Position v;
+                    if (parse_double(p, eol, v[0]) && parse_double(p, eol, v[1]) && parse_double(p, eol, v[2]))
+                        chunk.positions.push_back(v);
+                }
+                // a dangling facet at the end of the file is dropped
+                chunk.positions.resize(chunk.positions.size() - chunk.positions.size() % 3);
+                number_corners(chunk);
+                next_triangle_ += chunk.size();
+                return !chunk.positions.empty();
+            }
+
+            std::uintmax_t bytes_read() const override { return lines_.bytes_read(); }
+
+        private:
+            std::ifstream in_;
+            line_reader lines_;
+            std::uint64_t next_triangle_ = 0;
+        };
+
+        std::unique_ptr<triangle_source> open_stl(const std::string &filename, std::uintmax_t size) {
+            // same rule as triMesh::read_stl: the size decides, then the "solid" keyword
+            char head[84] = {};
+            {
+                std::ifstream in = open_input(filename);
+                in.read(head, sizeof(head));
+            }
+            if (size >= 84) {
+                std::uint32_t count;
+                std::memcpy(&count, head + 80, sizeof(count));
+                if (84 + 50 * static_cast<std::uintmax_t>(count) == size)
+                    return std::make_unique<stl_binary_source>(filename, size);
+            }
+            const char *p = head, *end = head + std::min<std::uintmax_t>(size, sizeof(head));
+            skip_spaces(p, end);
+            if (end - p >= 5 && std::memcmp(p, "solid", 5) == 0)
+                return std::make_unique<stl_ascii_source>(filename);
+            if (size < 84) throw std::runtime_error("Truncated binary STL " + filename);
+            return std::make_unique<stl_binary_source>(filename, size);
+        }
+
+        //
+        // Base for formats with a vertex table: vertices are kept as flat
+        // positions, faces are parsed a batch at a time into pending
+        // triangles and handed out in chunks.
+        //
+        class indexed_source : public triangle_source {
+        public:
+            bool shared_vertices() const override { return true; }
+
+            bool next(TriangleChunk &chunk, std::size_t max_triangles) override {
+                max_triangles = std::max<std::size_t>(max_triangles, 1);
+                while (pending_.size() - taken_ < max_triangles && parse_more()) {
+                }
+                const std::size_t n = std::min(max_triangles, pending_.size() - taken_);
+                chunk.first_triangle = next_triangle_;
+                chunk.indices.assign(pending_.begin() + taken_, pending_.begin() + taken_ + n);
+                chunk.positions.resize(3 * n);
+                for (std::size_t t = 0; t < n; ++t)
+                    for (int k = 0; k < 3; ++k)
+                        chunk.positions[3 * t + k] = vertices_[chunk.indices[t][k]];
+                taken_ += n;
+                next_triangle_ += n;
+                if (taken_ == pending_.size()) {
+                    pending_.clear();
+                    taken_ = 0;
+                }
+                return n > 0;
+            }
+
+        protected:
+            // Parse at least one more batch of the file; false once nothing is left
+            virtual bool parse_more() = 0;
+
+            // Fan triangulate a polygon of zero based vertex indices
+            void add_polygon(const std::vector<std::uint64_t> &corners) {
+                for (auto i: corners)
+                    if (i >= vertices_.size())
+                        throw std::runtime_error("Face index out of range");
+                for (std::size_t k = 1; k + 1 < corners.size(); ++k)
+                    pending_.push_back({corners[0], corners[k], corners[k + 1]});
+            }
+
+            // Faces parsed per parse_more() call
+            static constexpr std::size_t kFaceBatch = 4096;
+
+            std::vector<Position> vertices_;
+
+        private:
+            std::vector<Triangle> pending_;
+            std::size_t taken_ = 0;
+            std::uint64_t next_triangle_ = 0;
+        };
+
+        // — OBJ source —
+        class obj_source : public indexed_source {
+        public:
+            explicit obj_source(const std::string &filename)
+                : in_(open_input(filename)), lines_(in_) {
+            }
+
+            std::uintmax_t bytes_read() const override { return lines_.bytes_read(); }
+
+        protected:
+            bool parse_more() override {
+                std::size_t faces = 0;
+                const char *p, *eol;
+                while (faces < kFaceBatch) {
+                    if (!lines_.next(p, eol)) return faces > 0;
+                    skip_blanks(p, eol);
+                    if (eol - p >= 2 && p[0] == 'v' && is_blank(p[1])) {
+                        Position v;
+                        ++p;
+                        if (parse_double(p, eol, v[0]) && parse_double(p, eol, v[1]) && parse_double(p, eol, v[2]))
+                            vertices_.push_back(v);
+                    } else if (eol - p >= 2 && p[0] == 'f' && is_blank(p[1])) {
+                        parse_face(p + 1, eol);
+                        ++faces;
+                    }
+                    // texture coordinates, normals, groups and materials are not streamed
+                }
+                return true;
+            }
+
+        private:
+            void parse_face(const char *p, const char *eol) {
+                corners_.clear();
+                while (true) {
+                    skip_blanks(p, eol);
+                    if (p >= eol || *p == '#') break;
+                    long long idx;
+                    if (!parse_integer(p, eol, idx) || idx == 0)
+                        throw std::runtime_error("Malformed face index in OBJ file");
+                    // negative indices count back from the latest vertex
+                    const long long v = idx > 0 ? idx - 1 : static_cast<long long>(vertices_.size()) + idx;
+                    if (v < 0) throw std::runtime_error("OBJ face index out of range");
+                    corners_.push_back(static_cast<std::uint64_t>(v));
+                    // the v/vt/vn tail is not needed
+                    while (p < eol && !is_blank(*p)) ++p;
+                }
+                add_polygon(corners_);
+            }
+
+            std::ifstream in_;
+            line_reader lines_;
+            std::vector<std::uint64_t> corners_;
+        };
+
+        // — GMSH source (version 2, ascii, triangles) —
+        class gmsh_source : public indexed_source {
+        public:
+            explicit gmsh_source(const std::string &filename)
+                : in_(open_input(filename)), lines_(in_) {
+            }
+
+            std::uintmax_t bytes_read() const override { return lines_.bytes_read(); }
+
+        protected:
+            bool parse_more() override {
+                std::size_t faces = 0;
+                const char *p, *eol;
+                while (faces < kFaceBatch) {
+                    if (!lines_.next(p, eol)) return faces > 0;
+                    skip_blanks(p, eol);
+                    if (p < eol && *p == '$') {
+                        const std::string tag(p, static_cast<std::size_t>(std::find_if(p, eol, is_space) - p));
+                        section_ = tag == "$MeshFormat" ? Section::Format
+                                   : tag == "$Nodes" ? Section::Nodes
+                                   : tag == "$Elements" ? Section::Elements
+                                   : Section::Other;
+                        count_line_ = section_ == Section::Nodes || section_ == Section::Elements;
+                        continue;
+                    }
+                    if (p >= eol) continue;
+                    if (count_line_) {
+                        count_line_ = false;
+                        continue;
+                    }
+                    if (section_ == Section::Format) {
+                        // version file-type data-size; file-type 1 is binary
+                        double version;
+                        int file_type = 0;
+                        if (parse_double(p, eol, version)) {
+                            skip_blanks(p, eol);
+                            if (parse_integer(p, eol, file_type) && file_type != 0)
+                                throw std::runtime_error("Binary GMSH files cannot be streamed");
+                        }
+                    } else if (section_ == Section::Nodes) {
+                        read_node(p, eol);
+                    } else if (section_ == Section::Elements) {
+                        faces += read_element(p, eol);
+                    }
+                }
+                return true;
+            }
+
+        private:
+            enum class Section { Other, Format, Nodes, Elements };
+
+            void read_node(const char *p, const char *eol) {
+                std::uint64_t id;
+                Position v;
+                if (!parse_integer(p, eol, id) || !parse_double(p, eol, v[0]) || !parse_double(p, eol, v[1])
+                    || !parse_double(p, eol, v[2]))
+                    throw std::runtime_error("Malformed GMSH node");
+                // node ids are usually 1..n; keep a map only once they are not
+                if (dense_ && id != vertices_.size() + 1) {
+                    dense_ = false;
+                    for (std::uint64_t i = 0; i < vertices_.size(); ++i) node_index_[i + 1] = i;
+                }
+                if (!dense_) node_index_[id] = vertices_.size();
+                vertices_.push_back(v);
+            }
+
+            bool read_element(const char *p, const char *eol) {
+                std::uint64_t fields[16];
+                int n = 0;
+                while (n < 16) {
+                    skip_blanks(p, eol);
+                    if (p >= eol || !parse_integer(p, eol, fields[n])) break;
+                    ++n;
+                }
+                // id, type, number of tags, tags..., nodes
+                if (n < 3 || fields[1] != 2) return false;
+                const auto first = 3 + fields[2];
+                if (first + 3 > static_cast<std::uint64_t>(n))
+                    throw std::runtime_error("Malformed GMSH element");
+                corners_.resize(3);
+                for (int k = 0; k < 3; ++k) corners_[k] = node(fields[first + k]);
+                add_polygon(corners_);
+                return true;
+            }
+
+            std::uint64_t node(std::uint64_t id) const {
+                if (dense_) {
+                    if (id == 0 || id > vertices_.size())
+                        throw std::runtime_error("GMSH element refers to an unknown node");
+                    return id - 1;
+                }
+                const auto it = node_index_.find(id);
+                if (it == node_index_.end())
+                    throw std::runtime_error("GMSH element refers to an unknown node");
+                return it->second;
+            }
+
+            std::ifstream in_;
+            line_reader lines_;
+            Section section_ = Section::Other;
+            bool count_line_ = false;
+            bool dense_ = true;
+            std::unordered_map<std::uint64_t, std::uint64_t> node_index_;
+            std::vector<std::uint64_t> corners_;
+        };
+
+        // — PLY source —
+        class ply_source : public indexed_source {
+        public:
+            explicit ply_source(const std::string &filename)
+                : in_(open_input(filename)), blocks_(in_) {
+                // 1) header, however long it is
+                static const std::string end_header = "end_header";
+                for (std::size_t want = 4096;; want *= 2) {
+                    const bool more = blocks_.ensure(want);
+                    if (std::search(blocks_.begin(), blocks_.end(), end_header.begin(), end_header.end())
+                        != blocks_.end() || !more)
+                        break;
+                }
+                header_ = parse_ply_header(blocks_.begin(), blocks_.available());
+                blocks_.consume(header_.data_offset);
+                ascii_ = header_.format == ply_format::Ascii;
+                swap_ = (header_.format == ply_format::BinaryLittleEndian) != host_is_little_endian();
+
+                // 2) vertices into the table, skipping elements up to the faces
+                bool have_vertices = false;
+                for (auto &e: header_.elements) {
+                    if (e.name == "vertex") {
+                        read_vertices(e);
+                        have_vertices = true;
+                    } else if (e.name == "face") {
+                        if (!have_vertices)
+                            throw std::runtime_error("PLY faces before vertices cannot be streamed");
+                        face_ = &e;
+                        list_ = e.find("vertex_indices");
+                        if (list_ < 0) list_ = e.find("vertex_index");
+                        if (list_ < 0 || !e.properties[list_].is_list)
+                            throw std::runtime_error("PLY face element has no vertex index list");
+                        break;
+                    } else {
+                        for (std::size_t i = 0; i < e.count; ++i) skip_record(e);
+                    }
+                }
+            }
+
+            std::uintmax_t bytes_read() const override { return blocks_.bytes_read(); }
+
+        protected:
+            bool parse_more() override {
+                if (!face_ || faces_read_ == face_->count) return false;
+                const std::size_t n = std::min<std::size_t>(kFaceBatch, face_->count - faces_read_);
+                for (std::size_t f = 0; f < n; ++f) {
+                    corners_.clear();
+                    for (std::size_t k = 0; k < face_->properties.size(); ++k) {
+                        const auto &prop = face_->properties[k];
+                        if (!prop.is_list) {
+                            read(prop.type);
+                            continue;
+                        }
+                        const auto count = static_cast<std::size_t>(read(prop.count_type));
+                        for (std::size_t j = 0; j < count; ++j) {
+                            const double v = read(prop.type);
+                            if (static_cast<int>(k) == list_) {
+                                if (v < 0) throw std::runtime_error("PLY face index out of range");
+                                corners_.push_back(static_cast<std::uint64_t>(v));
+                            }
+                        }
+                    }
+                    add_polygon(corners_);
+                }
+                faces_read_ += n;
+                return true;
+            }
+
+        private:
+            double read(ply_type t) {
+                if (ascii_) {
+                    while (blocks_.ensure(1)) {
+                        const char *p = blocks_.begin(), *q = p;
+                        skip_spaces(q, blocks_.end());
+                        blocks_.consume(static_cast<std::size_t>(q - p));
+                        if (q < blocks_.end()) break;
+                    }
+                    blocks_.ensure(64); // one token, as far as the file goes
+                    const char *p = blocks_.begin();
+                    double v;
+                    if (!parse_double(p, blocks_.end(), v))
+                        throw std::runtime_error("Malformed value in PLY body");
+                    blocks_.consume(static_cast<std::size_t>(p - blocks_.begin()));
+                    return v;
+                }
+                const std::size_t n = ply_type_size(t);
+                if (!blocks_.ensure(n)) throw std::runtime_error("Truncated PLY file");
+                const double v = load_scalar(t, blocks_.begin(), swap_);
+                blocks_.consume(n);
+                return v;
+            }
+
+            void skip_record(const ply_element &e) {
+                for (auto &prop: e.properties) {
+                    const std::size_t count = prop.is_list ? static_cast<std::size_t>(read(prop.count_type)) : 1;
+                    for (std::size_t j = 0; j < count; ++j) read(prop.type);
+                }
+            }
+
+            void read_vertices(const ply_element &e) {
+                const int ix = e.find("x"), iy = e.find("y"), iz = e.find("z");
+                if (ix < 0 || iy < 0 || iz < 0)
+                    throw std::runtime_error("PLY vertex element lacks x, y or z");
+                vertices_.reserve(e.count);
+
+                // binary records without lists: fixed offsets
+                if (const std::size_t stride = e.fixed_stride(); !ascii_ && stride > 0) {
+                    std::size_t offset[3] = {0, 0, 0};
+                    for (int k = 0, at = 0; k < static_cast<int>(e.properties.size()); ++k) {
+                        if (k == ix) offset[0] = at;
+                        if (k == iy) offset[1] = at;
+                        if (k == iz) offset[2] = at;
+                        at += static_cast<int>(ply_type_size(e.properties[k].type));
+                    }
+                    const ply_type type[3] = {e.properties[ix].type, e.properties[iy].type, e.properties[iz].type};
+                    for (std::size_t i = 0; i < e.count; ++i) {
+                        if (!blocks_.ensure(stride)) throw std::runtime_error("Truncated PLY file");
+                        const char *rec = blocks_.begin();
+                        vertices_.push_back({
+                            load_scalar(type[0], rec + offset[0], swap_),
+                            load_scalar(type[1], rec + offset[1], swap_),
+                            load_scalar(type[2], rec + offset[2], swap_)
+                        });
+                        blocks_.consume(stride);
+                    }
+                    return;
+                }
+
+                for (std::size_t i = 0; i < e.count; ++i) {
+                    Position v = {0, 0, 0};
+                    for (int k = 0; k < static_cast<int>(e.properties.size()); ++k) {
+                        const auto &prop = e.properties[k];
+                        const std::size_t count = prop.is_list ? static_cast<std::size_t>(read(prop.count_type)) : 1;
+                        for (std::size_t j = 0; j < count; ++j) {
+                            const double x = read(prop.type);
+                            if (prop.is_list) continue;
+                            if (k == ix) v[0] = x;
+                            else if (k == iy) v[1] = x;
+                            else if (k == iz) v[2] = x;
+                        }
+                    }
+                    vertices_.push_back(v);
+                }
+            }
+
+            std::ifstream in_;
+            block_reader blocks_;
+            ply_header header_;
+            bool ascii_ = true, swap_ = false;
+            const ply_element *face_ = nullptr;
+            int list_ = -1;
+            std::size_t faces_read_ = 0;
+            std::vector<std::uint64_t> corners_;
+        };
+
+        //
+        // Writers. Formats that need element counts before the elements get
+        // a fixed width placeholder which is patched once the stream ends;
+        // formats with faces after all vertices spill faces to a temporary
+        // file that is appended at the end.
+        //
+        class triangle_sink {
+        public:
+            virtual ~triangle_sink() = default;
+
+            // soup: the chunk as read; new_vertices: vertices first used by this
+            // chunk, numbered consecutively; triangles: indices into all vertices
+            virtual void write(const TriangleChunk &soup, const std::vector<Position> &new_vertices,
+                               const std::vector<Triangle> &triangles) = 0;
+
+            virtual void finish() = 0;
+        };
+
+        std::string padded_count(std::uint64_t n) {
+            std::string digits;
+            append_integer(digits, n);
+            return std::string(kCountWidth - std::min<std::size_t>(digits.size(), kCountWidth), ' ') + digits;
+        }
+
+        class output_file {
+        public:
+            explicit output_file(const std::string &filename) : out_(filename, std::ios::binary) {
+                if (!out_) throw std::runtime_error("Could not open " + filename);
+            }
+
+            void write(const std::string &text) {
+                out_.write(text.data(), static_cast<std::streamsize>(text.size()));
+            }
+
+            // Write a placeholder count and remember where it is
+            std::streampos reserve_count() {
+                const auto at = out_.tellp();
+                write(padded_count(0));
+                return at;
+            }
+
+            void patch_count(std::streampos at, std::uint64_t n) {
+                const auto end = out_.tellp();
+                out_.seekp(at);
+                write(padded_count(n));
+                out_.seekp(end);
+            }
+
+            void close() {
+                out_.close();
+                if (out_.fail()) throw std::runtime_error("Failed writing mesh");
+            }
+
+            std::ofstream &stream() { return out_; }
+
+        private:
+            std::ofstream out_;
+        };
+
+        // Conversion output written under a temporary name and renamed into
+        // place once complete; removed on destruction otherwise, so a failed
+        // conversion never leaves a truncated mesh behind
+        class partial_output {
+        public:
+            explicit partial_output(const std::string &output) : path_(output + ".tmp") {}
+
+            ~partial_output() {
+                if (path_.empty()) return;
+                std::error_code ec;
+                std::filesystem::remove(path_, ec);
+            }
+
+            const std::string &path() const { return path_; }
+
+            void commit(const std::string &output) {
+                std::error_code ec;
+                std::filesystem::rename(path_, output, ec);
+                if (ec) throw std::runtime_error("Could not write " + output + ": " + ec.message());
+                path_.clear();
+            }
+
+        private:
+            std::string path_;
+        };
+
+        // Temporary file next to the output, removed again on destruction
+        class spill_file {
+        public:
+            explicit spill_file(const std::string &output) : path_(output + ".faces.tmp") {
+                file_.open(path_, std::ios::in | std::ios::out | std::ios::trunc | std::ios::binary);
+                if (!file_) throw std::runtime_error("Could not open " + path_);
+            }
+
+            ~spill_file() {
+                file_.close();
+                std::error_code ec;
+                std::filesystem::remove(path_, ec);
+            }
+
+            void write(const std::string &bytes) {
+                file_.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+            }
+
+            void append_to(std::ostream &out) {
+                file_.flush();
+                file_.seekg(0);
+                std::vector<char> block(kBlockBytes);
+                while (file_.read(block.data(), static_cast<std::streamsize>(block.size())) || file_.gcount() > 0)
+                    out.write(block.data(), file_.gcount());
+                if (file_.bad()) throw std::runtime_error("Failed reading " + path_);
+            }
+
+        private:
+            std::string path_;
+            std::fstream file_;
+        };
+
+        template<typename T>
+        void append_raw(std::string &out, T v) {
+            char bytes[sizeof(T)];
+            std::memcpy(bytes, &v, sizeof(T));
+            out.append(bytes, sizeof(T));
+        }
+
+        // Unit facet normal, zero for degenerate triangles
+        Position facet_normal(const Position &a, const Position &b, const Position &c) {
+            const double u[3] = {b[0] - a[0], b[1] - a[1], b[2] - a[2]};
+            const double v[3] = {c[0] - a[0], c[1] - a[1], c[2] - a[2]};
+            Position n = {u[1] * v[2] - u[2] * v[1], u[2] * v[0] - u[0] * v[2], u[0] * v[1] - u[1] * v[0]};
+            const double len = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+            if (len > 0)
+                for (double &x: n) x /= len;
+            return n;
+        }
+
+        // Text sinks print coordinates at the precision the source had
+        class text_sink : public triangle_sink {
+        protected:
+            explicit text_sink(bool single_precision) : single_(single_precision) {
+            }
+
+            void put(std::string &out, double v) const {
+                if (single_) append_number(out, static_cast<float>(v));
+                else append_number(out, v);
+            }
+
+            void put_xyz(std::string &out, const Position &p) const {
+                put(out, p[0]);
+                out += ' ';
+                put(out, p[1]);
+                out += ' ';
+                put(out, p[2]);
+            }
+
+            std::string text_;
+            bool single_;
+        };
+
+        class stl_binary_sink : public triangle_sink {
+        public:
+            explicit stl_binary_sink(const std::string &filename) : file_(filename) {
+                std::string header = "binary STL written by halfMesh";
+                header.resize(80, ' ');
+                file_.write(header);
+                count_at_ = file_.stream().tellp();
+                std::string zero;
+                append_raw<std::uint32_t>(zero, 0);
+                file_.write(zero);
+            }
+
+            void write(const TriangleChunk &soup, const std::vector<Position> &,
+                       const std::vector<Triangle> &) override {
+                triangles_ += soup.size();
+                if (triangles_ > std::numeric_limits<std::uint32_t>::max())
+                    throw std::runtime_error("Too many triangles for binary STL");
+                bytes_.clear();
+                for (std::size_t t = 0; t < soup.size(); ++t) {
+                    const Position *p = &soup.positions[3 * t];
+                    for (double x: facet_normal(p[0], p[1], p[2])) append_raw(bytes_, static_cast<float>(x));
+                    for (int k = 0; k < 3; ++k)
+                        for (double x: p[k]) append_raw(bytes_, static_cast<float>(x));
+                    append_raw<std::uint16_t>(bytes_, 0);
+                }
+                file_.write(bytes_);
+            }
+
+            void finish() override {
+                std::string count;
+                append_raw(count, static_cast<std::uint32_t>(triangles_));
+                file_.stream().seekp(count_at_);
+                file_.write(count);
+                file_.close();
+            }
+
+        private:
+            output_file file_;
+            std::streampos count_at_;
+            std::uint64_t triangles_ = 0;
+            std::string bytes_;
+        };
+
+        class stl_ascii_sink : public text_sink {
+        public:
+            stl_ascii_sink(const std::string &filename, bool single_precision)
+                : text_sink(single_precision), file_(filename) {
+                file_.write("solid halfMesh\n");
+            }
+
+            void write(const TriangleChunk &soup, const std::vector<Position> &,
+                       const std::vector<Triangle> &) override {
+                text_.clear();
+                for (std::size_t t = 0; t < soup.size(); ++t) {
+                    const Position *p = &soup.positions[3 * t];
+                    text_ += "  facet normal ";
+                    put_xyz(text_, facet_normal(p[0], p[1], p[2]));
+                    text_ += "\n    outer loop\n";
+                    for (int k = 0; k < 3; ++k) {
+                        text_ += "      vertex ";
+                        put_xyz(text_, p[k]);
+                        text_ += '\n';
+                    }
+                    text_ += "    endloop\n  endfacet\n";
+                }
+                file_.write(text_);
+            }
+
+            void finish() override {
+                file_.write("endsolid halfMesh\n");
+                file_.close();
+            }
+
+        private:
+            output_file file_;
+        };
+
+        class obj_sink : public text_sink {
+        public:
+            obj_sink(const std::string &filename, bool single_precision)
+                : text_sink(single_precision), file_(filename), faces_(filename) {
+            }
+
+            void write(const TriangleChunk &, const std::vector<Position> &new_vertices,
+                       const std::vector<Triangle> &triangles) override {
+                text_.clear();
+                for (auto &v: new_vertices) {
+                    text_ += "v ";
+                    put_xyz(text_, v);
+                    text_ += '\n';
+                }
+                file_.write(text_);
+
+                text_.clear();
+                for (auto &t: triangles) {
+                    text_ += 'f';
+                    for (auto i: t) {
+                        text_ += ' ';
+                        append_integer(text_, i + 1);
+                    }
+                    text_ += '\n';
+                }
+                faces_.write(text_);
+            }
+
+            void finish() override {
+                faces_.append_to(file_.stream());
+                file_.close();
+            }
+
+        private:
+            output_file file_;
+            spill_file faces_;
+        };
+
+        class vtk_sink : public text_sink {
+        public:
+            vtk_sink(const std::string &filename, bool single_precision)
+                : text_sink(single_precision), file_(filename), faces_(filename) {
+                file_.write("# vtk DataFile Version 2.0\nHalfMesh VTK\nASCII\nDATASET POLYDATA\nPOINTS ");
+                points_at_ = file_.reserve_count();
+                file_.write(" float\n");
+            }
+
+            void write(const TriangleChunk &, const std::vector<Position> &new_vertices,
+                       const std::vector<Triangle> &triangles) override {
+                text_.clear();
+                for (auto &v: new_vertices) {
+                    put_xyz(text_, v);
+                    text_ += '\n';
+                }
+                file_.write(text_);
+                vertices_ += new_vertices.size();
+
+                text_.clear();
+                for (auto &t: triangles) {
+                    text_ += '3';
+                    for (auto i: t) {
+                        text_ += ' ';
+                        append_integer(text_, i);
+                    }
+                    text_ += '\n';
+                }
+                faces_.write(text_);
+                triangles_ += triangles.size();
+            }
+
+            void finish() override {
+                text_ = "POLYGONS ";
+                append_integer(text_, triangles_);
+                text_ += ' ';
+                append_integer(text_, 4 * triangles_);
+                text_ += '\n';
+                file_.write(text_);
+                faces_.append_to(file_.stream());
+                file_.patch_count(points_at_, vertices_);
+                file_.close();
+            }
+
+        private:
+            output_file file_;
+            spill_file faces_;
+            std::streampos points_at_;
+            std::uint64_t vertices_ = 0, triangles_ = 0;
+        };
+
+        class gmsh_sink : public text_sink {
+        public:
+            gmsh_sink(const std::string &filename, bool single_precision)
+                : text_sink(single_precision), file_(filename), faces_(filename) {
+                file_.write("$MeshFormat\n2.2 0 8\n$EndMeshFormat\n$Nodes\n");
+                nodes_at_ = file_.reserve_count();
+                file_.write("\n");
+            }
+
+            void write(const TriangleChunk &, const std::vector<Position> &new_vertices,
+                       const std::vector<Triangle> &triangles) override {
+                text_.clear();
+                for (auto &v: new_vertices) {
+                    append_integer(text_, ++vertices_);
+                    text_ += ' ';
+                    put_xyz(text_, v);
+                    text_ += '\n';
+                }
+                file_.write(text_);
+
+                text_.clear();
+                for (auto &t: triangles) {
+                    append_integer(text_, ++triangles_);
+                    text_ += " 2 2 0 1";
+                    for (auto i: t) {
+                        text_ += ' ';
+                        append_integer(text_, i + 1);
+                    }
+                    text_ += '\n';
+                }
+                faces_.write(text_);
+            }
+
+            void finish() override {
+                text_ = "$EndNodes\n$Elements\n";
+                append_integer(text_, triangles_);
+                text_ += '\n';
+                file_.write(text_);
+                faces_.append_to(file_.stream());
+                file_.write("$EndElements\n");
+                file_.patch_count(nodes_at_, vertices_);
+                file_.close();
+            }
+
+        private:
+            output_file file_;
+            spill_file faces_;
+            std::streampos nodes_at_;
+            std::uint64_t vertices_ = 0, triangles_ = 0;
+        };
+
+        // Binary little endian PLY with the layout of triMesh::save
+        class ply_sink : public triangle_sink {
+        public:
+            explicit ply_sink(const std::string &filename) : file_(filename), faces_(filename) {
+                file_.write("ply\nformat binary_little_endian 1.0\ncomment halfMesh\nelement vertex ");
+                vertices_at_ = file_.reserve_count();
+                file_.write("\nproperty double x\nproperty double y\nproperty double z\nelement face ");
+                faces_at_ = file_.reserve_count();
+                file_.write("\nproperty list uchar uint vertex_indices\nend_header\n");
+            }
+
+            void write(const TriangleChunk &, const std::vector<Position> &new_vertices,
+                       const std::vector<Triangle> &triangles) override {
+                bytes_.clear();
+                for (auto &v: new_vertices)
+                    for (double x: v) append_raw(bytes_, x);
+                file_.write(bytes_);
+                vertices_ += new_vertices.size();
+                if (vertices_ > std::numeric_limits<std::uint32_t>::max())
+                    throw std::runtime_error("Too many vertices for PLY uint indices");
+
+                bytes_.clear();
+                for (auto &t: triangles) {
+                    append_raw<std::uint8_t>(bytes_, 3);
+                    for (auto i: t) append_raw(bytes_, static_cast<std::uint32_t>(i));
+                }
+                faces_.write(bytes_);
+                triangles_ += triangles.size();
+            }
+
+            void finish() override {
+                faces_.append_to(file_.stream());
+                file_.patch_count(vertices_at_, vertices_);
+                file_.patch_count(faces_at_, triangles_);
+                file_.close();
+            }
+
+        private:
+            output_file file_;
+            spill_file faces_;
+            std::streampos vertices_at_, faces_at_;
+            std::uint64_t vertices_ = 0, triangles_ = 0;
+            std::string bytes_;
+        };
+
+        // A writer for the format of output that writes to filename
+        std::unique_ptr<triangle_sink> create_sink(const std::string &output, const std::string &filename,
+                                                   const ConvertOptions &options, bool single_precision) {
+            switch (guess_mesh_format(output)) {
+                case MeshType::Stl:
+                    if (options.binary_stl) return std::make_unique<stl_binary_sink>(filename);
+                    return std::make_unique<stl_ascii_sink>(filename, single_precision);
+                case MeshType::Obj:
+                    return std::make_unique<obj_sink>(filename, single_precision);
+                case MeshType::Vtk:
+                    return std::make_unique<vtk_sink>(filename, single_precision);
+                case MeshType::Gmsh:
+                    return std::make_unique<gmsh_sink>(filename, single_precision);
+                case MeshType::Ply:
+                    return std::make_unique<ply_sink>(filename);
+                default:
+                    throw std::invalid_argument("Streaming conversion cannot write " + output);
+            }
+        }
+
+        // Exact coordinate match; -0.0 and 0.0 are folded together
+        struct position_hash {
+            std::size_t operator()(const Position &p) const {
+                std::uint64_t h = 1469598103934665603ull;
+                for (double x: p) {
+                    std::uint64_t bits;
+                    x += 0.0;
+                    std::memcpy(&bits, &x, sizeof(bits));
+                    h = (h ^ bits) * 1099511628211ull;
+                    h ^= h >> 29;
+                }
+                return static_cast<std::size_t>(h);
+            }
+        };
+    }
+
+    double TriangleChunk::surface_area() const {
+        double area = 0.0;
+        for (std::size_t t = 0; t < size(); ++t) {
+            const Position &a = positions[3 * t], &b = positions[3 * t + 1], &c = positions[3 * t + 2];
+            const double u[3] = {b[0] - a[0], b[1] - a[1], b[2] - a[2]};
+            const double v[3] = {c[0] - a[0], c[1] - a[1], c[2] - a[2]};
+            const double n[3] = {u[1] * v[2] - u[2] * v[1], u[2] * v[0] - u[0] * v[2], u[0] * v[1] - u[1] * v[0]};
+            area += 0.5 * std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+        }
+        return area;
+    }
+
+    std::pair<std::array<double, 3>, std::array<double, 3> > TriangleChunk::bounding_box() const {
+        constexpr double inf = std::numeric_limits<double>::infinity();
+        std::array<double, 3> lo = {inf, inf, inf}, hi = {-inf, -inf, -inf};
+        for (auto &p: positions)
+            for (int k = 0; k < 3; ++k) {
+                lo[k] = std::min(lo[k], p[k]);
+                hi[k] = std::max(hi[k], p[k]);
+            }
+        return {lo, hi};
+    }
+
+    std::unique_ptr<triangle_source> open_triangle_source(const std::string &filename) {
+        std::error_code ec;
+        const auto size = std::filesystem::file_size(filename, ec);
+        if (ec) throw std::runtime_error("Could not open " + filename);
+
+        MeshType type = guess_mesh_format(filename);
+        if (type == MeshType::Unknown) {
+            std::vector<char> head(static_cast<std::size_t>(std::min<std::uintmax_t>(size, 4096)));
+            std::ifstream in = open_input(filename);
+            in.read(head.data(), static_cast<std::streamsize>(head.size()));
+            type = detect_mesh_format(reinterpret_cast<const std::byte *>(head.data()), head.size());
+            // the binary STL size rule needs the whole file size
+            if (type != MeshType::Stl && size >= 84 && head.size() >= 84) {
+                std::uint32_t count;
+                std::memcpy(&count, head.data() + 80, sizeof(count));
+                if (84 + 50 * static_cast<std::uintmax_t>(count) == size) type = MeshType::Stl;
+            }
+        }
+
+        switch (type) {
+            case MeshType::Stl:
+                return open_stl(filename, size);
+            case MeshType::Obj:
+                return std::make_unique<obj_source>(filename);
+            case MeshType::Gmsh:
+                return std::make_unique<gmsh_source>(filename);
+            case MeshType::Ply:
+                return std::make_unique<ply_source>(filename);
+            default:
+                throw std::invalid_argument("Streaming read is not supported for " + filename);
+        }
+    }
+
+    std::uint64_t for_each_triangle_chunk(const std::string &filename,
+                                          const std::function<void(const TriangleChunk &)> &callback,
+                                          std::size_t chunk_triangles) {
+        auto source = open_triangle_source(filename);
+        TriangleChunk chunk;
+        std::uint64_t triangles = 0;
+        while (source->next(chunk, chunk_triangles)) {
+            callback(chunk);
+            triangles += chunk.size();
+        }
+        return triangles;
+    }
+
+    ConvertStats convert_mesh(const std::string &input, const std::string &output, const ConvertOptions &options) {
+        auto source = open_triangle_source(input);
+        partial_output partial(output); // outlives the sink, which closes first
+        auto sink = create_sink(output, partial.path(), options, source->single_precision());
+
+        ConvertStats stats;
+        std::unordered_map<Position, std::uint64_t, position_hash> welded;
+        // output number of each file vertex, for indexed inputs without weld
+        constexpr std::uint64_t unused = std::numeric_limits<std::uint64_t>::max();
+        std::vector<std::uint64_t> numbered;
+        const bool shared = !options.weld && source->shared_vertices();
+        TriangleChunk chunk;
+        std::vector<Position> new_vertices;
+        std::vector<Triangle> triangles;
+        const std::size_t chunk_triangles = std::max<std::size_t>(options.chunk_triangles, 1);
+
+        while (source->next(chunk, chunk_triangles)) {
+            // 1) number the corners: merge repeated positions when welding,
+            // else keep the file's shared vertices, written on first use
+            new_vertices.clear();
+            triangles.resize(chunk.size());
+            for (std::size_t t = 0; t < chunk.size(); ++t) {
+                for (int k = 0; k < 3; ++k) {
+                    const Position &p = chunk.positions[3 * t + k];
+                    if (options.weld) {
+                        const auto [it, inserted] = welded.try_emplace(p, stats.vertices);
+                        if (inserted) {
+                            new_vertices.push_back(p);
+                            ++stats.vertices;
+                        }
+                        triangles[t][k] = it->second;
+                    } else if (shared) {
+                        const std::uint64_t index = chunk.indices[t][k];
+                        if (index >= numbered.size()) numbered.resize(std::max(index + 1, 2 * numbered.size()), unused);
+                        if (numbered[index] == unused) {
+                            numbered[index] = stats.vertices++;
+                            new_vertices.push_back(p);
+                        }
+                        triangles[t][k] = numbered[index];
+                    } else {
+                        new_vertices.push_back(p);
+                        triangles[t][k] = stats.vertices++;
+                    }
+                }
+            }
+
+            // 2) hand the chunk to the writer
+            sink->write(chunk, new_vertices, triangles);
+            stats.triangles += chunk.size();
+        }
+        sink->finish();
+        sink.reset();
+        partial.commit(output);
+
+        stats.bytes_read = source->bytes_read();
+        std::error_code ec;
+        stats.bytes_written = std::filesystem::file_size(output, ec);
+        return stats;
+    }
+} // namespace halfMesh
@@ -0,0 +1,375 @@
+#include "shared_mesh.hpp"
+#include "triMesh.hpp"
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define HALFMESH_HAS_SHM 1
+#endif
+
+namespace halfMesh {
+    namespace {
+        constexpr char kMagic[8] = {'H', 'M', 'S', 'H', 'A', 'R', 'E', 'D'};
+        constexpr std::uint32_t kVersion = 1;
+        constexpr std::uint32_t kByteOrder = 0x01020304;
+
+        const char *const kStoreKeys[4] = {
+            "VERTEX_PROPERTIES", "EDGE_PROPERTIES", "FACE_PROPERTIES", "HALF_EDGE_PROPERTIES"
+        };
+
+        // Start of every segment; offsets are bytes from the segment start
+        struct Header {
+            char magic[8]; // written last, a half-filled segment never validates
+            std::uint32_t version;
+            std::uint32_t byte_order;
+            std::uint64_t total_bytes;
+            std::uint64_t vertex_count;
+            std::uint64_t face_count;
+            std::uint64_t positions;
+            std::uint64_t vertex_handles;
+            std::uint64_t faces;
+            std::uint64_t face_handles;
+            std::uint64_t directory, directory_bytes;
+            std::uint64_t properties, properties_bytes;
+        };
+
+        std::uint64_t align8(std::uint64_t n) { return (n + 7) & ~std::uint64_t(7); }
+
+        std::string segment_name(const std::string &name) {
+            return !name.empty() && name[0] == '/' ? name : "/" + name;
+        }
+
+        // A store entry goes to a raw column if every value is a double or null
+        bool is_float_column(const nlohmann::json &values) {
+            if (!values.is_array() || values.empty()) return false;
+            for (auto &v: values)
+                if (!v.is_number_float() && !v.is_null()) return false;
+            return true;
+        }
+
+        const Header &header_of(const char *base) {
+            return *reinterpret_cast<const Header *>(base);
+        }
+
+        bool in_bounds(std::uint64_t offset, std::uint64_t bytes, std::uint64_t size) {
+            return offset <= size && bytes <= size - offset;
+        }
+    }
+
+    shared_mesh::shared_mesh(std::string name, char *base, std::size_t size, bool owner)
+        : name_(std::move(name)), base_(base), size_(size), owner_(owner) {
+    }
+
+    shared_mesh::~shared_mesh() {
+        release();
+    }
+
+    shared_mesh::shared_mesh(shared_mesh &&other) noexcept
+        : name_(std::move(other.name_)), base_(other.base_), size_(other.size_), owner_(other.owner_),
+          columns_(std::move(other.columns_)) {
+        other.base_ = nullptr;
+        other.size_ = 0;
+        other.owner_ = false;
+    }
+
+    shared_mesh &shared_mesh::operator=(shared_mesh &&other) noexcept {
+        if (this != &other) {
+            release();
+            name_ = std::move(other.name_);
+            base_ = other.base_;
+            size_ = other.size_;
+            owner_ = other.owner_;
+            columns_ = std::move(other.columns_);
+            other.base_ = nullptr;
+            other.size_ = 0;
+            other.owner_ = false;
+        }
+        return *this;
+    }
+
+    void shared_mesh::release() {
+#ifdef HALFMESH_HAS_SHM
+        if (base_) ::munmap(base_, size_);
+        if (owner_) ::shm_unlink(name_.c_str());
+#endif
+        base_ = nullptr;
+        size_ = 0;
+        owner_ = false;
+    }
+
+    // — Publishing —
+    shared_mesh shared_mesh::publish(const std::string &name, const triMesh &mesh) {
+#ifdef HALFMESH_HAS_SHM
+        const std::size_t nv = mesh.vertices_.size();
+        const std::size_t nf = mesh.faces_.size();
+
+        // split the stores into raw float columns and everything else
+        const nlohmann::json *stores[4] = {
+            &mesh.vertex_data_store, &mesh.edge_data_store, &mesh.face_data_store, &mesh.half_edge_data_store
+        };
+        std::vector<std::pair<Column, const nlohmann::json *> > columns;
+        nlohmann::json rest = nlohmann::json::object();
+        for (int k = 0; k < 4; ++k) {
+            if (!stores[k]->is_object()) continue;
+            for (auto &[key, values]: stores[k]->items()) {
+                if (is_float_column(values))
+                    columns.push_back({Column{static_cast<EntityType>(k), key, 0, values.size()}, &values});
+                else
+                    rest[kStoreKeys[k]][key] = values;
+            }
+        }
+
+        Header h{};
+        h.version = kVersion;
+        h.byte_order = kByteOrder;
+        h.vertex_count = nv;
+        h.face_count = nf;
+        h.positions = align8(sizeof(Header));
+        h.vertex_handles = align8(h.positions + 3 * sizeof(double) * nv);
+        h.faces = align8(h.vertex_handles + sizeof(std::uint32_t) * nv);
+        h.face_handles = align8(h.faces + 3 * sizeof(std::int32_t) * nf);
+        std::uint64_t at = align8(h.face_handles + sizeof(std::uint32_t) * nf);
+        nlohmann::json directory = nlohmann::json::array();
+        for (auto &[c, values]: columns) {
+            c.offset = at;
+            at = align8(at + sizeof(double) * c.count);
+            directory.push_back({static_cast<int>(c.type), c.name, c.offset, c.count});
+        }
+        const auto directory_bson = nlohmann::json::to_bson(nlohmann::json{{"COLUMNS", directory}});
+        const auto properties_bson = nlohmann::json::to_bson(rest);
+        h.directory = at;
+        h.directory_bytes = directory_bson.size();
+        h.properties = align8(h.directory + h.directory_bytes);
+        h.properties_bytes = properties_bson.size();
+        h.total_bytes = h.properties + h.properties_bytes;
+
+        const std::string shm = segment_name(name);
+        const int fd = ::shm_open(shm.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+        if (fd < 0) throw std::runtime_error("Could not create shared memory segment " + shm);
+        if (::ftruncate(fd, static_cast<off_t>(h.total_bytes)) != 0) {
+            ::close(fd);
+            ::shm_unlink(shm.c_str());
+            throw std::runtime_error("Could not size shared memory segment " + shm);
+        }
+        void *p = ::mmap(nullptr, h.total_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (p == MAP_FAILED) {
+            ::shm_unlink(shm.c_str());
+            throw std::runtime_error("Could not map shared memory segment " + shm);
+        }
+        shared_mesh out(shm, static_cast<char *>(p), h.total_bytes, true);
+        char *base = out.base_;
+
+        // vertex rows, and handle -> row for the faces
+        auto *positions = reinterpret_cast<double *>(base + h.positions);
+        auto *vertex_handles = reinterpret_cast<std::uint32_t *>(base + h.vertex_handles);
+        std::unordered_map<unsigned, std::int32_t> row;
+        row.reserve(nv);
+        for (std::size_t i = 0; i < nv; ++i) {
+            const auto &v = mesh.vertices_[i];
+            positions[3 * i] = v->get_x();
+            positions[3 * i + 1] = v->get_y();
+            positions[3 * i + 2] = v->get_z();
+            vertex_handles[i] = v->get_handle();
+            row[v->get_handle()] = static_cast<std::int32_t>(i);
+        }
+        auto *faces = reinterpret_cast<std::int32_t *>(base + h.faces);
+        auto *face_handles = reinterpret_cast<std::uint32_t *>(base + h.face_handles);
+        for (std::size_t i = 0; i < nf; ++i) {
+            auto [a,b,c] = mesh.faces_[i]->get_vertices();
+            faces[3 * i] = row.at(a->get_handle());
+            faces[3 * i + 1] = row.at(b->get_handle());
+            faces[3 * i + 2] = row.at(c->get_handle());
+            face_handles[i] = mesh.faces_[i]->get_handle();
+        }
+        for (auto &[c, values]: columns) {
+            auto *column = reinterpret_cast<double *>(base + c.offset);
+            for (std::size_t i = 0; i < c.count; ++i)
+                column[i] = (*values)[i].is_null()
+                                ? std::numeric_limits<double>::quiet_NaN()
+                                : (*values)[i].get<double>();
+            out.columns_.push_back(c);
+        }
+        std::memcpy(base + h.directory, directory_bson.data(), directory_bson.size());
+        std::memcpy(base + h.properties, properties_bson.data(), properties_bson.size());
+
+        std::memcpy(base, &h, sizeof(Header));
+        // everything above is visible before the magic that validates it
+        std::atomic_thread_fence(std::memory_order_release);
+        std::memcpy(base, kMagic, sizeof(kMagic));
+        return out;
+#else
+        (void) name;
+        (void) mesh;
+        throw std::runtime_error("Shared memory meshes need POSIX shm_open");
+#endif
+    }
+
+    // — Attaching —
+    shared_mesh shared_mesh::attach(const std::string &name) {
+#ifdef HALFMESH_HAS_SHM
+        const std::string shm = segment_name(name);
+        const int fd = ::shm_open(shm.c_str(), O_RDONLY, 0);
+        if (fd < 0) throw std::runtime_error("No shared memory segment " + shm);
+        struct stat st{};
+        if (::fstat(fd, &st) != 0 || static_cast<std::size_t>(st.st_size) < sizeof(Header)) {
+            ::close(fd);
+            throw std::runtime_error("Shared memory segment " + shm + " holds no mesh");
+        }
+        const auto size = static_cast<std::size_t>(st.st_size);
+        void *p = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (p == MAP_FAILED) throw std::runtime_error("Could not map shared memory segment " + shm);
+        shared_mesh out(shm, static_cast<char *>(p), size, false);
+
+        const Header &h = header_of(out.base_);
+        if (std::memcmp(h.magic, kMagic, sizeof(kMagic)) != 0)
+            throw std::runtime_error("Shared memory segment " + shm + " has an unknown layout");
+        // pairs with the fence in create: the rest is read after the magic
+        std::atomic_thread_fence(std::memory_order_acquire);
+        const std::uint64_t nv = h.vertex_count, nf = h.face_count;
+        const bool valid =
+                h.version == kVersion && h.byte_order == kByteOrder &&
+                h.total_bytes <= size &&
+                nv <= size / (3 * sizeof(double)) && nf <= size / (3 * sizeof(std::int32_t)) &&
+                in_bounds(h.positions, 3 * sizeof(double) * nv, h.total_bytes) &&
+                in_bounds(h.vertex_handles, sizeof(std::uint32_t) * nv, h.total_bytes) &&
+                in_bounds(h.faces, 3 * sizeof(std::int32_t) * nf, h.total_bytes) &&
+                in_bounds(h.face_handles, sizeof(std::uint32_t) * nf, h.total_bytes) &&
+                in_bounds(h.directory, h.directory_bytes, h.total_bytes) &&
+                in_bounds(h.properties, h.properties_bytes, h.total_bytes) &&
+                h.positions % alignof(double) == 0;
+        if (!valid) throw std::runtime_error("Shared memory segment " + shm + " has an unknown layout");
+        out.read_directory();
+        return out;
+#else
+        (void) name;
+        throw std::runtime_error("Shared memory meshes need POSIX shm_open");
+#endif
+    }
+
+    bool shared_mesh::remove(const std::string &name) {
+#ifdef HALFMESH_HAS_SHM
+        return ::shm_unlink(segment_name(name).c_str()) == 0;
+#else
+        (void) name;
+        return false;
+#endif
+    }
+
+    void shared_mesh::read_directory() {
+        const Header &h = header_of(base_);
+        const auto *bytes = reinterpret_cast<const std::uint8_t *>(base_ + h.directory);
+        const auto directory = nlohmann::json::from_bson(bytes, bytes + h.directory_bytes);
+        for (auto &c: directory.at("COLUMNS")) {
+            Column column{
+                static_cast<EntityType>(c.at(0).get<int>()), c.at(1).get<std::string>(),
+                c.at(2).get<std::uint64_t>(), c.at(3).get<std::uint64_t>()
+            };
+            if (column.count > h.total_bytes / sizeof(double) ||
+                !in_bounds(column.offset, sizeof(double) * column.count, h.total_bytes) ||
+                column.offset % alignof(double) != 0)
+                throw std::runtime_error("Shared memory segment " + name_ + " has an unknown layout");
+            columns_.push_back(std::move(column));
+        }
+    }
+
+    // — Views —
+    std::size_t shared_mesh::vertex_count() const {
+        return base_ ? static_cast<std::size_t>(header_of(base_).vertex_count) : 0;
+    }
+
+    std::size_t shared_mesh::face_count() const {
+        return base_ ? static_cast<std::size_t>(header_of(base_).face_count) : 0;
+    }
+
+    shared_mesh::PositionsView shared_mesh::positions() const {
+        const auto *p = base_ ? reinterpret_cast<const double *>(base_ + header_of(base_).positions) : nullptr;
+        return PositionsView(p, static_cast<Eigen::Index>(vertex_count()), 3);
+    }
+
+    shared_mesh::FacesView shared_mesh::faces() const {
+        const auto *p = base_ ? reinterpret_cast<const std::int32_t *>(base_ + header_of(base_).faces) : nullptr;
+        return FacesView(p, static_cast<Eigen::Index>(face_count()), 3);
+    }
+
+    const std::uint32_t *shared_mesh::vertex_handles() const {
+        return base_ ? reinterpret_cast<const std::uint32_t *>(base_ + header_of(base_).vertex_handles) : nullptr;
+    }
+
+    const std::uint32_t *shared_mesh::face_handles() const {
+        return base_ ? reinterpret_cast<const std::uint32_t *>(base_ + header_of(base_).face_handles) : nullptr;
+    }
+
+    const shared_mesh::Column *shared_mesh::find_column(EntityType type, const std::string &name) const {
+        for (auto &c: columns_)
+            if (c.type == type && c.name == name) return &c;
+        return nullptr;
+    }
+
+    bool shared_mesh::has_column(EntityType type, const std::string &name) const {
+        return find_column(type, name) != nullptr;
+    }
+
+    shared_mesh::ColumnView shared_mesh::column(EntityType type, const std::string &name) const {
+        const Column *c = find_column(type, name);
+        if (!c) throw std::runtime_error("No shared property column " + name);
+        return ColumnView(reinterpret_cast<const double *>(base_ + c->offset), static_cast<Eigen::Index>(c->count));
+    }
+
+    // — Rebuilding —
+    triMesh shared_mesh::to_mesh() const {
+        triMesh mesh;
+        if (!base_) return mesh;
+        const Header &h = header_of(base_);
+        const auto V = positions();
+        const auto F = faces();
+        const std::uint32_t *vh = vertex_handles();
+        const std::uint32_t *fh = face_handles();
+
+        std::vector<vertexPtr> rows;
+        rows.reserve(static_cast<std::size_t>(V.rows()));
+        for (Eigen::Index i = 0; i < V.rows(); ++i) {
+            mesh.next_vertex_handle_ = vh[i];
+            rows.push_back(mesh.add_vertex(V(i, 0), V(i, 1), V(i, 2)));
+        }
+        for (Eigen::Index i = 0; i < F.rows(); ++i) {
+            for (int k = 0; k < 3; ++k)
+                if (F(i, k) < 0 || F(i, k) >= V.rows())
+                    throw std::runtime_error("Shared memory segment " + name_ + " has a face out of range");
+            mesh.next_face_handle_ = fh[i];
+            mesh.add_face(rows[F(i, 0)], rows[F(i, 1)], rows[F(i, 2)]);
+        }
+        mesh.next_vertex_handle_ = 0;
+        for (auto &v: mesh.vertices_) mesh.next_vertex_handle_ = std::max(mesh.next_vertex_handle_, v->get_handle() + 1);
+        mesh.next_face_handle_ = 0;
+        for (auto &f: mesh.faces_) mesh.next_face_handle_ = std::max(mesh.next_face_handle_, f->get_handle() + 1);
+
+        nlohmann::json *stores[4] = {
+            &mesh.vertex_data_store, &mesh.edge_data_store, &mesh.face_data_store, &mesh.half_edge_data_store
+        };
+        const auto *bytes = reinterpret_cast<const std::uint8_t *>(base_ + h.properties);
+        const auto rest = nlohmann::json::from_bson(bytes, bytes + h.properties_bytes);
+        for (int k = 0; k < 4; ++k)
+            if (rest.contains(kStoreKeys[k])) *stores[k] = rest[kStoreKeys[k]];
+        for (auto &c: columns_) {
+            const auto values = column(c.type, c.name);
+            nlohmann::json out = nlohmann::json::array();
+            for (Eigen::Index i = 0; i < values.size(); ++i) {
+                if (std::isnan(values[i])) out.push_back(nullptr);
+                else out.push_back(values[i]);
+            }
+            (*stores[static_cast<int>(c.type)])[c.name] = std::move(out);
+        }
+        mesh.complete_mesh();
+        return mesh;
+    }
+} // namespace halfMesh
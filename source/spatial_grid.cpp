@@ -0,0 +1,229 @@
+#include "spatial_grid.hpp"
+#include "task_scheduler.hpp"
+#include "triMesh.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+
+namespace halfMesh {
+    namespace {
+        // Items per cell aimed for when the cell size is picked
+        constexpr double kItemsPerCell = 2.0;
+
+        // A grid over the bounds is addressed directly when it has at most
+        // this many cells per item (or kMinSlots), and hashed otherwise
+        constexpr double kDenseCellsPerItem = 4.0;
+        constexpr std::size_t kMinSlots = 64;
+
+        // Items per task in close_pairs
+        constexpr std::size_t kPairGrain = 256;
+
+        // Cell coordinates are clamped to this, so far-off or non-finite
+        // points still map to some cell
+        constexpr double kFar = 1e15;
+
+        std::size_t next_power_of_two(std::size_t n) {
+            std::size_t p = 1;
+            while (p < n) p <<= 1;
+            return p;
+        }
+    }
+
+    spatial_grid::spatial_grid(const triMesh &mesh, GridItems items, double cell_size) {
+        build(mesh, items, cell_size);
+    }
+
+    // — Build —
+    void spatial_grid::build(const triMesh &mesh, GridItems items, double cell_size) {
+        items_ = items;
+        if (items == GridItems::Vertices) {
+            const auto &vertices = mesh.get_vertices();
+            boxes_.resize(vertices.size());
+            handles_.resize(vertices.size());
+            parallel_for(0, vertices.size(), [&](std::size_t i) {
+                boxes_[i] = Eigen::AlignedBox3d(vertices[i]->get_position());
+                handles_[i] = vertices[i]->get_handle();
+            });
+        } else {
+            const auto &faces = mesh.get_faces();
+            boxes_.resize(faces.size());
+            handles_.resize(faces.size());
+            parallel_for(0, faces.size(), [&](std::size_t i) {
+                auto [a,b,c] = faces[i]->get_vertices();
+                boxes_[i] = Eigen::AlignedBox3d(a->get_position());
+                boxes_[i].extend(b->get_position()).extend(c->get_position());
+                handles_[i] = faces[i]->get_handle();
+            });
+        }
+        const std::size_t n = handles_.size();
+
+        // cell size: kItemsPerCell on average over the bounds (thin
+        // directions count as a thousandth of the widest), no smaller
+        // than the mean face extent
+        const Eigen::AlignedBox3d bounds = mesh.axis_aligned_bounding_box();
+        const Eigen::Vector3d size = bounds.isEmpty() ? Eigen::Vector3d::Zero().eval() : bounds.sizes().eval();
+        const double widest = size.maxCoeff();
+        if (!(cell_size > 0.0)) {
+            double volume = 1.0;
+            for (int k = 0; k < 3; ++k) volume *= std::max(size[k], widest * 1e-3);
+            cell_size = widest > 0.0 && n > 0 ? std::cbrt(volume * kItemsPerCell / static_cast<double>(n)) : 1.0;
+            if (items == GridItems::Faces && n > 0) {
+                const double extent = parallel_reduce(
+                    std::size_t{0}, n, 0.0,
+                    [this](double sum, std::size_t i) { return sum + boxes_[i].sizes().maxCoeff(); },
+                    [](double a, double b) { return a + b; }) / static_cast<double>(n);
+                cell_size = std::max(cell_size, extent);
+            }
+        }
+        cell_size_ = cell_size;
+        origin_ = bounds.isEmpty() ? Eigen::Vector3d::Zero() : bounds.min();
+
+        double cells = 1.0;
+        for (int k = 0; k < 3; ++k) {
+            dims_[k] = static_cast<std::int64_t>(std::floor(std::min(size[k] / cell_size_, kFar))) + 1;
+            cells *= static_cast<double>(dims_[k]);
+        }
+        const double dense_limit = std::max(static_cast<double>(kMinSlots), kDenseCellsPerItem * static_cast<double>(n));
+        dense_ = cells <= dense_limit;
+        const std::size_t slots = dense_
+                                      ? static_cast<std::size_t>(cells)
+                                      : next_power_of_two(std::max(kMinSlots, 2 * n));
+
+        // counting sort: count the cells each item touches, prefix sums,
+        // then scatter behind atomic cursors
+        const auto for_each_slot = [this](std::size_t i, auto &&body) {
+            const Cell lo = cell_of(boxes_[i].min()), hi = cell_of(boxes_[i].max());
+            for (std::int64_t z = lo[2]; z <= hi[2]; ++z)
+                for (std::int64_t y = lo[1]; y <= hi[1]; ++y)
+                    for (std::int64_t x = lo[0]; x <= hi[0]; ++x)
+                        body(slot({x, y, z}));
+        };
+        offsets_.assign(slots + 1, 0);
+        {
+            std::vector<std::atomic<std::size_t> > counts(slots);
+            parallel_for(0, n, [&](std::size_t i) {
+                for_each_slot(i, [&](std::size_t s) { counts[s].fetch_add(1, std::memory_order_relaxed); });
+            });
+            for (std::size_t s = 0; s < slots; ++s)
+                offsets_[s + 1] = offsets_[s] + counts[s].load(std::memory_order_relaxed);
+            for (std::size_t s = 0; s < slots; ++s) counts[s].store(offsets_[s], std::memory_order_relaxed);
+            entries_.resize(offsets_.back());
+            parallel_for(0, n, [&](std::size_t i) {
+                for_each_slot(i, [&](std::size_t s) {
+                    entries_[counts[s].fetch_add(1, std::memory_order_relaxed)] = static_cast<unsigned>(i);
+                });
+            });
+        }
+        parallel_for(0, slots, [&](std::size_t s) {
+            std::sort(entries_.begin() + static_cast<std::ptrdiff_t>(offsets_[s]),
+                      entries_.begin() + static_cast<std::ptrdiff_t>(offsets_[s + 1]));
+        });
+    }
+
+    spatial_grid::Cell spatial_grid::cell_of(const Eigen::Vector3d &p) const {
+        Cell cell;
+        for (int k = 0; k < 3; ++k) {
+            double c = std::floor((p[k] - origin_[k]) / cell_size_);
+            if (!(c >= -kFar)) c = -kFar;
+            if (c > kFar) c = kFar;
+            cell[k] = static_cast<std::int64_t>(c);
+        }
+        return cell;
+    }
+
+    std::size_t spatial_grid::slot(const Cell &cell) const {
+        if (dense_) {
+            for (int k = 0; k < 3; ++k)
+                if (cell[k] < 0 || cell[k] >= dims_[k]) return cell_count();
+            return static_cast<std::size_t>((cell[2] * dims_[1] + cell[1]) * dims_[0] + cell[0]);
+        }
+        // Teschner et al., "Optimized Spatial Hashing for Collision Detection of Deformable Objects"
+        const auto h = static_cast<std::uint64_t>(cell[0]) * 73856093u ^
+                       static_cast<std::uint64_t>(cell[1]) * 19349663u ^
+                       static_cast<std::uint64_t>(cell[2]) * 83492791u;
+        return static_cast<std::size_t>(h & (cell_count() - 1));
+    }
+
+    // — Queries —
+    std::vector<unsigned> spatial_grid::gather(const Eigen::AlignedBox3d &box, double epsilon) const {
+        std::vector<unsigned> found;
+        if (handles_.empty() || box.isEmpty() || !(epsilon >= 0.0)) return found;
+        const Eigen::Vector3d grow = Eigen::Vector3d::Constant(epsilon);
+        const Eigen::AlignedBox3d reach(box.min() - grow, box.max() + grow);
+        Cell lo = cell_of(reach.min()), hi = cell_of(reach.max());
+        double cells = 1.0;
+        for (int k = 0; k < 3; ++k) {
+            if (dense_) {
+                lo[k] = std::max<std::int64_t>(lo[k], 0);
+                hi[k] = std::min<std::int64_t>(hi[k], dims_[k] - 1);
+            }
+            if (lo[k] > hi[k]) return found;
+            cells *= static_cast<double>(hi[k] - lo[k] + 1);
+        }
+        const double epsilon2 = epsilon * epsilon;
+        const auto offer = [&](unsigned i) {
+            if (boxes_[i].squaredExteriorDistance(box) <= epsilon2) found.push_back(i);
+        };
+        if (cells > static_cast<double>(cell_count())) {
+            // more cells than slots: every item once instead
+            for (unsigned i = 0; i < handles_.size(); ++i) offer(i);
+            return found;
+        }
+        for (std::int64_t z = lo[2]; z <= hi[2]; ++z)
+            for (std::int64_t y = lo[1]; y <= hi[1]; ++y)
+                for (std::int64_t x = lo[0]; x <= hi[0]; ++x) {
+                    const std::size_t s = slot({x, y, z});
+                    for (std::size_t e = offsets_[s]; e < offsets_[s + 1]; ++e) offer(entries_[e]);
+                }
+        std::sort(found.begin(), found.end());
+        found.erase(std::unique(found.begin(), found.end()), found.end());
+        return found;
+    }
+
+    // Items filed under p's cell (not merely hashed to its slot)
+    std::vector<unsigned> spatial_grid::cell_items(const Eigen::Vector3d &p) const {
+        std::vector<unsigned> result;
+        if (handles_.empty()) return result;
+        const Cell cell = cell_of(p);
+        const std::size_t s = slot(cell);
+        if (s == cell_count()) return result;
+        for (std::size_t e = offsets_[s]; e < offsets_[s + 1]; ++e) {
+            const unsigned i = entries_[e];
+            const Cell lo = cell_of(boxes_[i].min()), hi = cell_of(boxes_[i].max());
+            bool inside = true;
+            for (int k = 0; k < 3; ++k) inside = inside && lo[k] <= cell[k] && cell[k] <= hi[k];
+            if (inside) result.push_back(handles_[i]);
+        }
+        std::sort(result.begin(), result.end());
+        return result;
+    }
+
+    std::vector<unsigned> spatial_grid::overlapping(const Eigen::AlignedBox3d &box) const {
+        std::vector<unsigned> result;
+        for (const unsigned i: gather(box, 0.0)) result.push_back(handles_[i]);
+        std::sort(result.begin(), result.end());
+        return result;
+    }
+
+    std::vector<unsigned> spatial_grid::neighbours(const Eigen::Vector3d &p, double epsilon) const {
+        std::vector<unsigned> result;
+        for (const unsigned i: gather(Eigen::AlignedBox3d(p), epsilon)) result.push_back(handles_[i]);
+        std::sort(result.begin(), result.end());
+        return result;
+    }
+
+    std::vector<std::pair<unsigned, unsigned> > spatial_grid::close_pairs(double epsilon) const {
+        const std::size_t n = handles_.size();
+        const std::size_t blocks = (n + kPairGrain - 1) / kPairGrain;
+        std::vector<std::vector<std::pair<unsigned, unsigned> > > found(blocks);
+        parallel_for(0, blocks, [&](std::size_t b) {
+            for (std::size_t i = b * kPairGrain; i < std::min(n, (b + 1) * kPairGrain); ++i)
+                for (const unsigned j: gather(boxes_[i], epsilon))
+                    if (j > i) found[b].emplace_back(std::min(handles_[i], handles_[j]), std::max(handles_[i], handles_[j]));
+        }, 1);
+        std::vector<std::pair<unsigned, unsigned> > pairs;
+        for (const auto &list: found) pairs.insert(pairs.end(), list.begin(), list.end());
+        std::sort(pairs.begin(), pairs.end());
+        return pairs;
+    }
+} // namespace halfMesh
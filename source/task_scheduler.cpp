@@ -0,0 +1,145 @@
+#include "task_scheduler.hpp"
+
+namespace halfMesh {
+    namespace {
+        // Scheduler and queue of the worker running on this thread, if any
+        thread_local const task_scheduler *tls_scheduler = nullptr;
+        thread_local std::size_t tls_queue = 0;
+
+        std::mutex default_mutex;
+        std::unique_ptr<task_scheduler> default_instance;
+    }
+
+    task_scheduler::task_scheduler(unsigned num_threads) {
+        if (num_threads == 0) num_threads = std::max(1u, std::thread::hardware_concurrency());
+        const unsigned workers = num_threads - 1;
+        for (unsigned i = 0; i <= workers; ++i) queues_.push_back(std::make_unique<Queue>());
+        workers_.reserve(workers);
+        for (unsigned i = 0; i < workers; ++i)
+            workers_.emplace_back([this, i] { worker_loop(i); });
+    }
+
+    task_scheduler::~task_scheduler() {
+        {
+            std::lock_guard<std::mutex> lock(sleep_mutex_);
+            stopping_ = true;
+        }
+        wake_.notify_all();
+        for (auto &w: workers_) w.join();
+    }
+
+    std::size_t task_scheduler::queue_of_caller() const {
+        return tls_scheduler == this ? tls_queue : workers_.size();
+    }
+
+    // — Queues —
+    void task_scheduler::push(std::size_t queue, const Task &task) {
+        {
+            std::lock_guard<std::mutex> lock(queues_[queue]->mutex);
+            queues_[queue]->tasks.push_back(task);
+        }
+        queued_.fetch_add(1, std::memory_order_release);
+        if (!workers_.empty()) {
+            // taking the lock orders this against a worker about to sleep
+            std::lock_guard<std::mutex> lock(sleep_mutex_);
+        }
+        wake_.notify_one();
+    }
+
+    // Newest first from our own queue: it is the smallest and still in cache
+    bool task_scheduler::pop(std::size_t queue, Task &task) {
+        std::lock_guard<std::mutex> lock(queues_[queue]->mutex);
+        auto &tasks = queues_[queue]->tasks;
+        if (tasks.empty()) return false;
+        task = tasks.back();
+        tasks.pop_back();
+        queued_.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    // Oldest first from everybody else: the biggest ranges move
+    bool task_scheduler::steal(std::size_t self, Task &task) {
+        const std::size_t n = queues_.size();
+        for (std::size_t k = 1; k < n; ++k) {
+            auto &queue = *queues_[(self + k) % n];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            if (queue.tasks.empty()) continue;
+            task = queue.tasks.front();
+            queue.tasks.pop_front();
+            queued_.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+        return false;
+    }
+
+    // — Running —
+    void task_scheduler::execute(std::size_t self, Task task) {
+        while (task.last - task.first > 1) {
+            const std::size_t mid = task.first + (task.last - task.first) / 2;
+            push(self, Task{task.job, mid, task.last});
+            task.last = mid;
+        }
+        Job &job = *task.job;
+        try {
+            (*job.chunk)(task.first);
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(job.error_mutex);
+            if (!job.error) job.error = std::current_exception();
+        }
+        // last touch of the job: the owner may return once this hits zero
+        job.remaining.fetch_sub(1, std::memory_order_acq_rel);
+    }
+
+    void task_scheduler::worker_loop(std::size_t self) {
+        tls_scheduler = this;
+        tls_queue = self;
+        Task task{};
+        while (true) {
+            if (pop(self, task) || steal(self, task)) {
+                execute(self, task);
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(sleep_mutex_);
+            wake_.wait(lock, [this] { return stopping_ || queued_.load(std::memory_order_acquire) > 0; });
+            if (stopping_ && queued_.load(std::memory_order_acquire) == 0) return;
+        }
+    }
+
+    void task_scheduler::run_chunks(std::size_t chunks, const std::function<void(std::size_t)> &chunk) {
+        if (chunks == 0) return;
+        if (workers_.empty()) {
+            for (std::size_t c = 0; c < chunks; ++c) chunk(c);
+            return;
+        }
+        Job job;
+        job.chunk = &chunk;
+        job.remaining.store(chunks, std::memory_order_relaxed);
+
+        const std::size_t self = queue_of_caller();
+        execute(self, Task{&job, 0, chunks});
+        // help out (with this loop or any other) until every chunk is done
+        Task task{};
+        while (job.remaining.load(std::memory_order_acquire) > 0) {
+            if (pop(self, task) || steal(self, task)) execute(self, task);
+            else std::this_thread::yield();
+        }
+        if (job.error) std::rethrow_exception(job.error);
+    }
+
+    // — Library-wide scheduler —
+    task_scheduler &default_scheduler() {
+        std::lock_guard<std::mutex> lock(default_mutex);
+        if (!default_instance) default_instance = std::make_unique<task_scheduler>();
+        return *default_instance;
+    }
+
+    void set_num_threads(unsigned num_threads) {
+        std::lock_guard<std::mutex> lock(default_mutex);
+        default_instance.reset();
+        default_instance = std::make_unique<task_scheduler>(num_threads);
+    }
+
+    unsigned num_threads() {
+        return default_scheduler().size();
+    }
+} // namespace halfMesh
@@ -0,0 +1,239 @@
+#include "vertex_kdtree.hpp"
+#include "task_scheduler.hpp"
+#include "triMesh.hpp"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <utility>
+
+namespace halfMesh {
+    namespace {
+        constexpr double kInf = std::numeric_limits<double>::infinity();
+
+        // Ranges this short are leaves and get scanned
+        constexpr std::size_t kLeafSize = 8;
+
+        // Ranges at least this long are split and recurse in parallel
+        constexpr std::size_t kParallelRange = 8192;
+
+        // The tail is folded into the tree once it is longer than this and
+        // an eighth of the tree
+        constexpr std::size_t kMinTail = 64;
+
+        // Query points per task in the batch queries
+        constexpr std::size_t kQueryGrain = 64;
+
+        // (squared distance, vertex handle), ordered so ties go to the lower handle
+        using Candidate = std::pair<double, unsigned>;
+
+        double distance2(const double *a, const double *b) {
+            const double x = a[0] - b[0], y = a[1] - b[1], z = a[2] - b[2];
+            return x * x + y * y + z * z;
+        }
+
+        // The k best candidates as a max-heap; bound2 is the worst of them
+        // once there are k
+        struct KnnVisitor {
+            std::size_t k;
+            std::vector<Candidate> heap;
+            double bound2 = kInf;
+
+            void operator()(unsigned vertex, double d2) {
+                const Candidate candidate{d2, vertex};
+                if (heap.size() < k) {
+                    heap.push_back(candidate);
+                    std::push_heap(heap.begin(), heap.end());
+                } else if (candidate < heap.front()) {
+                    std::pop_heap(heap.begin(), heap.end());
+                    heap.back() = candidate;
+                    std::push_heap(heap.begin(), heap.end());
+                } else return;
+                if (heap.size() == k) bound2 = heap.front().first;
+            }
+        };
+
+        struct RadiusVisitor {
+            double bound2;
+            std::vector<Candidate> &found;
+
+            void operator()(unsigned vertex, double d2) {
+                if (d2 <= bound2) found.emplace_back(d2, vertex);
+            }
+        };
+
+        void check_queries(const Eigen::Ref<const Eigen::MatrixXd> &points) {
+            if (points.cols() != 3)
+                throw std::runtime_error("vertex_kdtree: expected a #Q x 3 matrix of query points");
+        }
+    }
+
+    vertex_kdtree::vertex_kdtree(const triMesh &mesh) {
+        build(mesh);
+    }
+
+    // — Build —
+    void vertex_kdtree::build(const triMesh &mesh) {
+        const auto &vertices = mesh.get_vertices();
+        points_.resize(vertices.size());
+        parallel_for(0, vertices.size(), [&](std::size_t i) {
+            const auto &v = vertices[i];
+            points_[i] = Point{{v->get_x(), v->get_y(), v->get_z()}, v->get_handle()};
+        });
+        last_vertex_ = vertices.empty() ? 0 : vertices.back()->get_handle();
+        geometry_version_ = mesh.geometry_version();
+        rebuild();
+    }
+
+    // Vertices are only ever appended to the mesh and each add_vertex bumps
+    // the geometry version once, so the tree is behind by pure additions
+    // exactly when the vertices it knows are still a prefix (the last one
+    // still in place) and the version moved by the number of new ones
+    void vertex_kdtree::update(const triMesh &mesh) {
+        const auto &vertices = mesh.get_vertices();
+        const std::size_t known = points_.size();
+        const bool appended = vertices.size() >= known &&
+                              (known == 0 || vertices[known - 1]->get_handle() == last_vertex_) &&
+                              mesh.geometry_version() - geometry_version_ == vertices.size() - known;
+        if (!appended) {
+            build(mesh);
+            return;
+        }
+        for (std::size_t i = known; i < vertices.size(); ++i) {
+            const auto &v = vertices[i];
+            points_.push_back(Point{{v->get_x(), v->get_y(), v->get_z()}, v->get_handle()});
+        }
+        if (!vertices.empty()) last_vertex_ = vertices.back()->get_handle();
+        geometry_version_ = mesh.geometry_version();
+        if (pending() > std::max(kMinTail, tree_size_ / 8)) rebuild();
+    }
+
+    void vertex_kdtree::rebuild() {
+        tree_size_ = points_.size();
+        axes_.assign(tree_size_, 0);
+        build_range(0, tree_size_);
+    }
+
+    // The middle point of the range along its widest axis becomes the
+    // node, smaller coordinates before it and larger after
+    void vertex_kdtree::build_range(std::size_t begin, std::size_t end) {
+        const std::size_t n = end - begin;
+        if (n <= kLeafSize) return;
+        const auto extend = [this](Eigen::AlignedBox3d box, std::size_t i) {
+            return box.extend(Eigen::Vector3d(points_[i].p));
+        };
+        Eigen::AlignedBox3d box;
+        if (n >= kParallelRange)
+            box = parallel_reduce(begin, end, Eigen::AlignedBox3d(), extend,
+                                  [](Eigen::AlignedBox3d a, const Eigen::AlignedBox3d &b) { return a.extend(b); });
+        else
+            for (std::size_t i = begin; i < end; ++i) box = extend(std::move(box), i);
+        int axis = 0;
+        box.sizes().maxCoeff(&axis);
+
+        const std::size_t middle = begin + n / 2;
+        std::nth_element(points_.begin() + begin, points_.begin() + middle, points_.begin() + end,
+                         [axis](const Point &a, const Point &b) { return a.p[axis] < b.p[axis]; });
+        axes_[middle] = static_cast<std::uint8_t>(axis);
+        if (n >= kParallelRange) {
+            parallel_for(0, 2, [&](std::size_t k) {
+                if (k == 0) build_range(begin, middle);
+                else build_range(middle + 1, end);
+            }, 1);
+        } else {
+            build_range(begin, middle);
+            build_range(middle + 1, end);
+        }
+    }
+
+    // — Queries —
+    // Near half first; the far half only if the splitting plane is within
+    // the visitor's bound. Equal distances are visited, as a tie there can
+    // still win on its handle.
+    template<typename Visitor>
+    void vertex_kdtree::search(std::size_t begin, std::size_t end, const double *p, Visitor &visitor) const {
+        while (end - begin > kLeafSize) {
+            const std::size_t middle = begin + (end - begin) / 2;
+            const Point &node = points_[middle];
+            const double diff = p[axes_[middle]] - node.p[axes_[middle]];
+            if (diff < 0.0) search(begin, middle, p, visitor);
+            else search(middle + 1, end, p, visitor);
+            visitor(node.vertex, distance2(p, node.p));
+            if (diff * diff > visitor.bound2) return;
+            if (diff < 0.0) begin = middle + 1;
+            else end = middle;
+        }
+        for (std::size_t i = begin; i < end; ++i) visitor(points_[i].vertex, distance2(p, points_[i].p));
+    }
+
+    template<typename Visitor>
+    void vertex_kdtree::search(const double *p, Visitor &visitor) const {
+        search(0, tree_size_, p, visitor);
+        for (std::size_t i = tree_size_; i < points_.size(); ++i)
+            visitor(points_[i].vertex, distance2(p, points_[i].p));
+    }
+
+    unsigned vertex_kdtree::nearest(const Eigen::Vector3d &p, double *distance) const {
+        KnnVisitor visitor{1, {}, kInf};
+        search(p.data(), visitor);
+        if (distance) *distance = visitor.heap.empty() ? kInf : std::sqrt(visitor.heap.front().first);
+        return visitor.heap.empty() ? std::numeric_limits<unsigned>::max() : visitor.heap.front().second;
+    }
+
+    NearestVertices vertex_kdtree::knn(const Eigen::Ref<const Eigen::MatrixXd> &points, std::size_t k) const {
+        check_queries(points);
+        NearestVertices result;
+        result.k = k;
+        const auto count = static_cast<std::size_t>(points.rows());
+        result.vertices.assign(count * k, std::numeric_limits<unsigned>::max());
+        result.distances.assign(count * k, kInf);
+        if (k == 0) return result;
+        parallel_for(0, count, [&](std::size_t q) {
+            const double p[3] = {points(q, 0), points(q, 1), points(q, 2)};
+            KnnVisitor visitor{k, {}, kInf};
+            visitor.heap.reserve(k);
+            search(p, visitor);
+            std::sort_heap(visitor.heap.begin(), visitor.heap.end());
+            for (std::size_t j = 0; j < visitor.heap.size(); ++j) {
+                result.vertices[q * k + j] = visitor.heap[j].second;
+                result.distances[q * k + j] = std::sqrt(visitor.heap[j].first);
+            }
+        }, kQueryGrain);
+        return result;
+    }
+
+    // Each task gathers the runs of its queries into one list; the lists
+    // are then copied into place behind the prefix sums of the run lengths
+    VerticesInRadius vertex_kdtree::radius_search(const Eigen::Ref<const Eigen::MatrixXd> &points,
+                                                  double radius) const {
+        check_queries(points);
+        const auto count = static_cast<std::size_t>(points.rows());
+        const double bound2 = radius >= 0.0 ? radius * radius : -1.0;
+        const std::size_t blocks = (count + kQueryGrain - 1) / kQueryGrain;
+        std::vector<std::vector<Candidate> > found(blocks);
+        VerticesInRadius result;
+        result.offsets.assign(count + 1, 0);
+        parallel_for(0, blocks, [&](std::size_t b) {
+            auto &list = found[b];
+            for (std::size_t q = b * kQueryGrain; q < std::min(count, (b + 1) * kQueryGrain); ++q) {
+                const double p[3] = {points(q, 0), points(q, 1), points(q, 2)};
+                const std::size_t before = list.size();
+                RadiusVisitor visitor{bound2, list};
+                search(p, visitor);
+                std::sort(list.begin() + static_cast<std::ptrdiff_t>(before), list.end());
+                result.offsets[q + 1] = list.size() - before;
+            }
+        }, 1);
+        for (std::size_t q = 0; q < count; ++q) result.offsets[q + 1] += result.offsets[q];
+
+        result.vertices.resize(result.offsets.back());
+        result.distances.resize(result.offsets.back());
+        parallel_for(0, blocks, [&](std::size_t b) {
+            const std::size_t first = result.offsets[b * kQueryGrain];
+            for (std::size_t j = 0; j < found[b].size(); ++j) {
+                result.vertices[first + j] = found[b][j].second;
+                result.distances[first + j] = std::sqrt(found[b][j].first);
+            }
+        }, 1);
+        return result;
+    }
+} // namespace halfMesh
@@ -0,0 +1,63 @@
+// test_async.cpp
+//
+// save_async and read_async report what actually happened: the bytes the
+// stream wrote or read, and Failed for writes cut short, missing or
+// unreadable files.
+
+#include "test_utilities.hpp"
+#include "triMesh.hpp"
+#include <filesystem>
+#include <string>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <csignal>
+#include <sys/resource.h>
+#define HALFMESH_TEST_RLIMIT 1
+#endif
+
+using namespace halfMesh;
+using test::data_file;
+using test::scratch_file;
+
+int main(int argc, char **argv) {
+    triMesh sphere;
+    sphere.read(data_file(argc, argv, "Sphere.stl"));
+
+    // a save and a read of the same file
+    const std::string obj = scratch_file("async.obj");
+    const IoResult saved = sphere.save_async(obj).get();
+    HALFMESH_CHECK(saved.status == IoStatus::Ok);
+    HALFMESH_CHECK(saved.bytes == std::filesystem::file_size(obj));
+    auto [loaded, read] = triMesh::read_async(obj).get();
+    HALFMESH_CHECK(read.status == IoStatus::Ok);
+    HALFMESH_CHECK(read.bytes == saved.bytes);
+    HALFMESH_CHECK(loaded.get_faces().size() == sphere.get_faces().size());
+
+    // unknown extension, directory that does not exist
+    HALFMESH_CHECK(sphere.save_async(scratch_file("async.xyz")).get().status == IoStatus::UnknownFormat);
+    HALFMESH_CHECK(sphere.save_async("no-such-directory/async.stl").get().status == IoStatus::Failed);
+
+    // write-only formats and missing files do not read as an empty mesh
+    const std::string vtk = scratch_file("async.vtk");
+    HALFMESH_CHECK(sphere.save_async(vtk).get().status == IoStatus::Ok);
+    auto [from_vtk, vtk_read] = triMesh::read_async(vtk).get();
+    HALFMESH_CHECK(vtk_read.status == IoStatus::Failed);
+    HALFMESH_CHECK(!vtk_read.message.empty());
+    HALFMESH_CHECK(from_vtk.get_faces().empty());
+    HALFMESH_CHECK(triMesh::read_async(scratch_file("async-missing.stl")).get().second.status == IoStatus::Failed);
+
+#ifdef HALFMESH_TEST_RLIMIT
+    // a write stopped by the file size limit fails, though a file is left
+    rlimit limit{};
+    getrlimit(RLIMIT_FSIZE, &limit);
+    const rlimit small{65536, limit.rlim_max};
+    std::signal(SIGXFSZ, SIG_IGN);
+    HALFMESH_CHECK(setrlimit(RLIMIT_FSIZE, &small) == 0);
+    const std::string stl = scratch_file("async-limited.stl");
+    const IoResult cut = sphere.save_async(stl).get();
+    setrlimit(RLIMIT_FSIZE, &limit);
+    HALFMESH_CHECK(cut.status == IoStatus::Failed);
+    HALFMESH_CHECK(std::filesystem::exists(stl));
+#endif
+    return 0;
+}
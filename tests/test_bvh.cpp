@@ -0,0 +1,194 @@
+// test_bvh.cpp
+//
+// face_bvh ray and closest point queries agree with a scan over every
+// face, after a build and after a refit, on a closed surface and on a
+// soup of scattered triangles.
+
+#include "face_bvh.hpp"
+#include "test_utilities.hpp"
+#include "triMesh.hpp"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+using namespace halfMesh;
+using test::data_file;
+
+namespace {
+    // Möller–Trumbore, the same test face_bvh runs per triangle
+    bool ray_triangle(const Eigen::Vector3d &a, const Eigen::Vector3d &b, const Eigen::Vector3d &c,
+                      const Ray &ray, double &t) {
+        const Eigen::Vector3d e1 = b - a, e2 = c - a, p = ray.direction.cross(e2);
+        const double det = e1.dot(p);
+        if (det == 0.0) return false;
+        const double inv = 1.0 / det;
+        const Eigen::Vector3d s = ray.origin - a;
+        const double u = s.dot(p) * inv;
+        if (u < 0.0 || u > 1.0) return false;
+        const Eigen::Vector3d q = s.cross(e1);
+        const double v = ray.direction.dot(q) * inv;
+        if (v < 0.0 || u + v > 1.0) return false;
+        t = e2.dot(q) * inv;
+        return t >= ray.t_min && t <= ray.t_max;
+    }
+
+    // Projection onto the plane if it lands inside, else the nearest edge point
+    Eigen::Vector3d closest_on_triangle(const Eigen::Vector3d &p, const Eigen::Vector3d &a,
+                                        const Eigen::Vector3d &b, const Eigen::Vector3d &c) {
+        const Eigen::Vector3d n = (b - a).cross(c - a);
+        const Eigen::Vector3d q = p - n.dot(p - a) / n.squaredNorm() * n;
+        if ((b - a).cross(q - a).dot(n) >= 0.0 && (c - b).cross(q - b).dot(n) >= 0.0 &&
+            (a - c).cross(q - c).dot(n) >= 0.0)
+            return q;
+        Eigen::Vector3d best = a;
+        for (const auto &[x, y]: {std::pair{a, b}, std::pair{b, c}, std::pair{c, a}}) {
+            const double t = std::clamp((p - x).dot(y - x) / (y - x).squaredNorm(), 0.0, 1.0);
+            const Eigen::Vector3d z = x + t * (y - x);
+            if ((z - p).squaredNorm() < (best - p).squaredNorm()) best = z;
+        }
+        return best;
+    }
+
+    // Random rays and points around the mesh against the brute force answers
+    void check_queries(const triMesh &mesh, const face_bvh &bvh, int queries, std::mt19937 &rng) {
+        std::uniform_real_distribution<double> uniform(-1.5, 1.5);
+        const Eigen::AlignedBox3d box = bvh.bounds();
+        const Eigen::Vector3d center = box.center();
+        const double scale = box.sizes().maxCoeff();
+        std::vector<std::array<Eigen::Vector3d, 3> > corners;
+        for (const auto &f: mesh.get_faces()) {
+            auto [a, b, c] = f->get_vertices();
+            corners.push_back({a->get_position(), b->get_position(), c->get_position()});
+        }
+        for (int q = 0; q < queries; ++q) {
+            Ray ray;
+            ray.origin = center + scale * Eigen::Vector3d(uniform(rng), uniform(rng), uniform(rng));
+            ray.direction = Eigen::Vector3d(uniform(rng), uniform(rng), uniform(rng));
+            if (q % 7 == 0) ray.direction = Eigen::Vector3d::UnitZ();
+            if (q % 11 == 0) ray.t_max = 0.3 * scale;
+
+            double best_t = std::numeric_limits<double>::infinity();
+            bool any = false;
+            for (const auto &[a, b, c]: corners) {
+                double t;
+                if (ray_triangle(a, b, c, ray, t)) {
+                    any = true;
+                    best_t = std::min(best_t, t);
+                }
+            }
+            const RayHit hit = bvh.intersect(ray);
+            HALFMESH_CHECK(hit.hit() == any);
+            HALFMESH_CHECK(!any || std::abs(hit.t - best_t) <= 1e-12 * scale);
+            HALFMESH_CHECK(bvh.occluded(ray) == any);
+
+            const Eigen::Vector3d p = center + scale * Eigen::Vector3d(uniform(rng), uniform(rng), uniform(rng));
+            double best_d = std::numeric_limits<double>::infinity();
+            for (const auto &[a, b, c]: corners) {
+                const Eigen::Vector3d z = closest_on_triangle(p, a, b, c);
+                best_d = std::min(best_d, (z - p).norm());
+            }
+            const ClosestPoint closest = bvh.closest_point(p);
+            HALFMESH_CHECK(std::abs(closest.distance - best_d) <= 1e-9 * scale);
+            HALFMESH_CHECK(std::abs((closest.point - p).norm() - closest.distance) <= 1e-9 * scale);
+            HALFMESH_CHECK(bvh.closest_point(p, 0.99 * best_d).face == std::numeric_limits<unsigned>::max());
+        }
+    }
+
+    // Batches give exactly the single ray answers: camera rays in scan
+    // order, which trace as packets, then scattered ones, which do not
+    void check_batches(const face_bvh &bvh, std::mt19937 &rng) {
+        std::uniform_real_distribution<double> uniform(-1.5, 1.5);
+        const Eigen::AlignedBox3d box = bvh.bounds();
+        const Eigen::Vector3d center = box.center();
+        const double scale = box.sizes().maxCoeff();
+        std::vector<Ray> rays;
+        const Eigen::Vector3d eye = center + scale * Eigen::Vector3d(0.4, -1.3, 0.7);
+        for (int y = 0; y < 61; ++y)
+            for (int x = 0; x < 67; ++x) {
+                Ray ray;
+                ray.origin = eye;
+                ray.direction = center - eye + scale * Eigen::Vector3d(x / 66.0 - 0.5, 0.1, y / 60.0 - 0.5);
+                if (y % 5 == 0) ray.t_max = 0.9 + 0.01 * x;
+                rays.push_back(ray);
+            }
+        for (int q = 0; q < 300; ++q) {
+            Ray ray;
+            ray.origin = center + scale * Eigen::Vector3d(uniform(rng), uniform(rng), uniform(rng));
+            ray.direction = Eigen::Vector3d(uniform(rng), uniform(rng), uniform(rng));
+            rays.push_back(ray);
+        }
+        const std::vector<RayHit> hits = bvh.intersect(rays);
+        const std::vector<std::uint8_t> blocked = bvh.occluded(rays);
+        HALFMESH_CHECK(hits.size() == rays.size() && blocked.size() == rays.size());
+        for (std::size_t i = 0; i < rays.size(); ++i) {
+            const RayHit single = bvh.intersect(rays[i]);
+            HALFMESH_CHECK(hits[i].face == single.face);
+            HALFMESH_CHECK(!single.hit() || (hits[i].t == single.t && hits[i].u == single.u && hits[i].v == single.v));
+            HALFMESH_CHECK((blocked[i] != 0) == bvh.occluded(rays[i]));
+        }
+    }
+}
+
+int main(int argc, char **argv) {
+    std::mt19937 rng(1);
+
+    // closed surface, then its vertices moved and the tree refitted
+    triMesh sphere;
+    sphere.read(data_file(argc, argv, "Sphere.stl"));
+    face_bvh bvh(sphere);
+    HALFMESH_CHECK(bvh.size() == sphere.get_faces().size());
+    check_queries(sphere, bvh, 100, rng);
+    check_batches(bvh, rng);
+
+    Eigen::MatrixXd V = sphere.positions_matrix();
+    for (Eigen::Index i = 0; i < V.rows(); ++i) V.row(i) *= 1.0 + 0.3 * std::sin(static_cast<double>(i));
+    sphere.set_positions(V);
+    bvh.refit(sphere);
+    check_batches(bvh, rng);
+    check_queries(sphere, bvh, 100, rng);
+    check_queries(sphere, face_bvh(sphere, 1), 50, rng);
+
+    // scattered triangles, a fifth of them on one plane, and a stack of
+    // coincident ones that no split can separate
+    std::vector<std::array<double, 3> > positions;
+    std::vector<std::array<unsigned, 3> > triangles;
+    std::uniform_real_distribution<double> place(0.0, 100.0), jitter(-1.0, 1.0);
+    for (unsigned i = 0; i < 2000; ++i) {
+        const double x = i % 5 == 0 ? 50.0 : place(rng), y = place(rng), z = place(rng);
+        const auto first = static_cast<unsigned>(positions.size());
+        for (int k = 0; k < 3; ++k) positions.push_back({x + jitter(rng), y + jitter(rng), z + jitter(rng)});
+        triangles.push_back({first, first + 1, first + 2});
+    }
+    for (unsigned i = 0; i < 50; ++i) {
+        const auto first = static_cast<unsigned>(positions.size());
+        positions.insert(positions.end(), {{0, 0, 0}, {1, 0, 0}, {0, 1, 0}});
+        triangles.push_back({first, first + 1, first + 2});
+    }
+    triMesh soup;
+    soup.build_from_arrays(positions, triangles);
+    const face_bvh soup_bvh(soup);
+    check_queries(soup, soup_bvh, 50, rng);
+    check_batches(soup_bvh, rng);
+
+    // a refit cannot follow topology changes
+    sphere.delete_face(sphere.get_faces().front());
+    bool threw = false;
+    try {
+        bvh.refit(sphere);
+    } catch (const std::runtime_error &) {
+        threw = true;
+    }
+    HALFMESH_CHECK(threw);
+
+    const face_bvh empty;
+    HALFMESH_CHECK(!empty.intersect(Ray()).hit());
+    HALFMESH_CHECK(!empty.occluded(Ray()));
+    HALFMESH_CHECK(!empty.intersect(std::vector<Ray>(3)).front().hit());
+    HALFMESH_CHECK(empty.closest_point(Eigen::Vector3d::Zero()).face == std::numeric_limits<unsigned>::max());
+    return 0;
+}
@@ -0,0 +1,165 @@
+// test_geometry.cpp
+//
+// Mass properties of boxes against their closed forms; the batch kernels
+// give the same bits on one thread or several and with the AVX2 kernels on
+// or off (the path a -DHALFMESH_SIMD=OFF build takes); tracked normals
+// after moving vertices equal a full recompute.
+
+#include "geometry_kernels.hpp"
+#include "task_scheduler.hpp"
+#include "test_utilities.hpp"
+#include "triMesh.hpp"
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+using namespace halfMesh;
+using test::data_file;
+
+namespace {
+    // Box [lo, lo + size] of twelve outward facing triangles
+    triMesh make_box(const Eigen::Vector3d &lo, const Eigen::Vector3d &size, bool inward = false) {
+        std::vector<std::array<double, 3> > positions;
+        for (int i = 0; i < 8; ++i)
+            positions.push_back({lo.x() + (i & 1) * size.x(), lo.y() + (i >> 1 & 1) * size.y(),
+                                 lo.z() + (i >> 2 & 1) * size.z()});
+        std::vector<std::array<unsigned, 3> > triangles = {
+            {0, 2, 3}, {0, 3, 1}, {4, 5, 7}, {4, 7, 6}, {0, 1, 5}, {0, 5, 4},
+            {2, 6, 7}, {2, 7, 3}, {0, 4, 6}, {0, 6, 2}, {1, 3, 7}, {1, 7, 5}
+        };
+        if (inward)
+            for (auto &t: triangles) std::swap(t[1], t[2]);
+        triMesh mesh;
+        mesh.build_from_arrays(positions, triangles);
+        return mesh;
+    }
+
+    void check_box(const Eigen::Vector3d &lo, const Eigen::Vector3d &size, bool inward) {
+        const triMesh box = make_box(lo, size, inward);
+        const double a = size.x(), b = size.y(), c = size.z(), mass = a * b * c;
+        const double tolerance = 1e-12 * (1 + lo.norm()) * (1 + lo.norm());
+        const MassProperties m = box.mass_properties();
+        HALFMESH_CHECK(std::abs(m.area - 2 * (a * b + b * c + a * c)) <= tolerance);
+        HALFMESH_CHECK(std::abs(m.volume - (inward ? -mass : mass)) <= tolerance);
+        HALFMESH_CHECK((m.centroid - (lo + size / 2)).norm() <= tolerance);
+        Eigen::Matrix3d inertia = Eigen::Matrix3d::Zero();
+        inertia.diagonal() << b * b + c * c, a * a + c * c, a * a + b * b;
+        inertia *= mass / 12;
+        HALFMESH_CHECK((m.inertia - inertia).norm() <= tolerance * mass);
+
+        HALFMESH_CHECK(box.volume() == m.volume);
+        HALFMESH_CHECK(box.surface_area() == m.area);
+        HALFMESH_CHECK(box.centroid() == m.centroid);
+        HALFMESH_CHECK(box.inertia_tensor() == m.inertia);
+    }
+
+    // Same bits, NaN matching NaN
+    bool same(const std::vector<double> &a, const std::vector<double> &b) {
+        return a.size() == b.size() && std::memcmp(a.data(), b.data(), a.size() * sizeof(double)) == 0;
+    }
+
+    std::vector<double> flatten(const std::vector<Eigen::Vector3d> &values) {
+        std::vector<double> out;
+        for (const auto &v: values) out.insert(out.end(), v.data(), v.data() + 3);
+        return out;
+    }
+
+    // Everything the batch kernels compute, flattened
+    std::vector<double> kernel_results(const triMesh &mesh) {
+        const MassProperties m = mesh.mass_properties();
+        std::vector<double> out = {m.area, m.volume, mesh.surface_area(), mesh.volume()};
+        out.insert(out.end(), m.centroid.data(), m.centroid.data() + 3);
+        out.insert(out.end(), m.inertia.data(), m.inertia.data() + 9);
+        const Eigen::AlignedBox3d box = mesh.axis_aligned_bounding_box();
+        out.insert(out.end(), box.min().data(), box.min().data() + 3);
+        out.insert(out.end(), box.max().data(), box.max().data() + 3);
+        const auto areas = mesh.compute_face_areas(), angles = mesh.compute_dihedral_angles();
+        const auto normals = flatten(mesh.compute_face_normals());
+        out.insert(out.end(), areas.begin(), areas.end());
+        out.insert(out.end(), angles.begin(), angles.end());
+        out.insert(out.end(), normals.begin(), normals.end());
+        return out;
+    }
+
+    std::vector<double> normal_column(const triMesh &mesh, bool faces) {
+        const auto column = faces
+                                ? mesh.get_face_property_column<std::array<double, 3> >("normal")
+                                : mesh.get_vertex_property_column<std::array<double, 3> >("normal");
+        std::vector<double> out;
+        for (const auto &n: column) out.insert(out.end(), n.begin(), n.end());
+        return out;
+    }
+}
+
+int main(int argc, char **argv) {
+    // closed forms: unit cube, an offset box either way round
+    check_box(Eigen::Vector3d::Zero(), Eigen::Vector3d::Ones(), false);
+    check_box(Eigen::Vector3d(100, -50, 7), Eigen::Vector3d(2, 3, 4), false);
+    check_box(Eigen::Vector3d(100, -50, 7), Eigen::Vector3d(2, 3, 4), true);
+
+    // copies of the sphere, enough faces for several batches, with an odd
+    // count so the kernels see a tail
+    triMesh sphere;
+    sphere.read(data_file(argc, argv, "Sphere.stl"));
+    const Eigen::MatrixXd V = sphere.positions_matrix();
+    const Eigen::MatrixXi F = sphere.faces_matrix();
+    std::vector<std::array<double, 3> > positions;
+    std::vector<std::array<unsigned, 3> > triangles;
+    for (int copy = 0; copy < 7; ++copy) {
+        const auto first = static_cast<unsigned>(positions.size());
+        for (Eigen::Index i = 0; i < V.rows(); ++i)
+            positions.push_back({V(i, 0) * (1 + 0.1 * copy) + 3.0 * copy, V(i, 1) - copy, V(i, 2)});
+        for (Eigen::Index i = 0; i + (copy == 6 ? 3 : 0) < F.rows(); ++i)
+            triangles.push_back({first + static_cast<unsigned>(F(i, 0)), first + static_cast<unsigned>(F(i, 1)),
+                                 first + static_cast<unsigned>(F(i, 2))});
+    }
+    triMesh scene;
+    scene.build_from_arrays(positions, triangles);
+
+    set_num_threads(1);
+    const std::vector<double> serial = kernel_results(scene);
+    set_num_threads(4);
+    HALFMESH_CHECK(same(kernel_results(scene), serial));
+    detail::enable_simd_kernels(false);
+    HALFMESH_CHECK(!detail::simd_kernels_active());
+    HALFMESH_CHECK(same(kernel_results(scene), serial));
+    set_num_threads(1);
+    HALFMESH_CHECK(same(kernel_results(scene), serial));
+    detail::enable_simd_kernels(true);
+    set_num_threads(0);
+
+    // tracked normals follow moved vertices like a full pass does, for
+    // each weighting
+    for (const NormalWeighting weighting: {NormalWeighting::Area, NormalWeighting::Angle, NormalWeighting::Uniform}) {
+        triMesh tracked(scene);
+        tracked.set_normal_tracking(true);
+        tracked.update_face_normals();
+        tracked.update_vertex_normals(weighting);
+        Eigen::MatrixXd moved = tracked.positions_matrix();
+        for (Eigen::Index i = 0; i < moved.rows(); i += 97) moved.row(i) *= 1.05;
+        tracked.set_positions(moved);
+        tracked.update_vertex_normals(weighting);
+
+        triMesh fresh(tracked);
+        fresh.set_normal_tracking(false);
+        fresh.update_face_normals();
+        fresh.update_vertex_normals(weighting);
+        HALFMESH_CHECK(same(normal_column(tracked, true), normal_column(fresh, true)));
+        HALFMESH_CHECK(same(normal_column(tracked, false), normal_column(fresh, false)));
+
+        // a single vertex moved through its own setter
+        auto v = tracked.get_vertices()[10];
+        v->set_x(v->get_x() + 0.01);
+        tracked.mark_geometry_changed();
+        tracked.update_vertex_normals(weighting);
+        triMesh again(tracked);
+        again.set_normal_tracking(false);
+        again.update_face_normals();
+        again.update_vertex_normals(weighting);
+        HALFMESH_CHECK(same(normal_column(tracked, true), normal_column(again, true)));
+        HALFMESH_CHECK(same(normal_column(tracked, false), normal_column(again, false)));
+    }
+    return 0;
+}
@@ -0,0 +1,128 @@
+// test_grid.cpp
+//
+// spatial_grid queries return exactly the items a scan over every vertex
+// or face box does, with directly addressed and with hashed cells.
+
+#include "spatial_grid.hpp"
+#include "test_utilities.hpp"
+#include "triMesh.hpp"
+#include <algorithm>
+#include <random>
+#include <utility>
+#include <vector>
+
+using namespace halfMesh;
+using test::data_file;
+
+namespace {
+    // Boxes of the grid's items (points for vertices) and their handles
+    std::vector<Eigen::AlignedBox3d> item_boxes(const triMesh &mesh, GridItems items,
+                                                std::vector<unsigned> &handles) {
+        std::vector<Eigen::AlignedBox3d> boxes;
+        handles.clear();
+        if (items == GridItems::Vertices) {
+            for (const auto &v: mesh.get_vertices()) {
+                boxes.emplace_back(v->get_position());
+                handles.push_back(v->get_handle());
+            }
+        } else {
+            for (const auto &f: mesh.get_faces()) {
+                auto [a, b, c] = f->get_vertices();
+                Eigen::AlignedBox3d box(a->get_position());
+                box.extend(b->get_position()).extend(c->get_position());
+                boxes.push_back(box);
+                handles.push_back(f->get_handle());
+            }
+        }
+        return boxes;
+    }
+
+    // neighbours, overlapping, cell_items and close_pairs against a scan;
+    // returns whether the grid was hashed
+    bool check_grid(const triMesh &mesh, GridItems items, double cell_size, double epsilon, std::mt19937 &rng) {
+        const spatial_grid grid(mesh, items, cell_size);
+        std::vector<unsigned> handles;
+        const auto boxes = item_boxes(mesh, items, handles);
+        HALFMESH_CHECK(grid.size() == boxes.size());
+
+        const Eigen::AlignedBox3d bounds = mesh.axis_aligned_bounding_box();
+        const Eigen::Vector3d center = bounds.center();
+        const double scale = bounds.sizes().maxCoeff();
+        std::uniform_real_distribution<double> uniform(-0.7, 0.7);
+        for (int q = 0; q < 100; ++q) {
+            // every third query sits exactly on an item
+            const std::size_t on = static_cast<std::size_t>(q) % boxes.size();
+            const Eigen::Vector3d p = q % 3 == 0
+                                          ? Eigen::Vector3d(boxes[on].min())
+                                          : Eigen::Vector3d(center + scale * Eigen::Vector3d(uniform(rng), uniform(rng),
+                                                                                             uniform(rng)));
+            std::vector<unsigned> expected;
+            for (std::size_t i = 0; i < boxes.size(); ++i)
+                if (boxes[i].squaredExteriorDistance(Eigen::AlignedBox3d(p)) <= epsilon * epsilon)
+                    expected.push_back(handles[i]);
+            std::sort(expected.begin(), expected.end());
+            HALFMESH_CHECK(grid.neighbours(p, epsilon) == expected);
+
+            Eigen::AlignedBox3d box(p);
+            box.extend(p + 0.2 * scale * Eigen::Vector3d(uniform(rng), uniform(rng), uniform(rng)));
+            expected.clear();
+            for (std::size_t i = 0; i < boxes.size(); ++i)
+                if (boxes[i].intersects(box)) expected.push_back(handles[i]);
+            std::sort(expected.begin(), expected.end());
+            HALFMESH_CHECK(grid.overlapping(box) == expected);
+
+            // a cell holds its own items and only items reaching into it
+            const auto in_cell = grid.cell_items(p);
+            HALFMESH_CHECK(std::is_sorted(in_cell.begin(), in_cell.end()));
+            for (const unsigned h: in_cell) {
+                const auto i = static_cast<std::size_t>(std::find(handles.begin(), handles.end(), h) - handles.begin());
+                HALFMESH_CHECK(i < boxes.size());
+                HALFMESH_CHECK(boxes[i].squaredExteriorDistance(Eigen::AlignedBox3d(p)) <=
+                               3.0 * grid.cell_size() * grid.cell_size());
+            }
+            if (q % 3 == 0 && items == GridItems::Vertices)
+                HALFMESH_CHECK(std::find(in_cell.begin(), in_cell.end(), handles[on]) != in_cell.end());
+        }
+
+        std::vector<std::pair<unsigned, unsigned> > pairs;
+        for (std::size_t i = 0; i < boxes.size(); ++i)
+            for (std::size_t j = i + 1; j < boxes.size(); ++j)
+                if (boxes[i].squaredExteriorDistance(boxes[j]) <= epsilon * epsilon)
+                    pairs.emplace_back(std::min(handles[i], handles[j]), std::max(handles[i], handles[j]));
+        std::sort(pairs.begin(), pairs.end());
+        HALFMESH_CHECK(grid.close_pairs(epsilon) == pairs);
+        return grid.hashed();
+    }
+}
+
+int main(int argc, char **argv) {
+    std::mt19937 rng(9);
+    triMesh sphere;
+    sphere.read(data_file(argc, argv, "Sphere.stl"));
+
+    // automatic, coarse and fine cells: 30^3 cells are too many to address
+    // directly for the sphere's items
+    HALFMESH_CHECK(!check_grid(sphere, GridItems::Vertices, 0.0, 2.0, rng));
+    HALFMESH_CHECK(!check_grid(sphere, GridItems::Faces, 0.0, 0.5, rng));
+    HALFMESH_CHECK(!check_grid(sphere, GridItems::Vertices, 1000.0, 5.0, rng));
+    const double fine = sphere.axis_aligned_bounding_box().sizes().maxCoeff() / 30;
+    HALFMESH_CHECK(check_grid(sphere, GridItems::Vertices, fine, 0.3, rng));
+    HALFMESH_CHECK(check_grid(sphere, GridItems::Faces, fine, 0.0, rng));
+
+    // a flat cloud with near duplicates
+    triMesh flat;
+    std::uniform_real_distribution<double> place(0.0, 10.0);
+    for (int i = 0; i < 2000; ++i) {
+        const double x = place(rng), y = place(rng);
+        flat.add_vertex(x, y, 0.0);
+        if (i % 7 == 0) flat.add_vertex(x + 1e-9, y, 0.0);
+    }
+    check_grid(flat, GridItems::Vertices, 0.0, 1e-6, rng);
+    check_grid(flat, GridItems::Vertices, 0.0, 0.2, rng);
+
+    const spatial_grid empty;
+    HALFMESH_CHECK(empty.neighbours(Eigen::Vector3d::Zero(), 1.0).empty());
+    HALFMESH_CHECK(empty.cell_items(Eigen::Vector3d::Zero()).empty());
+    HALFMESH_CHECK(empty.close_pairs(1.0).empty());
+    return 0;
+}
@@ -0,0 +1,92 @@
+// test_hmc.cpp
+//
+// Compressed .hmc files read back as the mesh that was saved: closed and
+// open surfaces go through Edgebreaker, non-manifold ones through the raw
+// body, and an empty mesh stays empty.
+
+#include "test_utilities.hpp"
+#include "triMesh.hpp"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <string>
+#include <vector>
+
+using namespace halfMesh;
+using test::data_file;
+using test::scratch_file;
+
+namespace {
+    // Enough bits that the quantisation error stays far below the spacing
+    // of the test meshes' vertices, so sorting is not thrown off by it
+    constexpr int kPositionBits = 30;
+
+    // Corner positions of every face, each face rotated to start at its
+    // smallest corner, sorted. Vertices come back in traversal order, so
+    // faces are compared by position rather than by index.
+    std::vector<std::array<double, 9> > face_corners(const triMesh &mesh) {
+        std::vector<std::array<double, 9> > faces;
+        const auto V = mesh.positions_matrix();
+        const auto F = mesh.faces_matrix();
+        for (Eigen::Index f = 0; f < F.rows(); ++f) {
+            std::array<std::array<double, 3>, 3> c;
+            for (int k = 0; k < 3; ++k) c[k] = {V(F(f, k), 0), V(F(f, k), 1), V(F(f, k), 2)};
+            std::rotate(c.begin(), std::min_element(c.begin(), c.end()), c.end());
+            std::array<double, 9> flat;
+            for (int k = 0; k < 9; ++k) flat[k] = c[k / 3][k % 3];
+            faces.push_back(flat);
+        }
+        std::sort(faces.begin(), faces.end());
+        return faces;
+    }
+
+    // Save as .hmc, read back, and compare counts, faces (with their
+    // orientation) and positions up to the quantisation step
+    void check_round_trip(const triMesh &mesh, const std::string &name) {
+        const std::string fn = scratch_file(name);
+        mesh.save_compressed(fn, kPositionBits);
+        triMesh decoded;
+        decoded.read(fn);
+        HALFMESH_CHECK(decoded.get_vertices().size() == mesh.get_vertices().size());
+        HALFMESH_CHECK(decoded.get_faces().size() == mesh.get_faces().size());
+        HALFMESH_CHECK(decoded.is_manifold() == mesh.is_manifold());
+
+        const auto expected = face_corners(mesh), actual = face_corners(decoded);
+        HALFMESH_CHECK(expected.size() == actual.size());
+        const double tolerance = mesh.get_vertices().empty()
+                                     ? 0.0
+                                     : 1e-6 * (mesh.positions_matrix().colwise().maxCoeff() -
+                                               mesh.positions_matrix().colwise().minCoeff()).maxCoeff();
+        for (std::size_t f = 0; f < expected.size(); ++f)
+            for (int k = 0; k < 9; ++k)
+                HALFMESH_CHECK(std::abs(expected[f][k] - actual[f][k]) <= tolerance);
+    }
+}
+
+int main(int argc, char **argv) {
+    // closed
+    triMesh sphere;
+    sphere.read(data_file(argc, argv, "Sphere.stl"));
+    HALFMESH_CHECK(!sphere.get_faces().empty());
+    check_round_trip(sphere, "hmc_closed.hmc");
+
+    // open: two holes
+    triMesh open;
+    open.read(data_file(argc, argv, "Sphere.stl"));
+    open.delete_face(open.get_faces().front());
+    open.delete_face(open.get_faces().back());
+    open.remove_unreferenced_vertices();
+    check_round_trip(open, "hmc_open.hmc");
+
+    // non-manifold: three triangles on one edge, and a bowtie vertex
+    triMesh fin;
+    fin.build_from_arrays({{0, 0, 0}, {1, 0, 0}, {0, 1, 0}, {0, -1, 0}, {0, 0, 1},
+                           {2, 1, 0}, {2, -1, 0}},
+                          {{0, 1, 2}, {1, 0, 3}, {0, 1, 4}, {1, 5, 6}});
+    HALFMESH_CHECK(!fin.is_manifold());
+    check_round_trip(fin, "hmc_non_manifold.hmc");
+
+    // empty
+    check_round_trip(triMesh(), "hmc_empty.hmc");
+    return 0;
+}
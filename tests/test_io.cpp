@@ -0,0 +1,275 @@
+// test_io.cpp
+//
+// OBJ and PLY files read into the expected mesh and property columns:
+// OBJ negative indices and v/vt/vn corner forms land on the half-edges,
+// PLY vertex and face properties come through in ASCII, little and big
+// endian binary (the constant-3 fast path included) and survive a write.
+// detect_mesh_format follows each of its magic byte rules.
+
+#include "test_utilities.hpp"
+#include "triMesh.hpp"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace halfMesh;
+using test::data_file;
+
+namespace {
+    std::vector<std::byte> bytes_of(const std::string &text) {
+        std::vector<std::byte> out(text.size());
+        std::memcpy(out.data(), text.data(), text.size());
+        return out;
+    }
+
+    MeshType detect(const std::string &text) {
+        const auto bytes = bytes_of(text);
+        return detect_mesh_format(bytes.data(), bytes.size());
+    }
+
+    triMesh read_text(const std::string &text, MeshType type = MeshType::Unknown) {
+        triMesh mesh;
+        mesh.read_from_memory(bytes_of(text), type);
+        return mesh;
+    }
+
+    // Faces as vertex handle triples, rotated to start at the smallest, sorted
+    std::vector<std::array<unsigned, 3> > face_list(const triMesh &mesh) {
+        std::vector<std::array<unsigned, 3> > faces;
+        for (const auto &f: mesh.get_faces()) {
+            auto [a, b, c] = f->get_vertices();
+            std::array<unsigned, 3> t = {a->get_handle(), b->get_handle(), c->get_handle()};
+            std::rotate(t.begin(), std::min_element(t.begin(), t.end()), t.end());
+            faces.push_back(t);
+        }
+        std::sort(faces.begin(), faces.end());
+        return faces;
+    }
+
+    // Face handle of the triangle with these corners, in any rotation
+    unsigned face_with(const triMesh &mesh, std::array<unsigned, 3> corners) {
+        std::rotate(corners.begin(), std::min_element(corners.begin(), corners.end()), corners.end());
+        for (const auto &f: mesh.get_faces()) {
+            auto [a, b, c] = f->get_vertices();
+            std::array<unsigned, 3> t = {a->get_handle(), b->get_handle(), c->get_handle()};
+            std::rotate(t.begin(), std::min_element(t.begin(), t.end()), t.end());
+            if (t == corners) return f->get_handle();
+        }
+        return std::numeric_limits<unsigned>::max();
+    }
+
+    void check_obj_corners() {
+        // two triangles by absolute and negative indices, a v//vn quad and a
+        // v/vt triangle that reaches back with a negative index
+        const triMesh mesh = read_text(
+            "# corner forms\n"
+            "v 0 0 0\nv 1 0 0\nv 1 1 0\nv 0 1 0\n"
+            "vt 0 0\nvt 1 0\nvt 1 1\nvt 0 1\n"
+            "vn 0 0 1\n"
+            "f 1/1/1 2/2/1 3/3/1\n"
+            "f -4/-4/-1 -2/-2/-1 -1/-1/-1\n"
+            "v 2 0 0\nv 2 1 0\n"
+            "f 2//1 5//1 6//1 3//1\n"
+            "v 0 -1 0\n"
+            "f 1/1 -1/2 2/2\n", MeshType::Obj);
+        HALFMESH_CHECK(mesh.get_vertices().size() == 7);
+        HALFMESH_CHECK(face_list(mesh) == (std::vector<std::array<unsigned, 3> >{
+            {0, 1, 2}, {0, 2, 3}, {0, 6, 1}, {1, 4, 5}, {1, 5, 2}}));
+
+        // texture coordinates follow the vertex where given; only the quad
+        // has none, only the last triangle has no normal
+        const std::map<unsigned, std::array<double, 2> > uv = {
+            {0, {0, 0}}, {1, {1, 0}}, {2, {1, 1}}, {3, {0, 1}}, {6, {1, 0}}};
+        const auto texcoords = mesh.get_half_edge_property_column<nlohmann::json>("texcoord");
+        const auto normals = mesh.get_half_edge_property_column<nlohmann::json>("normal");
+        int corners = 0;
+        for (const auto &f: mesh.get_faces()) {
+            auto [a, b, c] = f->get_vertices();
+            const auto has = [&](unsigned h) {
+                return a->get_handle() == h || b->get_handle() == h || c->get_handle() == h;
+            };
+            auto he = f->get_one_half_edge();
+            for (int k = 0; k < 3; ++k, he = he->next()) {
+                const unsigned from = he->get_vertex_one()->get_handle();
+                const auto &t = texcoords.at(he->get_handle());
+                const auto &n = normals.at(he->get_handle());
+                if (has(4) || has(5)) {
+                    HALFMESH_CHECK(t.is_null());
+                } else {
+                    HALFMESH_CHECK((t.get<std::array<double, 2> >() == uv.at(from)));
+                }
+                if (has(6)) {
+                    HALFMESH_CHECK(n.is_null());
+                } else {
+                    HALFMESH_CHECK((n.get<std::array<double, 3> >() == std::array<double, 3>{0, 0, 1}));
+                }
+                ++corners;
+            }
+        }
+        HALFMESH_CHECK(corners == 15);
+    }
+
+    // A grid written row by row, its faces by absolute or negative indices;
+    // large enough that the reader splits it into several chunks
+    std::string grid_obj(unsigned n, bool negative) {
+        std::string text;
+        for (unsigned j = 0; j < n; ++j) {
+            for (unsigned i = 0; i < n; ++i)
+                text += "v " + std::to_string(i) + " " + std::to_string(j) + " " + std::to_string((i * j) % 7) + "\n";
+            if (j == 0) continue;
+            for (unsigned i = 0; i + 1 < n; ++i) {
+                // corners (i, j - 1), (i + 1, j - 1), (i + 1, j), (i, j)
+                const long long below = negative ? static_cast<long long>(i) - 2 * n : (j - 1) * n + i + 1;
+                const long long here = negative ? static_cast<long long>(i) - n : j * n + i + 1;
+                text += "f " + std::to_string(below) + " " + std::to_string(below + 1) + " " +
+                        std::to_string(here + 1) + "\n";
+                text += "f " + std::to_string(below) + " " + std::to_string(here + 1) + " " + std::to_string(here) +
+                        "\n";
+            }
+        }
+        return text;
+    }
+
+    // — PLY —
+    template<typename T>
+    void put(std::string &out, T value, bool big_endian) {
+        char b[sizeof(T)];
+        std::memcpy(b, &value, sizeof(T));
+        if (big_endian) std::reverse(b, b + sizeof(T));
+        out.append(b, sizeof(T));
+    }
+
+    const std::vector<std::array<float, 3> > kPlyPositions = {{0, 0, 0}, {1, 0, 0}, {1, 1, 0}, {0, 1, 0}, {2, 0, 0}};
+    const std::vector<std::vector<unsigned> > kPlyFaces = {{0, 1, 2, 3}, {1, 4, 2}};
+
+    // The five vertices with float quality and uchar label columns; faces
+    // with an int flag column, or only their index lists (the fast path)
+    std::string ply_file(const std::string &format, bool face_flags) {
+        std::string out = "ply\nformat " + format + " 1.0\ncomment test\nelement vertex 5\n"
+                "property float x\nproperty float y\nproperty float z\n"
+                "property float quality\nproperty uchar label\n"
+                "element face 2\nproperty list uchar " + std::string(format == "ascii" ? "int" : "uint") +
+                " vertex_indices\n";
+        if (face_flags) out += "property int flag\n";
+        out += "end_header\n";
+        const bool ascii = format == "ascii", big = format == "binary_big_endian";
+        for (unsigned i = 0; i < kPlyPositions.size(); ++i) {
+            const auto &p = kPlyPositions[i];
+            if (ascii) {
+                for (float x: p) out += std::to_string(x) + " ";
+                out += std::to_string(i + 0.5) + " " + std::to_string(i + 1) + "\n";
+            } else {
+                for (float x: p) put(out, x, big);
+                put(out, static_cast<float>(i + 0.5), big);
+                put(out, static_cast<std::uint8_t>(i + 1), big);
+            }
+        }
+        for (unsigned f = 0; f < kPlyFaces.size(); ++f) {
+            const int flag = f == 0 ? -7 : 9;
+            if (ascii) {
+                out += std::to_string(kPlyFaces[f].size());
+                for (unsigned v: kPlyFaces[f]) out += " " + std::to_string(v);
+                if (face_flags) out += " " + std::to_string(flag);
+                out += "\n";
+            } else {
+                put(out, static_cast<std::uint8_t>(kPlyFaces[f].size()), big);
+                for (unsigned v: kPlyFaces[f]) put(out, static_cast<std::uint32_t>(v), big);
+                if (face_flags) put(out, static_cast<std::int32_t>(flag), big);
+            }
+        }
+        return out;
+    }
+
+    void check_ply(const triMesh &mesh, bool face_flags) {
+        HALFMESH_CHECK(mesh.get_vertices().size() == 5);
+        HALFMESH_CHECK(face_list(mesh) == (std::vector<std::array<unsigned, 3> >{{0, 1, 2}, {0, 2, 3}, {1, 4, 2}}));
+        for (const auto &v: mesh.get_vertices()) {
+            const unsigned h = v->get_handle();
+            HALFMESH_CHECK(v->get_x() == kPlyPositions[h][0] && v->get_y() == kPlyPositions[h][1] &&
+                v->get_z() == kPlyPositions[h][2]);
+            HALFMESH_CHECK(mesh.get_vertex_property<double>("quality", h) == h + 0.5);
+            HALFMESH_CHECK(mesh.get_vertex_property<double>("label", h) == h + 1);
+        }
+        if (!face_flags) return;
+        // both halves of the quad carry its flag
+        HALFMESH_CHECK(mesh.get_face_property<double>("flag", face_with(mesh, {0, 1, 2})) == -7);
+        HALFMESH_CHECK(mesh.get_face_property<double>("flag", face_with(mesh, {0, 2, 3})) == -7);
+        HALFMESH_CHECK(mesh.get_face_property<double>("flag", face_with(mesh, {1, 4, 2})) == 9);
+    }
+
+    // Binary STL of two triangles whose 80 byte header starts with "solid"
+    std::string binary_stl() {
+        std::string out = "solid but binary";
+        out.resize(80, ' ');
+        put(out, std::uint32_t(2), false);
+        const float triangles[2][9] = {{0, 0, 0, 1, 0, 0, 0, 1, 0}, {1, 0, 0, 1, 1, 0, 0, 1, 0}};
+        for (const auto &t: triangles) {
+            for (int k = 0; k < 3; ++k) put(out, 0.0f, false);
+            for (float x: t) put(out, x, false);
+            put(out, std::uint16_t(0), false);
+        }
+        return out;
+    }
+}
+
+int main(int argc, char **argv) {
+    // — OBJ —
+    check_obj_corners();
+    const unsigned n = 250;
+    const std::string absolute = grid_obj(n, false), negative = grid_obj(n, true);
+    HALFMESH_CHECK(negative.size() > (2u << 20));
+    const triMesh a = read_text(absolute, MeshType::Obj), b = read_text(negative, MeshType::Obj);
+    HALFMESH_CHECK(a.get_faces().size() == 2 * (n - 1) * (n - 1));
+    HALFMESH_CHECK(a.positions_matrix() == b.positions_matrix());
+    HALFMESH_CHECK(face_list(a) == face_list(b));
+    HALFMESH_CHECK(a.is_manifold() && a.compute_number_of_holes() == 1);
+
+    // — PLY —
+    for (const std::string format: {"ascii", "binary_little_endian", "binary_big_endian"})
+        for (const bool flags: {true, false}) {
+            const triMesh mesh = read_text(ply_file(format, flags));
+            check_ply(mesh, flags);
+            // and back through the binary writer
+            triMesh again;
+            again.read_from_memory(mesh.save_to_memory(MeshType::Ply), MeshType::Ply);
+            check_ply(again, flags);
+        }
+
+    // — Format detection —
+    HALFMESH_CHECK(detect("ply\nformat ascii 1.0\n") == MeshType::Ply);
+    HALFMESH_CHECK(detect("ply\r\nformat ascii 1.0\r\n") == MeshType::Ply);
+    HALFMESH_CHECK(detect("\n  $MeshFormat\n2.2 0 8\n") == MeshType::Gmsh);
+    HALFMESH_CHECK(detect(std::string("glTF\x02\0\0\0", 8)) == MeshType::Glb);
+    HALFMESH_CHECK(detect(std::string("HMC\x01", 4)) == MeshType::Compressed);
+    HALFMESH_CHECK(detect(std::string("HMC\x02", 4)) == MeshType::Unknown);
+    HALFMESH_CHECK(detect("# vtk DataFile Version 3.0\n") == MeshType::Vtk);
+    HALFMESH_CHECK(detect("solid part\n  facet normal 0 0 1\n") == MeshType::Stl);
+    HALFMESH_CHECK(detect("# exported\n\n# by hand\nv 0 0 0\n") == MeshType::Obj);
+    HALFMESH_CHECK(detect("mtllib parts.mtl\n") == MeshType::Obj);
+    HALFMESH_CHECK(detect("garbage") == MeshType::Unknown);
+    HALFMESH_CHECK(detect("") == MeshType::Unknown);
+
+    // a binary STL is told apart by its size, even with a "solid" header
+    const std::string stl = binary_stl();
+    HALFMESH_CHECK(detect(stl) == MeshType::Stl);
+    const triMesh square = read_text(stl);
+    HALFMESH_CHECK(square.get_faces().size() == 2);
+    HALFMESH_CHECK(square.get_vertices().size() == 4);
+    HALFMESH_CHECK(detect("part " + stl.substr(5)) == MeshType::Stl);
+
+    // and every format the library writes is recognised as itself
+    triMesh sphere;
+    sphere.read(data_file(argc, argv, "Sphere.stl"));
+    for (const MeshType type: {MeshType::Gmsh, MeshType::Stl, MeshType::Binary, MeshType::Vtk, MeshType::Obj,
+                               MeshType::Ply, MeshType::Glb, MeshType::Compressed}) {
+        const auto bytes = sphere.save_to_memory(type);
+        HALFMESH_CHECK(detect_mesh_format(bytes.data(), bytes.size()) == type);
+    }
+    return 0;
+}
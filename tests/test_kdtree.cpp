@@ -0,0 +1,133 @@
+// test_kdtree.cpp
+//
+// vertex_kdtree answers exactly what a scan over every vertex does, ties
+// going to the lower handle, after a build and through update().
+
+#include "test_utilities.hpp"
+#include "triMesh.hpp"
+#include "vertex_kdtree.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+using namespace halfMesh;
+using test::data_file;
+
+namespace {
+    // knn, radius_search and nearest for every row of Q against the sorted
+    // (squared distance, handle) list of all vertices
+    void check_queries(const triMesh &mesh, const vertex_kdtree &tree, const Eigen::MatrixXd &Q,
+                       std::size_t k, double radius) {
+        HALFMESH_CHECK(tree.size() == mesh.get_vertices().size());
+        const NearestVertices nearest = tree.knn(Q, k);
+        const VerticesInRadius within = tree.radius_search(Q, radius);
+        HALFMESH_CHECK(nearest.size() == static_cast<std::size_t>(Q.rows()));
+        HALFMESH_CHECK(within.size() == static_cast<std::size_t>(Q.rows()));
+        for (Eigen::Index q = 0; q < Q.rows(); ++q) {
+            const Eigen::Vector3d p = Q.row(q).transpose();
+            std::vector<std::pair<double, unsigned> > all;
+            for (const auto &v: mesh.get_vertices()) {
+                // summed in the tree's order, so ties compare the same way
+                const double x = p.x() - v->get_x(), y = p.y() - v->get_y(), z = p.z() - v->get_z();
+                all.emplace_back(x * x + y * y + z * z, v->get_handle());
+            }
+            std::sort(all.begin(), all.end());
+
+            for (std::size_t j = 0; j < k; ++j) {
+                const std::size_t at = static_cast<std::size_t>(q) * k + j;
+                if (j < all.size()) {
+                    HALFMESH_CHECK(nearest.vertices[at] == all[j].second);
+                    HALFMESH_CHECK(nearest.distances[at] == std::sqrt(all[j].first));
+                } else {
+                    HALFMESH_CHECK(nearest.vertices[at] == std::numeric_limits<unsigned>::max());
+                    HALFMESH_CHECK(std::isinf(nearest.distances[at]));
+                }
+            }
+
+            std::size_t at = within.offsets[q];
+            for (const auto &[d2, vertex]: all) {
+                if (d2 > radius * radius) break;
+                HALFMESH_CHECK(at < within.offsets[q + 1]);
+                HALFMESH_CHECK(within.vertices[at++] == vertex);
+            }
+            HALFMESH_CHECK(at == within.offsets[q + 1]);
+
+            double distance = 0.0;
+            const unsigned closest = tree.nearest(p, &distance);
+            HALFMESH_CHECK(all.empty() ? closest == std::numeric_limits<unsigned>::max()
+                                       : closest == all.front().second);
+            HALFMESH_CHECK(all.empty() || distance == std::sqrt(all.front().first));
+        }
+    }
+}
+
+int main(int argc, char **argv) {
+    std::mt19937 rng(5);
+    std::uniform_real_distribution<double> uniform(-1.2, 1.2);
+
+    // surface vertices, queries inside and around them
+    triMesh sphere;
+    sphere.read(data_file(argc, argv, "Sphere.stl"));
+    const double scale = sphere.positions_matrix().cwiseAbs().maxCoeff();
+    Eigen::MatrixXd Q(100, 3);
+    for (Eigen::Index i = 0; i < Q.rows(); ++i) Q.row(i) << uniform(rng), uniform(rng), uniform(rng);
+    Q *= scale;
+    vertex_kdtree tree(sphere);
+    check_queries(sphere, tree, Q, 7, 0.3 * scale);
+    // every vertex finds itself at radius zero
+    HALFMESH_CHECK(tree.radius_search(sphere.positions_matrix(), 0.0).vertices.size() ==
+                   sphere.get_vertices().size());
+
+    // a point cloud with repeated points and coordinates, large enough to
+    // build in parallel
+    triMesh cloud;
+    for (int i = 0; i < 20000; ++i) {
+        if (i % 10 == 0) cloud.add_vertex(1, 1, 1);
+        else cloud.add_vertex(uniform(rng), uniform(rng), std::round(uniform(rng) * 4) / 4);
+    }
+    Eigen::MatrixXd P(50, 3);
+    for (Eigen::Index i = 0; i < P.rows(); ++i) P.row(i) << uniform(rng), uniform(rng), uniform(rng);
+    P.row(0) << 1, 1, 1;
+    vertex_kdtree points(cloud);
+    check_queries(cloud, points, P, 12, 0.1);
+
+    // appended vertices wait in the tail, then get folded in
+    for (int i = 0; i < 50; ++i) cloud.add_vertex(uniform(rng), uniform(rng), uniform(rng));
+    points.update(cloud);
+    HALFMESH_CHECK(points.pending() == 50);
+    check_queries(cloud, points, P, 12, 0.1);
+    for (int i = 0; i < 3000; ++i) cloud.add_vertex(uniform(rng), uniform(rng), uniform(rng));
+    points.update(cloud);
+    HALFMESH_CHECK(points.pending() == 0);
+    check_queries(cloud, points, P, 12, 0.1);
+
+    // moved and removed vertices rebuild
+    Eigen::MatrixXd V = cloud.positions_matrix();
+    cloud.set_positions(0.5 * V);
+    points.update(cloud);
+    check_queries(cloud, points, P, 12, 0.1);
+    cloud.delete_vertex(cloud.get_vertices()[100]);
+    cloud.add_vertex(0, 0, 0);
+    points.update(cloud);
+    check_queries(cloud, points, P, 4, 0.1);
+
+    // fewer vertices than k pad the rows; an empty tree finds nothing
+    triMesh pair;
+    pair.add_vertex(0, 0, 0);
+    pair.add_vertex(1, 0, 0);
+    check_queries(pair, vertex_kdtree(pair), P, 5, 0.8);
+    check_queries(triMesh(), vertex_kdtree(), P, 3, 1.0);
+
+    bool threw = false;
+    try {
+        tree.knn(Eigen::MatrixXd(2, 2), 1);
+    } catch (const std::runtime_error &) {
+        threw = true;
+    }
+    HALFMESH_CHECK(threw);
+    return 0;
+}
@@ -0,0 +1,101 @@
+// test_stream.cpp
+//
+// Streaming conversion keeps the vertices an indexed file shares, only
+// STL input turns into a soup, and a failed conversion leaves no output.
+
+#include "mesh_stream.hpp"
+#include "test_utilities.hpp"
+#include "triMesh.hpp"
+#include <algorithm>
+#include <array>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <vector>
+
+using namespace halfMesh;
+using test::data_file;
+using test::scratch_file;
+
+namespace {
+    // Corner positions of every face, each face rotated to start at its
+    // smallest corner, sorted
+    std::vector<std::array<double, 9> > face_corners(const triMesh &mesh) {
+        std::vector<std::array<double, 9> > faces;
+        const auto V = mesh.positions_matrix();
+        const auto F = mesh.faces_matrix();
+        for (Eigen::Index f = 0; f < F.rows(); ++f) {
+            std::array<std::array<double, 3>, 3> c;
+            for (int k = 0; k < 3; ++k) c[k] = {V(F(f, k), 0), V(F(f, k), 1), V(F(f, k), 2)};
+            std::rotate(c.begin(), std::min_element(c.begin(), c.end()), c.end());
+            std::array<double, 9> flat;
+            for (int k = 0; k < 9; ++k) flat[k] = c[k / 3][k % 3];
+            faces.push_back(flat);
+        }
+        std::sort(faces.begin(), faces.end());
+        return faces;
+    }
+}
+
+int main(int argc, char **argv) {
+    triMesh sphere;
+    sphere.read(data_file(argc, argv, "Sphere.stl"));
+    const std::size_t V = sphere.get_vertices().size(), F = sphere.get_faces().size();
+
+    // indexed input: vertex and face counts, and the faces themselves, survive
+    const std::string obj = scratch_file("stream_sphere.obj");
+    const std::string ply = scratch_file("stream_sphere.ply");
+    sphere.save(obj);
+    const ConvertStats stats = convert_mesh(obj, ply);
+    HALFMESH_CHECK(stats.vertices == V);
+    HALFMESH_CHECK(stats.triangles == F);
+    triMesh converted;
+    converted.read(ply);
+    HALFMESH_CHECK(converted.get_vertices().size() == V);
+    HALFMESH_CHECK(converted.get_faces().size() == F);
+    triMesh source;
+    source.read(obj); // as written, with the OBJ writer's rounding
+    HALFMESH_CHECK(face_corners(converted) == face_corners(source));
+
+    // small chunks number shared vertices across chunk boundaries the same way
+    ConvertOptions small;
+    small.chunk_triangles = 7;
+    HALFMESH_CHECK(convert_mesh(obj, scratch_file("stream_sphere_small.ply"), small).vertices == V);
+
+    // STL stays a soup unless welded
+    const std::string stl_ply = scratch_file("stream_soup.ply");
+    HALFMESH_CHECK(convert_mesh(data_file(argc, argv, "Sphere.stl"), stl_ply).vertices == 3 * F);
+    ConvertOptions weld;
+    weld.weld = true;
+    HALFMESH_CHECK(convert_mesh(data_file(argc, argv, "Sphere.stl"), stl_ply, weld).vertices == V);
+
+    // a source failing after some chunks leaves no output, and an earlier
+    // output stays as it was
+    const std::string bad = scratch_file("stream_bad.obj");
+    {
+        std::ofstream out(bad);
+        out << "v 0 0 0\nv 1 0 0\nv 0 1 0\n";
+        for (int i = 0; i < 100; ++i) out << "f 1 2 3\n";
+        out << "f 1 2 9\n";
+    }
+    const std::string bad_stl = scratch_file("stream_bad.stl");
+    bool threw = false;
+    try {
+        convert_mesh(bad, bad_stl, small);
+    } catch (const std::runtime_error &) {
+        threw = true;
+    }
+    HALFMESH_CHECK(threw);
+    HALFMESH_CHECK(!std::filesystem::exists(bad_stl));
+    HALFMESH_CHECK(!std::filesystem::exists(bad_stl + ".tmp"));
+    const auto before = std::filesystem::file_size(stl_ply);
+    threw = false;
+    try {
+        convert_mesh(bad, stl_ply, small);
+    } catch (const std::runtime_error &) {
+        threw = true;
+    }
+    HALFMESH_CHECK(threw);
+    HALFMESH_CHECK(std::filesystem::file_size(stl_ply) == before);
+    return 0;
+}
@@ -0,0 +1,260 @@
+// test_topology.cpp
+//
+// Topology queries give the known answers for small meshes (open, closed,
+// non-manifold, flipped, edited), the memoised summary follows edits, and
+// component labels and split_components match a breadth-first search.
+
+#include "test_utilities.hpp"
+#include "triMesh.hpp"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <queue>
+#include <random>
+#include <tuple>
+#include <vector>
+
+using namespace halfMesh;
+using test::data_file;
+
+namespace {
+    struct Expected {
+        std::size_t vertices, edges, faces, boundary_edges, holes, components;
+        int genus;
+        bool edge_manifold, manifold, oriented;
+    };
+
+    // Every query against the known answer, through the summary and alone
+    void check_topology(const triMesh &mesh, const Expected &e) {
+        const TopologySummary s = mesh.topology_summary();
+        HALFMESH_CHECK(s.vertices == e.vertices);
+        HALFMESH_CHECK(s.edges == e.edges);
+        HALFMESH_CHECK(s.faces == e.faces);
+        HALFMESH_CHECK(s.boundary_edges == e.boundary_edges);
+        HALFMESH_CHECK(s.boundary_loops == e.holes);
+        HALFMESH_CHECK(s.components == e.components);
+        HALFMESH_CHECK(s.euler_characteristic ==
+            static_cast<int>(e.vertices) - static_cast<int>(e.edges) + static_cast<int>(e.faces));
+        HALFMESH_CHECK(s.genus == e.genus);
+        HALFMESH_CHECK(s.edge_manifold == e.edge_manifold);
+        HALFMESH_CHECK(s.manifold == e.manifold);
+        HALFMESH_CHECK(s.oriented == e.oriented);
+
+        HALFMESH_CHECK(mesh.compute_number_of_holes() == e.holes);
+        HALFMESH_CHECK(mesh.has_boundary() == (e.boundary_edges > 0));
+        HALFMESH_CHECK(mesh.euler_characteristic() == s.euler_characteristic);
+        HALFMESH_CHECK(mesh.genus() == e.genus);
+        HALFMESH_CHECK(mesh.num_connected_components() == e.components);
+        HALFMESH_CHECK(mesh.is_edge_manifold() == e.edge_manifold);
+        HALFMESH_CHECK(mesh.is_manifold() == e.manifold);
+        HALFMESH_CHECK(mesh.is_oriented() == e.oriented);
+
+        const ManifoldReport report = mesh.check_manifold();
+        HALFMESH_CHECK(report.edges == e.edges);
+        HALFMESH_CHECK(report.boundary_edges == e.boundary_edges);
+        HALFMESH_CHECK(report.manifold() == e.manifold);
+    }
+
+    // Mesh of the given corners and triangles, built face by face
+    triMesh make_mesh(const std::vector<std::array<double, 3> > &positions,
+                      const std::vector<std::array<unsigned, 3> > &triangles) {
+        triMesh mesh;
+        std::vector<vertexPtr> v;
+        for (const auto &p: positions) v.push_back(mesh.add_vertex(p[0], p[1], p[2]));
+        for (const auto &t: triangles) mesh.add_face(v[t[0]], v[t[1]], v[t[2]]);
+        mesh.complete_mesh();
+        return mesh;
+    }
+
+    const std::vector<std::array<double, 3> > kTetrahedron = {{0, 0, 0}, {1, 0, 0}, {0, 1, 0}, {0, 0, 1}};
+    const std::vector<std::array<unsigned, 3> > kTetrahedronFaces = {{0, 2, 1}, {0, 1, 3}, {0, 3, 2}, {1, 2, 3}};
+
+    // Torus of n x m quads split in two, plus the tetrahedron beside it
+    // when asked
+    triMesh make_torus(unsigned n, unsigned m, bool with_tetrahedron) {
+        std::vector<std::array<double, 3> > positions;
+        std::vector<std::array<unsigned, 3> > triangles;
+        for (unsigned i = 0; i < n; ++i)
+            for (unsigned j = 0; j < m; ++j) {
+                const double turn = 2 * std::acos(-1.0);
+                const double a = turn * i / n, b = turn * j / m;
+                positions.push_back({(3 + std::cos(b)) * std::cos(a), (3 + std::cos(b)) * std::sin(a), std::sin(b)});
+                const unsigned p = i * m + j, q = (i + 1) % n * m + j;
+                const unsigned r = (i + 1) % n * m + (j + 1) % m, s = i * m + (j + 1) % m;
+                triangles.push_back({p, q, r});
+                triangles.push_back({p, r, s});
+            }
+        if (with_tetrahedron) {
+            const auto first = static_cast<unsigned>(positions.size());
+            for (const auto &p: kTetrahedron) positions.push_back({p[0] + 10, p[1], p[2]});
+            for (const auto &t: kTetrahedronFaces) triangles.push_back({first + t[0], first + t[1], first + t[2]});
+        }
+        return make_mesh(positions, triangles);
+    }
+
+    // Component labels by a breadth-first search over the face corners,
+    // numbered in order of each component's lowest vertex handle
+    ComponentLabels search_components(const triMesh &mesh) {
+        constexpr unsigned none = std::numeric_limits<unsigned>::max();
+        unsigned vertex_slots = 0, face_slots = 0;
+        for (const auto &v: mesh.get_vertices()) vertex_slots = std::max(vertex_slots, v->get_handle() + 1);
+        for (const auto &f: mesh.get_faces()) face_slots = std::max(face_slots, f->get_handle() + 1);
+        std::vector<std::vector<unsigned> > neighbours(vertex_slots);
+        for (const auto &f: mesh.get_faces()) {
+            auto [a, b, c] = f->get_vertices();
+            const unsigned h[3] = {a->get_handle(), b->get_handle(), c->get_handle()};
+            for (int k = 0; k < 3; ++k) neighbours[h[k]].push_back(h[(k + 1) % 3]);
+            for (int k = 0; k < 3; ++k) neighbours[h[(k + 1) % 3]].push_back(h[k]);
+        }
+        std::vector<bool> present(vertex_slots, false);
+        for (const auto &v: mesh.get_vertices()) present[v->get_handle()] = true;
+
+        ComponentLabels out;
+        out.vertex_labels.assign(vertex_slots, none);
+        out.face_labels.assign(face_slots, none);
+        for (unsigned start = 0; start < vertex_slots; ++start) {
+            if (!present[start] || out.vertex_labels[start] != none) continue;
+            const auto label = static_cast<unsigned>(out.count++);
+            out.vertex_counts.push_back(0);
+            out.face_counts.push_back(0);
+            std::queue<unsigned> queue;
+            queue.push(start);
+            out.vertex_labels[start] = label;
+            while (!queue.empty()) {
+                const unsigned v = queue.front();
+                queue.pop();
+                ++out.vertex_counts[label];
+                for (unsigned w: neighbours[v])
+                    if (out.vertex_labels[w] == none) {
+                        out.vertex_labels[w] = label;
+                        queue.push(w);
+                    }
+            }
+        }
+        for (const auto &f: mesh.get_faces()) {
+            const unsigned label = out.vertex_labels[std::get<0>(f->get_vertices())->get_handle()];
+            out.face_labels[f->get_handle()] = label;
+            ++out.face_counts[label];
+        }
+        return out;
+    }
+
+    void check_components(triMesh &mesh) {
+        const ComponentLabels expected = search_components(mesh);
+        const ComponentLabels labels = mesh.connected_components();
+        HALFMESH_CHECK(labels.count == expected.count);
+        HALFMESH_CHECK(labels.vertex_counts == expected.vertex_counts);
+        HALFMESH_CHECK(labels.face_counts == expected.face_counts);
+        for (const auto &v: mesh.get_vertices())
+            HALFMESH_CHECK(labels.vertex_labels.at(v->get_handle()) == expected.vertex_labels[v->get_handle()]);
+        for (const auto &f: mesh.get_faces())
+            HALFMESH_CHECK(labels.face_labels.at(f->get_handle()) == expected.face_labels[f->get_handle()]);
+
+        // the property form writes the same labels
+        HALFMESH_CHECK(mesh.connected_components("component") == expected.count);
+        for (const auto &v: mesh.get_vertices())
+            HALFMESH_CHECK(mesh.get_vertex_property<int>("component", v->get_handle()) ==
+                static_cast<int>(expected.vertex_labels[v->get_handle()]));
+
+        // one mesh per component, with its vertices in handle order
+        const std::vector<triMesh> parts = mesh.split_components();
+        HALFMESH_CHECK(parts.size() == expected.count);
+        std::vector<std::vector<vertexPtr> > members(expected.count);
+        for (const auto &v: mesh.get_vertices()) members[expected.vertex_labels[v->get_handle()]].push_back(v);
+        for (std::size_t i = 0; i < parts.size(); ++i) {
+            HALFMESH_CHECK(parts[i].get_faces().size() == expected.face_counts[i]);
+            HALFMESH_CHECK(parts[i].get_vertices().size() == expected.vertex_counts[i]);
+            std::sort(members[i].begin(), members[i].end(), [](const vertexPtr &a, const vertexPtr &b) {
+                return a->get_handle() < b->get_handle();
+            });
+            const Eigen::MatrixXd V = parts[i].positions_matrix();
+            for (std::size_t j = 0; j < members[i].size(); ++j)
+                HALFMESH_CHECK(V.row(static_cast<Eigen::Index>(j)).transpose() == members[i][j]->get_position());
+            HALFMESH_CHECK(parts[i].num_connected_components() == 1);
+        }
+    }
+}
+
+int main(int argc, char **argv) {
+    // open square of two triangles: one hole
+    check_topology(make_mesh({{0, 0, 0}, {1, 0, 0}, {1, 1, 0}, {0, 1, 0}}, {{0, 1, 2}, {0, 2, 3}}),
+                   {4, 5, 2, 4, 1, 1, 0, true, true, true});
+
+    // two triangles meeting at one vertex: a single fan cannot cover it
+    const triMesh bowtie = make_mesh({{0, 0, 0}, {1, 0, 0}, {1, 1, 0}, {-1, 0, 0}, {-1, -1, 0}},
+                                     {{0, 1, 2}, {0, 3, 4}});
+    check_topology(bowtie, {5, 6, 2, 6, 2, 1, 0, true, false, true});
+    HALFMESH_CHECK(bowtie.check_manifold().non_manifold_vertices == std::vector<unsigned>{0});
+
+    // three faces on one edge
+    const triMesh fin = make_mesh({{0, 0, 0}, {1, 0, 0}, {0, 1, 0}, {0, -1, 0}, {0, 0, 1}},
+                                  {{0, 1, 2}, {1, 0, 3}, {0, 1, 4}});
+    HALFMESH_CHECK(!fin.is_edge_manifold());
+    HALFMESH_CHECK(fin.check_manifold().non_manifold_edges.size() == 1);
+    HALFMESH_CHECK(fin.topology_summary().edges == 7);
+    HALFMESH_CHECK(fin.topology_summary().boundary_edges == 6);
+    HALFMESH_CHECK(!fin.is_manifold());
+
+    // closed tetrahedron, then a face deleted and added back
+    triMesh tetrahedron = make_mesh(kTetrahedron, kTetrahedronFaces);
+    check_topology(tetrahedron, {4, 6, 4, 0, 0, 1, 0, true, true, true});
+    HALFMESH_CHECK(tetrahedron.topology_summary().watertight());
+    const auto corners = tetrahedron.get_faces().back()->get_vertices();
+    HALFMESH_CHECK(tetrahedron.delete_face(tetrahedron.get_faces().back()));
+    check_topology(tetrahedron, {4, 6, 3, 3, 1, 1, 0, true, true, true});
+    tetrahedron.add_face(std::get<0>(corners), std::get<1>(corners), std::get<2>(corners));
+    check_topology(tetrahedron, {4, 6, 4, 0, 0, 1, 0, true, true, true});
+
+    // one face flipped: no hole, but three edges run the same way twice
+    auto flipped_faces = kTetrahedronFaces;
+    std::swap(flipped_faces[3][1], flipped_faces[3][2]);
+    const triMesh flipped = make_mesh(kTetrahedron, flipped_faces);
+    check_topology(flipped, {4, 6, 4, 0, 0, 1, 0, true, true, false});
+    HALFMESH_CHECK(flipped.check_manifold().inconsistent_edges.size() == 3);
+
+    // genus one, and summed over components
+    check_topology(make_torus(8, 6, false), {48, 144, 96, 0, 0, 1, 1, true, true, true});
+    check_topology(make_torus(8, 6, true), {52, 150, 100, 0, 0, 2, 1, true, true, true});
+
+    // components: copies of the sphere, scattered triangles (some sharing
+    // a corner) and lone vertices
+    triMesh sphere;
+    sphere.read(data_file(argc, argv, "Sphere.stl"));
+    std::vector<std::array<double, 3> > positions;
+    std::vector<std::array<unsigned, 3> > triangles;
+    const Eigen::MatrixXd V = sphere.positions_matrix();
+    const Eigen::MatrixXi F = sphere.faces_matrix();
+    const double size = (V.colwise().maxCoeff() - V.colwise().minCoeff()).maxCoeff();
+    for (int copy = 0; copy < 3; ++copy) {
+        const auto first = static_cast<unsigned>(positions.size());
+        for (Eigen::Index i = 0; i < V.rows(); ++i)
+            positions.push_back({V(i, 0) + 2 * size * copy, V(i, 1), V(i, 2)});
+        for (Eigen::Index i = 0; i < F.rows(); ++i)
+            triangles.push_back({first + static_cast<unsigned>(F(i, 0)), first + static_cast<unsigned>(F(i, 1)),
+                                 first + static_cast<unsigned>(F(i, 2))});
+    }
+    std::mt19937 rng(3);
+    std::uniform_real_distribution<double> place(-size, 0.0);
+    for (int i = 0; i < 300; ++i) {
+        const auto first = static_cast<unsigned>(positions.size());
+        const double x = place(rng), y = place(rng), z = place(rng);
+        positions.insert(positions.end(), {{x + 1e-3, y, z}, {x, y + 1e-3, z}});
+        // every third triangle shares a corner with the one before it
+        if (i % 3 == 2) {
+            triangles.push_back({first - 1, first, first + 1});
+        } else {
+            positions.push_back({x, y, z});
+            triangles.push_back({first + 2, first, first + 1});
+        }
+    }
+    triMesh scene;
+    scene.build_from_arrays(positions, triangles);
+    for (int i = 0; i < 5; ++i) scene.add_vertex(-3 * size, i, 0);
+    check_components(scene);
+
+    // and again once faces are gone
+    for (int i = 0; i < 40; ++i) scene.delete_face(scene.get_faces()[static_cast<std::size_t>(i) * 50]);
+    check_components(scene);
+    return 0;
+}
@@ -0,0 +1,32 @@
+// test_utilities.hpp
+#pragma once
+
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <string>
+
+// Checks stay on in release builds, unlike assert; a failed check reports
+// and exits with status 1 for ctest
+#define HALFMESH_CHECK(condition)                                                   \
+    do {                                                                            \
+        if (!(condition)) {                                                         \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": check failed: "          \
+                      << #condition << std::endl;                                   \
+            std::exit(1);                                                           \
+        }                                                                           \
+    } while (false)
+
+namespace halfMesh::test {
+    // Bundled data directory, passed as the first argument by ctest
+    inline std::string data_file(int argc, char **argv, const std::string &name) {
+        const std::string dir = argc > 1 ? argv[1] : "../data";
+        return dir + "/" + name;
+    }
+
+    // Scratch file in the working directory, removed up front
+    inline std::string scratch_file(const std::string &name) {
+        std::filesystem::remove(name);
+        return name;
+    }
+} // namespace halfMesh::test
@@ -0,0 +1,343 @@
+// halfmesh_convert.cpp
+//
+// Batch conversion, welding and validation of mesh files:
+//
+//   halfmesh-convert [options] <file | directory | glob>...
+//
+// Files run in parallel on a bounded pool; the memory budget caps the
+// total input size in flight so a batch of large parts cannot exhaust RAM.
+// Every file reports its throughput, and the exit code is non-zero if any
+// file failed.
+
+#include "mesh_stream.hpp"
+#include "thread_pool.hpp"
+#include "triMesh.hpp"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace halfMesh;
+namespace fs = std::filesystem;
+
+namespace {
+    struct Options {
+        std::string format; // output extension without the dot, empty: no output
+        fs::path output_dir; // empty: next to the input
+        bool weld = false;
+        bool validate = false;
+        bool overwrite = false;
+        unsigned jobs = std::max(1u, std::thread::hardware_concurrency());
+        std::uintmax_t memory_budget = std::uintmax_t(1) << 30; // bytes of input in flight
+        std::size_t chunk_triangles = 1u << 16;
+        std::vector<std::string> inputs;
+    };
+
+    void usage(std::ostream &out) {
+        out << "usage: halfmesh-convert [options] <file | directory | glob>...\n"
+                "  -f, --format EXT        write EXT files (stl, obj, vtk, msh, ply, bm, glb, hmc)\n"
+                "  -o, --output-dir DIR    write outputs to DIR instead of next to the inputs\n"
+                "      --weld              merge corners with identical coordinates\n"
+                "      --validate          load each file and report its topology\n"
+                "      --overwrite         replace existing outputs\n"
+                "  -j, --jobs N            files converted at once (default: hardware threads)\n"
+                "      --memory-budget MB  input megabytes in flight at once (default: 1024)\n"
+                "      --chunk N           triangles per streamed chunk (default: 65536)\n"
+                "  -h, --help              show this help\n";
+    }
+
+    // '*' and '?' wildcards over a single path component
+    bool glob_match(const char *pattern, const char *name) {
+        if (*pattern == '\0') return *name == '\0';
+        if (*pattern == '*')
+            return glob_match(pattern + 1, name) || (*name != '\0' && glob_match(pattern, name + 1));
+        if (*name == '\0') return false;
+        return (*pattern == '?' || *pattern == *name) && glob_match(pattern + 1, name + 1);
+    }
+
+    // Formats triMesh::read understands; glTF and VTK are write-only
+    bool readable_input(MeshType t) {
+        return t == MeshType::Stl || t == MeshType::Obj || t == MeshType::Ply || t == MeshType::Gmsh ||
+               t == MeshType::Binary || t == MeshType::Compressed;
+    }
+
+    bool is_mesh_file(const fs::path &p) {
+        return fs::is_regular_file(p) && readable_input(guess_mesh_format(p.string()));
+    }
+
+    // Expand directories (their mesh files) and wildcards in the file name;
+    // shells on Windows leave globs to the program
+    std::vector<fs::path> expand_inputs(const std::vector<std::string> &inputs) {
+        std::vector<fs::path> files;
+        for (auto &input: inputs) {
+            const fs::path p(input);
+            const std::string name = p.filename().string();
+            if (name.find_first_of("*?") != std::string::npos) {
+                const fs::path dir = p.has_parent_path() ? p.parent_path() : fs::path(".");
+                std::vector<fs::path> matches;
+                std::error_code ec;
+                for (auto &entry: fs::directory_iterator(dir, ec))
+                    if (glob_match(name.c_str(), entry.path().filename().string().c_str()) && is_mesh_file(entry.path()))
+                        matches.push_back(entry.path());
+                if (matches.empty()) std::cerr << input << ": no matching mesh files\n";
+                std::sort(matches.begin(), matches.end());
+                files.insert(files.end(), matches.begin(), matches.end());
+            } else if (fs::is_directory(p)) {
+                std::vector<fs::path> matches;
+                std::error_code ec;
+                for (auto &entry: fs::directory_iterator(p, ec))
+                    if (is_mesh_file(entry.path())) matches.push_back(entry.path());
+                std::sort(matches.begin(), matches.end());
+                files.insert(files.end(), matches.begin(), matches.end());
+            } else {
+                files.push_back(p);
+            }
+        }
+        return files;
+    }
+
+    bool parse_options(int argc, char **argv, Options &options) {
+        for (int i = 1; i < argc; ++i) {
+            const std::string arg = argv[i];
+            const auto value = [&]() -> std::string {
+                if (i + 1 >= argc) throw std::invalid_argument(arg + " needs a value");
+                return argv[++i];
+            };
+            if (arg == "-h" || arg == "--help") {
+                usage(std::cout);
+                std::exit(0);
+            } else if (arg == "-f" || arg == "--format") {
+                options.format = to_lower(value());
+                if (!options.format.empty() && options.format[0] == '.') options.format.erase(0, 1);
+                if (guess_mesh_format("x." + options.format) == MeshType::Unknown)
+                    throw std::invalid_argument("unknown output format " + options.format);
+            } else if (arg == "-o" || arg == "--output-dir") {
+                options.output_dir = value();
+            } else if (arg == "--weld") {
+                options.weld = true;
+            } else if (arg == "--validate") {
+                options.validate = true;
+            } else if (arg == "--overwrite") {
+                options.overwrite = true;
+            } else if (arg == "-j" || arg == "--jobs") {
+                options.jobs = static_cast<unsigned>(std::max(1, std::stoi(value())));
+            } else if (arg == "--memory-budget") {
+                options.memory_budget = static_cast<std::uintmax_t>(std::max(1.0, std::stod(value())) * (1u << 20));
+            } else if (arg == "--chunk") {
+                options.chunk_triangles = static_cast<std::size_t>(std::max(1, std::stoi(value())));
+            } else if (!arg.empty() && arg[0] == '-') {
+                throw std::invalid_argument("unknown option " + arg);
+            } else {
+                options.inputs.push_back(arg);
+            }
+        }
+        return !options.inputs.empty() && (!options.format.empty() || options.validate);
+    }
+
+    // convert_mesh handles these without building connectivity
+    bool streamable_input(MeshType t) {
+        return t == MeshType::Stl || t == MeshType::Obj || t == MeshType::Ply || t == MeshType::Gmsh;
+    }
+
+    bool streamable_output(MeshType t) {
+        return streamable_input(t) || t == MeshType::Vtk;
+    }
+
+    // Merge vertices with identical coordinates, like ConvertOptions::weld
+    void weld(triMesh &mesh) {
+        const Eigen::MatrixXd V = mesh.positions_matrix();
+        const Eigen::MatrixXi F = mesh.faces_matrix();
+        std::map<std::array<double, 3>, unsigned> index;
+        std::vector<std::array<double, 3> > positions;
+        std::vector<unsigned> remap(static_cast<std::size_t>(V.rows()));
+        for (Eigen::Index i = 0; i < V.rows(); ++i) {
+            const std::array<double, 3> p{V(i, 0), V(i, 1), V(i, 2)};
+            const auto [it, added] = index.emplace(p, static_cast<unsigned>(positions.size()));
+            if (added) positions.push_back(p);
+            remap[static_cast<std::size_t>(i)] = it->second;
+        }
+        std::vector<std::array<unsigned, 3> > triangles(static_cast<std::size_t>(F.rows()));
+        for (Eigen::Index i = 0; i < F.rows(); ++i)
+            for (int k = 0; k < 3; ++k)
+                triangles[static_cast<std::size_t>(i)][k] = remap[static_cast<std::size_t>(F(i, k))];
+        mesh.build_from_arrays(positions, triangles);
+    }
+
+    // Removes the output on the way out unless kept, so a file that fails
+    // leaves nothing a rerun would refuse to replace
+    class output_guard {
+    public:
+        explicit output_guard(fs::path path) : path_(std::move(path)) {}
+
+        ~output_guard() {
+            if (path_.empty()) return;
+            std::error_code ec;
+            fs::remove(path_, ec);
+        }
+
+        void keep() { path_.clear(); }
+
+    private:
+        fs::path path_;
+    };
+
+    struct FileReport {
+        bool ok = true;
+        std::uint64_t faces = 0;
+        std::string detail;
+    };
+
+    FileReport process(const fs::path &input, const Options &options) {
+        FileReport report;
+        const MeshType input_type = guess_mesh_format(input.string());
+        // no extension is left to content detection in triMesh::read
+        if (input_type != MeshType::Unknown && !readable_input(input_type))
+            throw std::runtime_error("cannot read this format");
+        fs::path output;
+        if (!options.format.empty()) {
+            output = (options.output_dir.empty() ? input.parent_path() : options.output_dir) /
+                     input.stem().concat("." + options.format);
+            std::error_code ec;
+            if (fs::equivalent(input, output, ec))
+                throw std::runtime_error("output would replace the input");
+            if (!options.overwrite && fs::exists(output))
+                throw std::runtime_error(output.string() + " exists (use --overwrite)");
+        }
+        const MeshType output_type = guess_mesh_format(output.string());
+
+        std::ostringstream detail;
+        output_guard written(output);
+        if (!options.validate && streamable_input(input_type) && streamable_output(output_type)) {
+            ConvertOptions convert;
+            convert.chunk_triangles = options.chunk_triangles;
+            convert.weld = options.weld;
+            const auto stats = convert_mesh(input.string(), output.string(), convert);
+            if (stats.triangles == 0) throw std::runtime_error("no triangles read");
+            report.faces = stats.triangles;
+            detail << "-> " << output.string() << " (" << stats.vertices << " vertices)";
+        } else {
+            triMesh mesh;
+            mesh.read(input.string());
+            // read reports unreadable or malformed files on stderr and leaves the mesh empty
+            if (mesh.get_faces().empty()) throw std::runtime_error("no faces read");
+            if (options.weld) weld(mesh);
+            report.faces = mesh.get_faces().size();
+            if (options.validate) {
+                const ManifoldReport check = mesh.check_manifold();
+                detail << mesh.get_vertices().size() << " vertices, ";
+                if (check.manifold()) detail << "manifold";
+                else
+                    detail << "NOT manifold (" << check.non_manifold_edges.size() << " edges, "
+                            << check.non_manifold_vertices.size() << " vertices)";
+                if (!check.oriented) detail << ", " << check.inconsistent_edges.size() << " flipped edges";
+                detail << ", " << mesh.compute_number_of_holes() << " holes, "
+                        << mesh.num_connected_components() << " components";
+                report.ok = check.manifold();
+            }
+            if (!output.empty()) {
+                // the async save checks the stream, so a short write fails
+                const IoResult saved = triMesh::save_async(std::move(mesh), output.string()).get();
+                if (saved.status != IoStatus::Ok) throw std::runtime_error(saved.message);
+                detail << (options.validate ? " " : "") << "-> " << output.string();
+            }
+        }
+        written.keep();
+        report.detail = detail.str();
+        return report;
+    }
+
+    std::string throughput(std::uintmax_t bytes, std::uint64_t faces, double seconds) {
+        char buf[128];
+        const double s = std::max(seconds, 1e-9);
+        std::snprintf(buf, sizeof(buf), "%.2f MB in %.3f s, %.1f MB/s, %.0f faces/s",
+                      static_cast<double>(bytes) / 1e6, seconds, static_cast<double>(bytes) / 1e6 / s,
+                      static_cast<double>(faces) / s);
+        return buf;
+    }
+}
+
+int main(int argc, char **argv) {
+    Options options;
+    try {
+        if (!parse_options(argc, argv, options)) {
+            usage(std::cerr);
+            return 2;
+        }
+    } catch (const std::exception &e) {
+        std::cerr << "halfmesh-convert: " << e.what() << "\n";
+        return 2;
+    }
+    const auto files = expand_inputs(options.inputs);
+    if (files.empty()) {
+        std::cerr << "halfmesh-convert: no input files\n";
+        return 1;
+    }
+    if (!options.output_dir.empty()) fs::create_directories(options.output_dir);
+
+    // at most `jobs` files and `memory_budget` input bytes in flight; a file
+    // larger than the budget runs on its own
+    std::mutex mutex;
+    std::condition_variable done;
+    unsigned running = 0;
+    std::uintmax_t in_flight = 0, total_bytes = 0;
+    std::uint64_t total_faces = 0;
+    std::size_t failed = 0;
+
+    const auto start = std::chrono::steady_clock::now();
+    {
+        thread_pool pool(options.jobs);
+        for (auto &file: files) {
+            std::error_code ec;
+            const std::uintmax_t bytes = fs::file_size(file, ec);
+            const std::uintmax_t cost = ec ? 0 : bytes;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                done.wait(lock, [&] {
+                    return running == 0 || (running < options.jobs && in_flight + cost <= options.memory_budget);
+                });
+                ++running;
+                in_flight += cost;
+            }
+            pool.submit([&, file, cost] {
+                const auto t0 = std::chrono::steady_clock::now();
+                FileReport report;
+                std::string error;
+                try {
+                    report = process(file, options);
+                } catch (const std::exception &e) {
+                    report.ok = false;
+                    error = e.what();
+                }
+                const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+                std::lock_guard<std::mutex> lock(mutex);
+                if (error.empty()) {
+                    std::cout << file.string() << ": " << report.faces << " faces, "
+                            << throughput(cost, report.faces, seconds) << " " << report.detail << "\n";
+                    total_faces += report.faces;
+                    total_bytes += cost;
+                } else {
+                    std::cerr << file.string() << ": " << error << "\n";
+                }
+                if (!report.ok) ++failed;
+                --running;
+                in_flight -= cost;
+                done.notify_all();
+            });
+        }
+    }
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << files.size() << " files, " << failed << " failed, " << total_faces << " faces, "
+            << throughput(total_bytes, total_faces, seconds) << "\n";
+    return failed == 0 ? 0 : 1;
+}